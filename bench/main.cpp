@@ -0,0 +1,184 @@
+/*
+ * File:   main.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 7:30 PM
+ */
+
+// bench:  microbenchmarks for the server's inner loops, run on synthetic data.
+//   name kernels:  dns::scalar against dns:: (SSE2, or AVX2 when built with
+//   'make CONF=Release CXXFLAGS=-mavx2'), checking both give the same results.
+// With -p:  the queries of a capture replayed through the server's query path
+//   instead, in process or (-l) over loopback to a server_udp, see replay.h.
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include <getopt.h>
+
+#include "dns.h"
+#include "name_kernels.h"
+#include "replay.h"
+
+namespace {
+
+  typedef std::vector<uint8_t> name_t;
+
+  // wire format names shaped like real queries:  2 to 5 labels of 1 to 20
+  //   octets, some longer ones, mixed case (0x20 randomization)
+  std::vector<name_t> MakeNames( std::size_t nNames, unsigned seed ) {
+    std::mt19937 rng( seed );
+    const char* szChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-";
+    std::vector<name_t> vName( nNames );
+    for ( name_t& name: vName ) {
+      const unsigned nLabels = 2 + rng() % 4;
+      for ( unsigned ix = 0; ix < nLabels; ix++ ) {
+        const unsigned len = ( 0 == rng() % 8 ) ? 21 + rng() % 43 : 1 + rng() % 20;
+        if ( dns::max_name_length < name.size() + 1 + len + 1 ) break;
+        name.push_back( len );
+        for ( unsigned ixChar = 0; ixChar < len; ixChar++ ) name.push_back( szChars[ rng() % 63 ] );
+      }
+      name.push_back( 0 );
+    }
+    return vName;
+  }
+
+  template<typename Function>
+  double NanosecondsPerName( const std::vector<name_t>& vName, unsigned nRounds, Function f ) {
+    const auto start = std::chrono::steady_clock::now();
+    for ( unsigned ixRound = 0; ixRound < nRounds; ixRound++ ) {
+      for ( const name_t& name: vName ) f( name );
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>( elapsed ).count() / ( double( nRounds ) * vName.size() );
+  }
+
+  void Report( const char* szKernel, double nsScalar, double nsVector ) {
+    std::cout
+      << std::left << std::setw( 14 ) << szKernel << std::right << std::fixed << std::setprecision( 2 )
+      << std::setw( 10 ) << nsScalar
+      << std::setw( 10 ) << nsVector
+      << std::setw( 9 ) << ( nsScalar / nsVector ) << "x" << std::endl;
+  }
+
+  volatile uint64_t sink; // keeps results alive
+
+} // namespace anonymous
+
+int main( int argc, char* argv[] ) {
+
+  std::size_t nNames( 100000 );
+  unsigned nRounds( 50 );
+  unsigned seed( 1 );
+
+  replay_options options;
+  bool bRounds( false );
+
+  const char* szUsage =
+    "Usage: bench [-n <names>] [-r <rounds>] [-s <seed>]\n"
+    "       bench -p <pcap> [-P <capture port>] [-z <zone image>] [-r <rounds>] [-t] [-e <udp payload>]\n"
+    "             [-l <loopback port> [-b <batch>] [-i] [-c <outstanding>]]";
+  int opt;
+  while ( -1 != ( opt = getopt( argc, argv, "n:r:s:p:P:z:tl:b:ic:e:" ) ) ) {
+    switch ( opt ) {
+      case 'n': nNames = std::max( 1, std::atoi( optarg ) ); break;
+      case 'r': nRounds = std::max( 1, std::atoi( optarg ) ); bRounds = true; break;
+      case 's': seed = std::atoi( optarg ); break;
+      case 'p': options.sPcap = optarg; break;
+      case 'P': options.portCapture = static_cast<uint16_t>( std::atoi( optarg ) ); break;
+      case 'z': options.sZoneImage = optarg; break;
+      case 't': options.bTcp = true; break;
+      case 'l': options.portLoopback = static_cast<unsigned short>( std::atoi( optarg ) ); break;
+      case 'b': options.nBatch = std::max( 1, std::atoi( optarg ) ); break;
+      case 'i': options.bUring = true; break;
+      case 'c': options.nOutstanding = std::max( 1, std::atoi( optarg ) ); break;
+      case 'e': options.nUdpPayload = static_cast<uint16_t>( std::max( 512, std::min( 65535, std::atoi( optarg ) ) ) ); break;
+      default:
+        std::cerr << szUsage << std::endl;
+        return 1;
+    }
+  }
+
+  if ( !options.sPcap.empty() ) {
+    if ( options.bTcp && ( 0 != options.portLoopback ) ) {
+      std::cerr << "tcp replays in process only" << std::endl;
+      return 1;
+    }
+    if ( bRounds ) options.nRounds = nRounds;
+    return Replay( options );
+  }
+
+  const std::vector<name_t> vName( MakeNames( nNames, seed ) );
+  std::vector<name_t> vUpper( vName ); // same names, other case, for comparison
+  for ( name_t& name: vUpper ) {
+    for ( uint8_t& octet: name ) if ( ( 'a' <= octet ) && ( 'z' >= octet ) ) octet -= 'a' - 'A';
+  }
+
+  // same answers first
+  std::size_t nMismatch( 0 );
+  for ( std::size_t ix = 0; ix < vName.size(); ix++ ) {
+    const name_t& name( vName[ ix ] );
+    uint8_t bufScalar[ dns::max_name_length ];
+    uint8_t bufVector[ dns::max_name_length ];
+    uint64_t hashScalar, hashVector;
+    const std::size_t lenScalar = dns::scalar::canonical( name.data(), name.size(), bufScalar, hashScalar );
+    const std::size_t lenVector = dns::canonical( name.data(), name.size(), bufVector, hashVector );
+    if ( ( lenScalar != name.size() ) || ( lenScalar != lenVector ) || ( hashScalar != hashVector )
+      || ( 0 != std::memcmp( bufScalar, bufVector, lenScalar ) )
+      || !dns::equal_nocase( name.data(), vUpper[ ix ].data(), name.size() )
+      || ( dns::hash( bufVector, lenVector ) != hashVector )
+    ) {
+      nMismatch++;
+    }
+  }
+  if ( 0 != nMismatch ) {
+    std::cerr << nMismatch << " name(s) where the kernels disagree" << std::endl;
+    return 1;
+  }
+
+  std::size_t lenTotal( 0 );
+  for ( const name_t& name: vName ) lenTotal += name.size();
+  std::cout
+    << vName.size() << " names, " << double( lenTotal ) / vName.size() << " octets on average, "
+    << nRounds << " rounds, "
+#if defined( __AVX2__ )
+    << "avx2"
+#elif defined( __SSE2__ )
+    << "sse2"
+#else
+    << "scalar only"
+#endif
+    << std::endl;
+  std::cout << "kernel        ns/name scalar   vector  speedup" << std::endl;
+
+  uint8_t buf[ dns::max_name_length ];
+
+  Report( "lower",
+    NanosecondsPerName( vName, nRounds, [&buf]( const name_t& name ){
+      dns::scalar::lower( name.data(), name.size(), buf ); sink = buf[ 1 ]; } ),
+    NanosecondsPerName( vName, nRounds, [&buf]( const name_t& name ){
+      dns::lower( name.data(), name.size(), buf ); sink = buf[ 1 ]; } ) );
+
+  std::size_t ix( 0 );
+  Report( "equal_nocase",
+    NanosecondsPerName( vName, nRounds, [&vUpper, &ix]( const name_t& name ){
+      sink = dns::scalar::equal_nocase( name.data(), vUpper[ ix++ % vUpper.size() ].data(), name.size() ); } ),
+    NanosecondsPerName( vName, nRounds, [&vUpper, &ix]( const name_t& name ){
+      sink = dns::equal_nocase( name.data(), vUpper[ ix++ % vUpper.size() ].data(), name.size() ); } ) );
+
+  Report( "canonical",
+    NanosecondsPerName( vName, nRounds, [&buf]( const name_t& name ){
+      uint64_t hash; dns::scalar::canonical( name.data(), name.size(), buf, hash ); sink = hash; } ),
+    NanosecondsPerName( vName, nRounds, [&buf]( const name_t& name ){
+      uint64_t hash; dns::canonical( name.data(), name.size(), buf, hash ); sink = hash; } ) );
+
+  return 0;
+}
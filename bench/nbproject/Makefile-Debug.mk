@@ -0,0 +1,183 @@
+#
+# Generated Makefile - do not edit!
+#
+# Edit the Makefile in the project folder instead (../Makefile). Each target
+# has a -pre and a -post target defined where you can add customized code.
+#
+# This makefile implements configuration specific macros and targets.
+
+
+# Environment
+MKDIR=mkdir
+CP=cp
+GREP=grep
+NM=nm
+CCADMIN=CCadmin
+RANLIB=ranlib
+CC=gcc
+CCC=g++
+CXX=g++
+FC=gfortran
+AS=as
+
+# Macros
+CND_PLATFORM=GNU-Linux
+CND_DLIB_EXT=so
+CND_CONF=Debug
+CND_DISTDIR=dist
+CND_BUILDDIR=build
+
+# Include project Makefile
+include Makefile
+
+# Object Directory
+OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
+
+# Object Files
+OBJECTFILES= \
+	${OBJECTDIR}/_ext/5c0/allocations.o \
+	${OBJECTDIR}/_ext/5c0/answer_cache.o \
+	${OBJECTDIR}/_ext/5c0/dns_build.o \
+	${OBJECTDIR}/_ext/5c0/dns_parse.o \
+	${OBJECTDIR}/_ext/5c0/forwarder.o \
+	${OBJECTDIR}/_ext/5c0/logger.o \
+	${OBJECTDIR}/_ext/5c0/metrics.o \
+	${OBJECTDIR}/_ext/5c0/name_kernels.o \
+	${OBJECTDIR}/_ext/5c0/query_log.o \
+	${OBJECTDIR}/_ext/5c0/responder.o \
+	${OBJECTDIR}/_ext/5c0/rrl.o \
+	${OBJECTDIR}/_ext/5c0/server_udp.o \
+	${OBJECTDIR}/_ext/5c0/uring.o \
+	${OBJECTDIR}/_ext/5c0/zone_image.o \
+	${OBJECTDIR}/main.o \
+	${OBJECTDIR}/pcap.o \
+	${OBJECTDIR}/replay.o
+
+
+# C Compiler Flags
+CFLAGS=
+
+# CC Compiler Flags
+CCFLAGS=-m64
+CXXFLAGS=-m64
+
+# Fortran Compiler Flags
+FFLAGS=
+
+# Assembler Flags
+ASFLAGS=
+
+# Link Libraries and Options
+LDLIBSOPTIONS=-lpthread
+
+# Build Targets
+.build-conf: ${BUILD_SUBPROJECTS}
+	"${MAKE}"  -f nbproject/Makefile-${CND_CONF}.mk ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/bench
+
+${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/bench: /usr/local/lib/libboost_system-mt.so
+
+${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/bench: ${OBJECTFILES}
+	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
+	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/bench ${OBJECTFILES} ${LDLIBSOPTIONS}
+
+${OBJECTDIR}/_ext/5c0/allocations.o: ../server/allocations.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/allocations.o ../server/allocations.cpp
+
+${OBJECTDIR}/_ext/5c0/answer_cache.o: ../server/answer_cache.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/answer_cache.o ../server/answer_cache.cpp
+
+${OBJECTDIR}/_ext/5c0/dns_build.o: ../server/dns_build.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/dns_build.o ../server/dns_build.cpp
+
+${OBJECTDIR}/_ext/5c0/dns_parse.o: ../server/dns_parse.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/dns_parse.o ../server/dns_parse.cpp
+
+${OBJECTDIR}/_ext/5c0/forwarder.o: ../server/forwarder.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/forwarder.o ../server/forwarder.cpp
+
+${OBJECTDIR}/_ext/5c0/logger.o: ../server/logger.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/logger.o ../server/logger.cpp
+
+${OBJECTDIR}/_ext/5c0/metrics.o: ../server/metrics.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/metrics.o ../server/metrics.cpp
+
+${OBJECTDIR}/_ext/5c0/name_kernels.o: ../server/name_kernels.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/name_kernels.o ../server/name_kernels.cpp
+
+${OBJECTDIR}/_ext/5c0/query_log.o: ../server/query_log.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/query_log.o ../server/query_log.cpp
+
+${OBJECTDIR}/_ext/5c0/responder.o: ../server/responder.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/responder.o ../server/responder.cpp
+
+${OBJECTDIR}/_ext/5c0/rrl.o: ../server/rrl.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/rrl.o ../server/rrl.cpp
+
+${OBJECTDIR}/_ext/5c0/server_udp.o: ../server/server_udp.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/server_udp.o ../server/server_udp.cpp
+
+${OBJECTDIR}/_ext/5c0/uring.o: ../server/uring.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/uring.o ../server/uring.cpp
+
+${OBJECTDIR}/_ext/5c0/zone_image.o: ../server/zone_image.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/5c0
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/5c0/zone_image.o ../server/zone_image.cpp
+
+${OBJECTDIR}/main.o: main.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+
+${OBJECTDIR}/pcap.o: pcap.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/pcap.o pcap.cpp
+
+${OBJECTDIR}/replay.o: replay.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -DRESPONDER_STAGE_TIMES -I/usr/local/include -I../server -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/replay.o replay.cpp
+
+# Subprojects
+.build-subprojects:
+
+# Clean Targets
+.clean-conf: ${CLEAN_SUBPROJECTS}
+	${RM} -r ${CND_BUILDDIR}/${CND_CONF}
+	${RM} -r ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libboost_system-mt.so
+	${RM} ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/bench
+
+# Subprojects
+.clean-subprojects:
+
+# Enable dependency checking
+.dep.inc: .depcheck-impl
+
+include .dep.inc
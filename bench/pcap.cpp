@@ -0,0 +1,181 @@
+/*
+ * File:   pcap.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 23, 2026, 3:40 PM
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "pcap.h"
+
+namespace {
+
+  // https://wiki.wireshark.org/Development/LibpcapFileFormat
+  enum : uint32_t {
+    magic_us = 0xa1b2c3d4,
+    magic_ns = 0xa1b23c4d
+  };
+
+  enum : uint32_t {
+    linktype_null = 0,
+    linktype_ethernet = 1,
+    linktype_raw = 101,
+    linktype_linux_sll = 113,
+    linktype_ipv4 = 228,
+    linktype_ipv6 = 229
+  };
+
+  enum : uint16_t {
+    ethertype_ipv4 = 0x0800,
+    ethertype_ipv6 = 0x86dd,
+    ethertype_vlan = 0x8100,
+    ethertype_qinq = 0x88a8
+  };
+
+  enum : uint8_t { protocol_tcp = 6, protocol_udp = 17 };
+
+  enum { dns_header_length = 12 };
+
+  uint16_t get16( const uint8_t* p ) { return ( uint16_t( p[ 0 ] ) << 8 ) | p[ 1 ]; }
+
+  uint32_t swap32( uint32_t n ) { return __builtin_bswap32( n ); }
+
+  // pIp..pEnd is an IPv4 or IPv6 packet
+  void Packet( const uint8_t* pIp, const uint8_t* pEnd, uint16_t port, pcap::vQuery_t& vQuery, pcap::counts_t& counts ) {
+
+    if ( pEnd <= pIp ) { counts.nSkipped++; return; }
+
+    uint8_t protocol;
+    const uint8_t* pTransport;
+    switch ( pIp[ 0 ] >> 4 ) {
+      case 4: {
+          const std::size_t lenHeader = ( pIp[ 0 ] & 0x0f ) * 4;
+          if ( ( pEnd - pIp < 20 ) || ( lenHeader < 20 ) || ( std::size_t( pEnd - pIp ) < lenHeader ) ) { counts.nSkipped++; return; }
+          if ( 0 != ( get16( pIp + 6 ) & 0x3fff ) ) { counts.nSkipped++; return; } // a fragment
+          const std::size_t lenTotal = get16( pIp + 2 );
+          if ( ( lenHeader <= lenTotal ) && ( lenTotal < std::size_t( pEnd - pIp ) ) ) pEnd = pIp + lenTotal; // ethernet padding
+          protocol = pIp[ 9 ];
+          pTransport = pIp + lenHeader;
+        }
+        break;
+      case 6:
+        if ( pEnd - pIp < 40 ) { counts.nSkipped++; return; }
+        protocol = pIp[ 6 ];
+        pTransport = pIp + 40;
+        if ( std::size_t( 40 + get16( pIp + 4 ) ) < std::size_t( pEnd - pIp ) ) pEnd = pIp + 40 + get16( pIp + 4 );
+        break;
+      default:
+        counts.nSkipped++;
+        return;
+    }
+
+    if ( ( protocol_tcp == protocol ) && ( 4 <= pEnd - pTransport ) && ( port == get16( pTransport + 2 ) ) ) {
+      counts.nTcp++;
+      return;
+    }
+    if ( ( protocol_udp != protocol ) || ( pEnd - pTransport < 8 ) || ( port != get16( pTransport + 2 ) ) ) {
+      counts.nSkipped++;
+      return;
+    }
+
+    const uint8_t* pDns = pTransport + 8;
+    if ( ( pEnd - pDns < dns_header_length ) || ( 0 != ( pDns[ 2 ] & 0x80 ) ) ) { counts.nSkipped++; return; } // short, or a response
+    vQuery.emplace_back( pDns, pEnd );
+    counts.nQueries++;
+  }
+
+} // namespace anonymous
+
+namespace pcap {
+
+bool Read( const std::string& sPath, uint16_t port, vQuery_t& vQuery, counts_t& counts, std::string& sError ) {
+
+  FILE* pFile = std::fopen( sPath.c_str(), "rb" );
+  if ( nullptr == pFile ) {
+    sError = sPath + ": " + std::strerror( errno );
+    return false;
+  }
+
+  uint8_t header[ 24 ];
+  if ( sizeof( header ) != std::fread( header, 1, sizeof( header ), pFile ) ) {
+    std::fclose( pFile );
+    sError = sPath + ": too short for a pcap file";
+    return false;
+  }
+
+  uint32_t magic;
+  std::memcpy( &magic, header, sizeof( magic ) );
+  bool bSwap( false );
+  if ( ( magic_us == swap32( magic ) ) || ( magic_ns == swap32( magic ) ) ) bSwap = true;
+  else if ( ( magic_us != magic ) && ( magic_ns != magic ) ) {
+    std::fclose( pFile );
+    sError = sPath + ": not a pcap file (pcapng is not read, convert with editcap -F pcap)";
+    return false;
+  }
+  auto field32 = [bSwap]( const uint8_t* p ){ uint32_t n; std::memcpy( &n, p, sizeof( n ) ); return bSwap ? swap32( n ) : n; };
+
+  const uint32_t linktype = field32( header + 20 ) & 0x0fffffff;
+  switch ( linktype ) {
+    case linktype_null: case linktype_ethernet: case linktype_raw:
+    case linktype_linux_sll: case linktype_ipv4: case linktype_ipv6:
+      break;
+    default:
+      std::fclose( pFile );
+      sError = sPath + ": link type " + std::to_string( linktype ) + " is not read";
+      return false;
+  }
+
+  vByte_t vPacket;
+  uint8_t record[ 16 ];
+  while ( sizeof( record ) == std::fread( record, 1, sizeof( record ), pFile ) ) {
+
+    const uint32_t lenCaptured = field32( record + 8 );
+    if ( 0x40000 < lenCaptured ) {
+      std::fclose( pFile );
+      sError = sPath + ": corrupt record after " + std::to_string( counts.nPackets ) + " packets";
+      return false;
+    }
+    vPacket.resize( lenCaptured );
+    if ( lenCaptured != std::fread( vPacket.data(), 1, lenCaptured, pFile ) ) break; // truncated file, keep what was read
+    counts.nPackets++;
+
+    const uint8_t* p = vPacket.data();
+    const uint8_t* pEnd = p + lenCaptured;
+    uint16_t ethertype( 0 );
+    switch ( linktype ) {
+      case linktype_null: // host byte order family of the capturing machine, 2 for AF_INET, others for AF_INET6
+        if ( pEnd - p < 4 ) { counts.nSkipped++; continue; }
+        p += 4;
+        break;
+      case linktype_ethernet:
+        if ( pEnd - p < 14 ) { counts.nSkipped++; continue; }
+        ethertype = get16( p + 12 );
+        p += 14;
+        while ( ( ( ethertype_vlan == ethertype ) || ( ethertype_qinq == ethertype ) ) && ( 4 <= pEnd - p ) ) {
+          ethertype = get16( p + 2 );
+          p += 4;
+        }
+        if ( ( ethertype_ipv4 != ethertype ) && ( ethertype_ipv6 != ethertype ) ) { counts.nSkipped++; continue; }
+        break;
+      case linktype_linux_sll:
+        if ( pEnd - p < 16 ) { counts.nSkipped++; continue; }
+        ethertype = get16( p + 14 );
+        p += 16;
+        if ( ( ethertype_ipv4 != ethertype ) && ( ethertype_ipv6 != ethertype ) ) { counts.nSkipped++; continue; }
+        break;
+      default: // raw ip, the version nibble tells which
+        break;
+    }
+
+    Packet( p, pEnd, port, vQuery, counts );
+  }
+
+  std::fclose( pFile );
+  return true;
+}
+
+} // namespace pcap
@@ -0,0 +1,42 @@
+/*
+ * File:   pcap.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 23, 2026, 3:40 PM
+ */
+
+#ifndef PCAP_H
+#define PCAP_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// DNS queries out of a capture file, for replay.  Classic libpcap files only
+// (not pcapng), either byte order, micro or nanosecond stamps.  Link types:
+// ethernet (802.1Q tags skipped), linux cooked, raw ip, and BSD loopback.
+// Kept:  udp datagrams to the port, over IPv4 (unfragmented) or IPv6 (no
+// extension headers), with QR clear.  Nothing else is reassembled, so tcp
+// queries are counted and skipped.
+
+namespace pcap {
+
+struct counts_t {
+  std::size_t nPackets;
+  std::size_t nQueries;
+  std::size_t nTcp;      // to the port, skipped
+  std::size_t nSkipped;  // other traffic, fragments, responses, short packets
+  counts_t(): nPackets( 0 ), nQueries( 0 ), nTcp( 0 ), nSkipped( 0 ) {}
+};
+
+typedef std::vector<uint8_t> vByte_t;
+typedef std::vector<vByte_t> vQuery_t;
+
+// the dns payloads, in capture order;  false with sError filled in
+bool Read( const std::string& sPath, uint16_t port, vQuery_t& vQuery, counts_t& counts, std::string& sError );
+
+} // namespace pcap
+
+#endif /* PCAP_H */
+
@@ -0,0 +1,350 @@
+/*
+ * File:   replay.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 23, 2026, 4:10 PM
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <boost/asio/io_context.hpp>
+
+#include "allocations.h"
+#include "metrics.h"
+#include "responder.h"
+#include "server_udp.h"
+#include "zone_image.h"
+
+#include "pcap.h"
+#include "replay.h"
+
+namespace {
+
+  typedef std::chrono::steady_clock steady;
+
+  uint64_t Nanoseconds( steady::duration d ) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( d ).count();
+  }
+
+  const responder::stage rStage[] = {
+    responder::stage::parse, responder::stage::cache, responder::stage::lookup, responder::stage::encode };
+  enum { stages = sizeof( rStage ) / sizeof( rStage[ 0 ] ) };
+
+  // responder::StageNanoseconds, all of them at once, for differences across a round
+  struct stage_times {
+    uint64_t ns[ stages ];
+    stage_times() {
+      for ( unsigned ix = 0; ix < stages; ix++ ) ns[ ix ] = responder::StageNanoseconds( rStage[ ix ] );
+    }
+  };
+
+  struct round_t {
+    std::size_t nQueries;
+    uint64_t nsElapsed;
+    uint64_t nsStage[ stages ];
+    uint64_t nsSend;
+    uint64_t nAllocations;
+    round_t( std::size_t nQueries_, uint64_t nsElapsed_, const stage_times& before, const stage_times& after, uint64_t nsSend_, uint64_t nAllocations_ )
+      : nQueries( nQueries_ ), nsElapsed( nsElapsed_ ), nsSend( nsSend_ ), nAllocations( nAllocations_ )
+    {
+      for ( unsigned ix = 0; ix < stages; ix++ ) nsStage[ ix ] = after.ns[ ix ] - before.ns[ ix ];
+    }
+  };
+
+  void Header( const char* szExtra ) {
+    std::cout
+      << "round  queries     kqps   parse   cache  lookup  encode    send  allocs/q" << szExtra << std::endl;
+  }
+
+  void Report( unsigned ixRound, const round_t& round ) {
+    const double n( std::max<std::size_t>( 1, round.nQueries ) );
+    std::cout
+      << std::setw( 5 ) << ixRound << std::setw( 9 ) << round.nQueries
+      << std::fixed << std::setprecision( 1 )
+      << std::setw( 9 ) << ( 1e6 * round.nQueries / std::max<uint64_t>( 1, round.nsElapsed ) );
+    std::cout << std::setprecision( 0 );
+    for ( unsigned ix = 0; ix < stages; ix++ ) std::cout << std::setw( 8 ) << ( round.nsStage[ ix ] / n );
+    std::cout
+      << std::setw( 8 ) << ( round.nsSend / n )
+      << std::setprecision( 2 ) << std::setw( 10 ) << ( round.nAllocations / n );
+  }
+
+  // 127.0.0.1:port, or any port with 0
+  sockaddr_in Loopback( uint16_t port ) {
+    sockaddr_in addr;
+    std::memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons( port );
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    return addr;
+  }
+
+  bool Fail( const char* szWhat ) {
+    std::cerr << szWhat << ": " << std::strerror( errno ) << std::endl;
+    return false;
+  }
+
+  // a connected pair over loopback:  fdSend carries the replies, drained on fdSink
+  bool Connect( bool bTcp, int& fdSend, int& fdSink ) {
+    sockaddr_in addr( Loopback( 0 ) );
+    socklen_t lenAddr( sizeof( addr ) );
+    fdSend = fdSink = -1;
+    if ( bTcp ) {
+      const int fdListen = socket( AF_INET, SOCK_STREAM, 0 );
+      if ( 0 > fdListen ) return Fail( "socket" );
+      if ( ( 0 > bind( fdListen, reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) )
+        || ( 0 > listen( fdListen, 1 ) )
+        || ( 0 > getsockname( fdListen, reinterpret_cast<sockaddr*>( &addr ), &lenAddr ) ) ) {
+        close( fdListen );
+        return Fail( "listen" );
+      }
+      fdSend = socket( AF_INET, SOCK_STREAM, 0 );
+      if ( ( 0 > fdSend ) || ( 0 > connect( fdSend, reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) ) ) {
+        close( fdListen );
+        return Fail( "connect" );
+      }
+      fdSink = accept( fdListen, nullptr, nullptr );
+      close( fdListen );
+      if ( 0 > fdSink ) return Fail( "accept" );
+      const int one( 1 );
+      setsockopt( fdSend, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) ); // as the server's sessions
+    }
+    else {
+      fdSink = socket( AF_INET, SOCK_DGRAM, 0 );
+      if ( ( 0 > fdSink )
+        || ( 0 > bind( fdSink, reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) )
+        || ( 0 > getsockname( fdSink, reinterpret_cast<sockaddr*>( &addr ), &lenAddr ) ) ) {
+        return Fail( "bind" );
+      }
+      fdSend = socket( AF_INET, SOCK_DGRAM, 0 );
+      if ( ( 0 > fdSend ) || ( 0 > connect( fdSend, reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) ) ) {
+        return Fail( "connect" );
+      }
+    }
+    return true;
+  }
+
+  // each query through a responder, the reply out a loopback socket
+  int InProcess( const replay_options& options, const zone_image* pZone, const pcap::vQuery_t& vQuery ) {
+
+    int fdSend, fdSink;
+    if ( !Connect( options.bTcp, fdSend, fdSink ) ) return 1;
+    std::thread threadSink( [fdSink](){ // keeps the receive side empty, ends with the shutdown below
+      static uint8_t buf[ 0x10000 ];
+      while ( 0 < recv( fdSink, buf, sizeof( buf ), 0 ) ) {}
+    } );
+
+    metrics::worker_metrics metrics_;
+    responder responder_(
+      pZone, nullptr, metrics_, options.bTcp ? metrics::tcp : metrics::udp, answer_cache::options_t(), options.nUdpPayload );
+
+    // as server_udp and session size their buffers
+    const std::size_t lenReplyMax = options.bTcp
+      ? std::size_t( 0xffff )
+      : std::max<std::size_t>( dns::max_udp_length, std::min<std::size_t>( dns::max_edns_udp_length, options.nUdpPayload ) );
+    std::vector<uint8_t> vReply( 2 + 0xffff ); // with room for the tcp length prefix
+
+    std::cout << "in process, " << ( options.bTcp ? "tcp" : "udp" ) << std::endl;
+    Header( "" );
+
+    metrics::counter allocations_;
+    std::size_t nDropped( 0 );
+    for ( unsigned ixRound = 0; ixRound < options.nRounds; ixRound++ ) {
+
+      const stage_times before;
+      const uint64_t nAllocations( allocations_.get() );
+      uint64_t nsSend( 0 );
+      const steady::time_point start( steady::now() );
+      {
+        allocations::scope scope( allocations_ );
+        for ( const pcap::vByte_t& query: vQuery ) {
+          const std::size_t lenReply = responder_.Process( query.data(), query.size(), vReply.data() + 2, lenReplyMax );
+          if ( ( 0 == lenReply ) || ( responder::forward == lenReply ) ) continue;
+          const steady::time_point startSend( steady::now() );
+          ssize_t nSent;
+          if ( options.bTcp ) {
+            vReply[ 0 ] = static_cast<uint8_t>( lenReply >> 8 );
+            vReply[ 1 ] = static_cast<uint8_t>( lenReply );
+            nSent = send( fdSend, vReply.data(), 2 + lenReply, 0 );
+          }
+          else {
+            nSent = send( fdSend, vReply.data() + 2, lenReply, 0 );
+          }
+          if ( 0 > nSent ) nDropped++;
+          nsSend += Nanoseconds( steady::now() - startSend );
+        }
+      }
+      const uint64_t nsElapsed( Nanoseconds( steady::now() - start ) );
+
+      Report( ixRound, round_t( vQuery.size(), nsElapsed, before, stage_times(), nsSend, allocations_.get() - nAllocations ) );
+      std::cout << std::endl;
+    }
+    if ( 0 != nDropped ) std::cout << nDropped << " replies not sent" << std::endl;
+
+    shutdown( fdSend, SHUT_RDWR );
+    shutdown( fdSink, SHUT_RDWR );
+    threadSink.join();
+    close( fdSend );
+    close( fdSink );
+    return 0;
+  }
+
+  // a server_udp in its own thread, queries over a udp socket, nOutstanding at a time
+  int Loopback( const replay_options& options, const zone_image* pZone, const pcap::vQuery_t& vQuery ) {
+
+    boost::asio::io_context io;
+    metrics::worker_metrics metrics_;
+    server_udp server(
+      io, static_cast<short>( options.portLoopback ), false, options.nBatch, pZone, nullptr,
+      rrl::options_t(), metrics_, answer_cache::options_t(), options.nUdpPayload, options.bUring );
+    std::thread threadServer( [&io](){ io.run(); } );
+
+    const int fd = socket( AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0 );
+    const sockaddr_in addr( Loopback( options.portLoopback ) );
+    if ( ( 0 > fd ) || ( 0 > connect( fd, reinterpret_cast<const sockaddr*>( &addr ), sizeof( addr ) ) ) ) {
+      Fail( "connect" );
+      io.stop();
+      threadServer.join();
+      return 1;
+    }
+    const int lenBuffer( 4 << 20 );
+    setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &lenBuffer, sizeof( lenBuffer ) );
+
+    std::cout
+      << "loopback udp, port " << options.portLoopback << ", "
+      << ( options.bUring ? "io_uring" : "batch " + std::to_string( options.nBatch ) ) << ", "
+      << options.nOutstanding << " outstanding" << std::endl;
+    Header( "     p50 us    p99 us  lost" );
+
+    // the id of a query in flight is its slot:  when each went out, or zero
+    std::vector<steady::time_point> vSent( 0x10000 );
+    std::vector<uint32_t> vLatency; // ns, per reply
+    vLatency.reserve( vQuery.size() );
+    std::vector<uint8_t> vTx( 0xffff );
+    std::vector<uint8_t> vRx( 0xffff );
+
+    for ( unsigned ixRound = 0; ixRound < options.nRounds; ixRound++ ) {
+
+      std::fill( vSent.begin(), vSent.end(), steady::time_point() );
+      vLatency.clear();
+      std::size_t ixNext( 0 );
+      unsigned nInFlight( 0 );
+      std::size_t nLost( 0 );
+      uint64_t nsRoundTrips( 0 );
+
+      const stage_times before;
+      const uint64_t nAllocations( metrics_.udp_heap_allocations.get() );
+      const steady::time_point start( steady::now() );
+
+      while ( ( ixNext < vQuery.size() ) || ( 0 != nInFlight ) ) {
+
+        while ( ( nInFlight < options.nOutstanding ) && ( ixNext < vQuery.size() ) ) {
+          const pcap::vByte_t& query( vQuery[ ixNext ] );
+          const uint16_t id = static_cast<uint16_t>( ixNext );
+          std::memcpy( vTx.data(), query.data(), query.size() );
+          vTx[ 0 ] = static_cast<uint8_t>( id >> 8 );
+          vTx[ 1 ] = static_cast<uint8_t>( id );
+          ixNext++;
+          if ( 0 > send( fd, vTx.data(), query.size(), 0 ) ) {
+            nLost++;
+            continue;
+          }
+          vSent[ id ] = steady::now();
+          nInFlight++;
+        }
+
+        pollfd pfd{ fd, POLLIN, 0 };
+        if ( 0 == poll( &pfd, 1, 200 ) ) { // the rest are not coming
+          nLost += nInFlight;
+          nInFlight = 0;
+          std::fill( vSent.begin(), vSent.end(), steady::time_point() );
+          continue;
+        }
+
+        ssize_t lenRx;
+        while ( 0 < ( lenRx = recv( fd, vRx.data(), vRx.size(), 0 ) ) ) {
+          if ( 2 > lenRx ) continue;
+          const uint16_t id = ( uint16_t( vRx[ 0 ] ) << 8 ) | vRx[ 1 ];
+          if ( steady::time_point() == vSent[ id ] ) continue; // late, already counted lost
+          const uint64_t ns( Nanoseconds( steady::now() - vSent[ id ] ) );
+          vLatency.push_back( static_cast<uint32_t>( std::min<uint64_t>( ns, UINT32_MAX ) ) );
+          nsRoundTrips += ns;
+          vSent[ id ] = steady::time_point();
+          nInFlight--;
+        }
+      }
+
+      const uint64_t nsElapsed( Nanoseconds( steady::now() - start ) );
+      const stage_times after;
+
+      // send:  whatever of a round trip the responder did not account for
+      uint64_t nsResponder( 0 );
+      for ( unsigned ix = 0; ix < stages; ix++ ) nsResponder += after.ns[ ix ] - before.ns[ ix ];
+      const uint64_t nsSend( ( nsRoundTrips > nsResponder ) ? nsRoundTrips - nsResponder : 0 );
+
+      Report( ixRound, round_t( vQuery.size(), nsElapsed, before, after, nsSend, metrics_.udp_heap_allocations.get() - nAllocations ) );
+      double usP50( 0.0 ), usP99( 0.0 );
+      if ( !vLatency.empty() ) {
+        std::sort( vLatency.begin(), vLatency.end() );
+        usP50 = vLatency[ vLatency.size() / 2 ] / 1000.0;
+        usP99 = vLatency[ std::min( vLatency.size() - 1, vLatency.size() * 99 / 100 ) ] / 1000.0;
+      }
+      std::cout
+        << std::setprecision( 1 ) << std::setw( 11 ) << usP50 << std::setw( 10 ) << usP99
+        << std::setw( 6 ) << nLost << std::endl;
+    }
+
+    close( fd );
+    io.stop();
+    threadServer.join();
+    return 0;
+  }
+
+} // namespace anonymous
+
+int Replay( const replay_options& options ) {
+
+  std::string sError;
+  pcap::vQuery_t vQuery;
+  pcap::counts_t counts;
+  if ( !pcap::Read( options.sPcap, options.portCapture, vQuery, counts, sError ) ) {
+    std::cerr << sError << std::endl;
+    return 1;
+  }
+  std::cout
+    << options.sPcap << ": " << counts.nPackets << " packets, " << counts.nQueries << " udp queries to port "
+    << options.portCapture << ", " << counts.nTcp << " tcp skipped, " << counts.nSkipped << " other" << std::endl;
+  if ( vQuery.empty() ) {
+    std::cerr << "no queries to replay" << std::endl;
+    return 1;
+  }
+
+  zone_image zone;
+  const zone_image* pZone( nullptr );
+  if ( !options.sZoneImage.empty() ) {
+    if ( !zone.Open( options.sZoneImage, sError ) ) {
+      std::cerr << sError << std::endl;
+      return 1;
+    }
+    pZone = &zone;
+  }
+
+  return ( 0 == options.portLoopback )
+    ? InProcess( options, pZone, vQuery )
+    : Loopback( options, pZone, vQuery );
+}
@@ -0,0 +1,48 @@
+/*
+ * File:   replay.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 23, 2026, 4:10 PM
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+#include <cstdint>
+
+#include "dns.h"
+
+// End to end runs of the server's query path over the queries of a capture,
+// reported per round:  rate, nanoseconds per query in each stage (parse,
+// cache, lookup, encode, send), and heap allocations per query.
+//
+// In process, the default:  a responder (the udp handler's and
+//   session::ProcessPacket's entry point) is called for each query straight
+//   from memory;  send is the reply written to a connected loopback socket,
+//   a tcp one, length prefixed, with bTcp.
+// Loopback:  a server_udp in its own thread (recvmmsg, or io_uring with
+//   bUring), queries sent over a udp socket with nOutstanding in flight;
+//   latency is the round trip, send everything outside the responder.
+
+struct replay_options {
+  std::string sPcap;
+  std::string sZoneImage;     // none to answer REFUSED throughout
+  uint16_t portCapture;       // queries are the udp datagrams to this port
+  unsigned nRounds;           // passes over the capture, after the first answers come from the cache
+  bool bTcp;
+  unsigned short portLoopback; // 0 for in process
+  unsigned nBatch;
+  bool bUring;
+  unsigned nOutstanding;
+  uint16_t nUdpPayload;
+  replay_options()
+    : portCapture( 53 ), nRounds( 3 ), bTcp( false ), portLoopback( 0 ),
+      nBatch( 32 ), bUring( false ), nOutstanding( 64 ), nUdpPayload( dns::edns_udp_length ) {}
+};
+
+int Replay( const replay_options& ); // exit status
+
+#endif /* REPLAY_H */
+
@@ -0,0 +1,65 @@
+/*
+ * File:   latency_histogram.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 9:10 AM
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "latency_histogram.h"
+
+latency_histogram::latency_histogram()
+  : m_nCount( 0 ), m_sum( 0 ), m_min( std::numeric_limits<uint64_t>::max() ), m_max( 0 )
+{
+  m_bucket.fill( 0 );
+}
+
+unsigned latency_histogram::Index( uint64_t value ) {
+  if ( linear > value ) return static_cast<unsigned>( value );
+  const unsigned msb = 63 - __builtin_clzll( value );
+  const unsigned shift = msb - 5;                      // keeps the top six bits
+  const unsigned sub = static_cast<unsigned>( value >> shift ); // sub_buckets .. 2 * sub_buckets - 1
+  return linear + ( shift - 1 ) * sub_buckets + ( sub - sub_buckets );
+}
+
+uint64_t latency_histogram::Highest( unsigned ix ) {
+  if ( linear > ix ) return ix;
+  const unsigned shift = ( ix - linear ) / sub_buckets + 1;
+  const uint64_t sub = ( ix - linear ) % sub_buckets + sub_buckets;
+  return ( ( sub + 1 ) << shift ) - 1;
+}
+
+void latency_histogram::record( uint64_t value ) {
+  m_bucket[ Index( value ) ]++;
+  m_nCount++;
+  m_sum += value;
+  m_min = std::min( m_min, value );
+  m_max = std::max( m_max, value );
+}
+
+void latency_histogram::merge( const latency_histogram& rhs ) {
+  for ( std::size_t ix = 0; ix < m_bucket.size(); ix++ ) m_bucket[ ix ] += rhs.m_bucket[ ix ];
+  m_nCount += rhs.m_nCount;
+  m_sum += rhs.m_sum;
+  m_min = std::min( m_min, rhs.m_min );
+  m_max = std::max( m_max, rhs.m_max );
+}
+
+double latency_histogram::mean() const {
+  return ( 0 == m_nCount ) ? 0.0 : double( m_sum ) / m_nCount;
+}
+
+uint64_t latency_histogram::percentile( double fraction ) const {
+  if ( 0 == m_nCount ) return 0;
+  const uint64_t target = std::max<uint64_t>( 1, static_cast<uint64_t>( std::ceil( fraction * m_nCount ) ) );
+  uint64_t n( 0 );
+  for ( unsigned ix = 0; ix < m_bucket.size(); ix++ ) {
+    n += m_bucket[ ix ];
+    if ( n >= target ) return std::max( std::min( Highest( ix ), m_max ), m_min );
+  }
+  return m_max;
+}
@@ -0,0 +1,55 @@
+/*
+ * File:   latency_histogram.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 9:10 AM
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+
+// Log-linear buckets, in the manner of HdrHistogram:  exact below 64, then 32
+// linear steps per power of two, so any recorded value is within about 3% of
+// its bucket.  Fixed size, no allocation while recording; one per thread,
+// merged at the end.
+
+class latency_histogram {
+public:
+
+  latency_histogram();
+
+  void record( uint64_t value );
+  void merge( const latency_histogram& rhs );
+
+  uint64_t count() const { return m_nCount; }
+  uint64_t max() const { return m_max; }
+  uint64_t min() const { return ( 0 == m_nCount ) ? 0 : m_min; }
+  double mean() const;
+
+  // smallest value with at least the fraction (0 .. 1) of recorded values at or below it
+  uint64_t percentile( double fraction ) const;
+
+private:
+
+  enum {
+    sub_buckets = 32,
+    linear = 2 * sub_buckets,   // values below this have a bucket each
+    shifts = 58,                // covers all of uint64_t
+    buckets = linear + shifts * sub_buckets
+  };
+
+  std::array<uint64_t, buckets> m_bucket;
+  uint64_t m_nCount;
+  uint64_t m_sum;
+  uint64_t m_min;
+  uint64_t m_max;
+
+  static unsigned Index( uint64_t value );
+  static uint64_t Highest( unsigned ix ); // largest value in the bucket
+};
+
+#endif /* LATENCY_HISTOGRAM_H */
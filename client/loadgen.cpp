@@ -0,0 +1,381 @@
+/*
+ * File:   loadgen.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 9:40 AM
+ */
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "dns.h"
+#include "query.h"
+#include "latency_histogram.h"
+#include "loadgen.h"
+
+namespace asio = boost::asio;
+namespace ip = boost::asio::ip;
+
+namespace {
+
+  inline uint64_t Now() { // ns
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  struct stats_t {
+    uint64_t nSent;
+    uint64_t nSendError;
+    uint64_t nAnswered;
+    uint64_t nLost;
+    uint64_t nUnmatched;    // late, duplicate or foreign replies
+    uint64_t nTruncated;    // answered with TC, a real client would go to tcp
+    std::array<uint64_t, 16> rcode;
+    latency_histogram latency; // ns
+    stats_t(): nSent( 0 ), nSendError( 0 ), nAnswered( 0 ), nLost( 0 ), nUnmatched( 0 ), nTruncated( 0 ) { rcode.fill( 0 ); }
+    void merge( const stats_t& rhs ) {
+      nSent += rhs.nSent;
+      nSendError += rhs.nSendError;
+      nAnswered += rhs.nAnswered;
+      nLost += rhs.nLost;
+      nUnmatched += rhs.nUnmatched;
+      nTruncated += rhs.nTruncated;
+      for ( std::size_t ix = 0; ix < rcode.size(); ix++ ) rcode[ ix ] += rhs.rcode[ ix ];
+      latency.merge( rhs.latency );
+    }
+  };
+
+  // ====
+
+  class worker {
+  public:
+
+    worker(
+      const loadgen_config& config, const loadgen::vQuery_t& vQuery, const ip::udp::endpoint& endpoint,
+      unsigned ix, double qps, unsigned nOutstanding )
+    : m_vQuery( vQuery ), m_ixQuery( ix * vQuery.size() / config.nThreads ),
+      m_qps( qps ), m_nOutstanding( nOutstanding ),
+      m_timeout( uint64_t( config.msTimeout ) * 1000000 ),
+      m_duration( uint64_t( config.seconds * 1e9 ) ),
+      m_tStart( 0 ), m_bSending( true ), m_nReplace( 0 ),
+      m_timer( m_io_context )
+    {
+      for ( unsigned ixSocket = 0; ixSocket < config.nSockets; ixSocket++ ) {
+        m_vSocket.emplace_back( new socket_t( m_io_context ) );
+        socket_t& socket( *m_vSocket.back() );
+        socket.socket.open( endpoint.protocol() );
+        socket.socket.connect( endpoint ); // replies only from the server, and a port of its own
+        socket.socket.non_blocking( true );
+      }
+    }
+
+    void start() {
+      m_thread = std::thread( [this](){ run(); } );
+    }
+
+    void join() {
+      if ( m_thread.joinable() ) m_thread.join();
+    }
+
+    const stats_t& stats() const { return m_stats; }
+
+  private:
+
+    enum { tick_ms = 1, max_burst = 10000 };
+
+    struct entry_t {
+      uint16_t id;
+      uint64_t tSent;
+    };
+
+    struct socket_t {
+      ip::udp::socket socket;
+      std::array<uint8_t, 4096> bufRx;
+      std::vector<uint64_t> vSent;  // by transaction id, 0 when not in flight
+      std::deque<entry_t> dequeSent; // in send order, for expiry
+      uint16_t idNext;
+      explicit socket_t( asio::io_context& io_context )
+        : socket( io_context ), vSent( 0x10000, 0 ), idNext( 0 ) {}
+    };
+
+    const loadgen::vQuery_t& m_vQuery;
+    std::size_t m_ixQuery;
+    const double m_qps;
+    const unsigned m_nOutstanding;
+    const uint64_t m_timeout;
+    const uint64_t m_duration;
+    uint64_t m_tStart;
+    bool m_bSending;
+    unsigned m_nReplace;  // closed loop:  failed sends, sent again on the next tick
+
+    asio::io_context m_io_context;
+    asio::steady_timer m_timer;
+    std::vector<std::unique_ptr<socket_t> > m_vSocket;
+    std::size_t m_ixSocket;  // round robin
+    std::array<uint8_t, 512> m_bufTx;
+    std::thread m_thread;
+
+    stats_t m_stats;
+
+    void run() {
+      m_tStart = Now();
+      m_ixSocket = 0;
+      for ( auto& pSocket: m_vSocket ) start_receive( *pSocket );
+      // closed loop:  the window goes out at once, spread over the sockets
+      for ( unsigned ix = 0; ix < m_nOutstanding; ix++ ) Send( *m_vSocket[ ix % m_vSocket.size() ] );
+      start_timer();
+      m_io_context.run();
+    }
+
+    void Send( socket_t& socket ) {
+      const loadgen::query_t& query( m_vQuery[ m_ixQuery ] );
+      if ( m_vQuery.size() == ++m_ixQuery ) m_ixQuery = 0;
+
+      const uint16_t id = socket.idNext++;
+      if ( 0 != socket.vSent[ id ] ) { // 64k in flight on this socket, the oldest is as good as lost
+        socket.vSent[ id ] = 0;
+        m_stats.nLost++;
+      }
+      std::copy( query.begin(), query.end(), m_bufTx.begin() );
+      dns::put16( m_bufTx.data(), id );
+
+      boost::system::error_code ec;
+      socket.socket.send( asio::buffer( m_bufTx.data(), query.size() ), 0, ec );
+      m_stats.nSent++;
+      if ( ec ) {
+        // no reply nor timeout will come to release the next query, so it
+        //   is lost now, and replaced on the next tick to keep the window full
+        m_stats.nSendError++;
+        m_stats.nLost++;
+        if ( 0 != m_nOutstanding ) m_nReplace++;
+        return;
+      }
+      const uint64_t tSent = Now();
+      socket.vSent[ id ] = tSent;
+      socket.dequeSent.push_back( entry_t{ id, tSent } );
+    }
+
+    void start_receive( socket_t& socket ) {
+      socket.socket.async_receive(
+        asio::buffer( socket.bufRx ),
+        [this, &socket]( const boost::system::error_code& ec, std::size_t length ){
+          if ( asio::error::operation_aborted == ec ) return;
+          const uint64_t tNow = Now();
+          if ( !ec && ( dns::header_length <= length ) ) {
+            const uint16_t id = dns::get16( socket.bufRx.data() );
+            const uint64_t tSent = socket.vSent[ id ];
+            if ( 0 == tSent ) m_stats.nUnmatched++;
+            else {
+              socket.vSent[ id ] = 0;
+              m_stats.nAnswered++;
+              m_stats.rcode[ socket.bufRx[ 3 ] & 0x0f ]++;
+              if ( 0 != ( socket.bufRx[ 2 ] & ( dns::flag::TC >> 8 ) ) ) m_stats.nTruncated++;
+              m_stats.latency.record( tNow - tSent );
+              if ( m_bSending && ( 0 != m_nOutstanding ) ) Send( socket );
+            }
+          }
+          start_receive( socket ); // icmp unreachable shows up as an error, keep listening
+        } );
+    }
+
+    void start_timer() {
+      m_timer.expires_after( std::chrono::milliseconds( tick_ms ) );
+      m_timer.async_wait( [this]( const boost::system::error_code& ec ){
+        if ( !ec ) Tick();
+      } );
+    }
+
+    void Tick() {
+
+      const uint64_t tNow = Now();
+      const uint64_t tElapsed = tNow - m_tStart;
+      m_bSending = tElapsed < m_duration;
+
+      // expire the unanswered
+      bool bInFlight( false );
+      for ( auto& pSocket: m_vSocket ) {
+        socket_t& socket( *pSocket );
+        while ( !socket.dequeSent.empty() ) {
+          const entry_t& entry( socket.dequeSent.front() );
+          if ( socket.vSent[ entry.id ] != entry.tSent ) { // answered, or its id re-used
+            socket.dequeSent.pop_front();
+            continue;
+          }
+          if ( !m_bSending || ( entry.tSent + m_timeout <= tNow ) ) {
+            if ( entry.tSent + m_timeout > tNow ) break; // still has time, after the end
+            socket.vSent[ entry.id ] = 0;
+            m_stats.nLost++;
+            socket.dequeSent.pop_front();
+            if ( m_bSending && ( 0 != m_nOutstanding ) ) Send( socket );
+            continue;
+          }
+          break;
+        }
+        bInFlight = bInFlight || !socket.dequeSent.empty();
+      }
+
+      // closed loop:  the window refilled after failed sends
+      if ( m_bSending ) {
+        unsigned nReplace( m_nReplace );
+        m_nReplace = 0;
+        while ( 0 < nReplace-- ) {
+          Send( *m_vSocket[ m_ixSocket ] );
+          if ( m_vSocket.size() == ++m_ixSocket ) m_ixSocket = 0;
+        }
+      }
+
+      // open loop:  catch up with the schedule
+      if ( m_bSending && ( 0.0 < m_qps ) ) {
+        const uint64_t nDue = static_cast<uint64_t>( m_qps * tElapsed / 1e9 );
+        uint64_t nSend = std::min<uint64_t>( ( nDue > m_stats.nSent ) ? nDue - m_stats.nSent : 0, max_burst );
+        while ( 0 < nSend-- ) {
+          Send( *m_vSocket[ m_ixSocket ] );
+          if ( m_vSocket.size() == ++m_ixSocket ) m_ixSocket = 0;
+        }
+      }
+
+      if ( m_bSending || bInFlight ) start_timer();
+      else m_io_context.stop();
+    }
+
+  };
+
+} // namespace anonymous
+
+loadgen::loadgen( const loadgen_config& config ): m_config( config ) {
+  m_config.nThreads = std::max( 1u, m_config.nThreads );
+  m_config.nSockets = std::max( 1u, m_config.nSockets );
+}
+
+bool loadgen::LoadQueries( const std::string& sPath, vQuery_t& vQuery, std::string& sError ) {
+
+  std::ifstream file( sPath );
+  if ( !file ) {
+    sError = "can not open " + sPath;
+    return false;
+  }
+
+  std::string sLine;
+  unsigned nLine( 0 );
+  while ( std::getline( file, sLine ) ) {
+    nLine++;
+    const std::size_t ixComment = sLine.find_first_of( "#;" );
+    if ( std::string::npos != ixComment ) sLine.erase( ixComment );
+    std::istringstream ss( sLine );
+    std::string sName, sType;
+    if ( !( ss >> sName ) ) continue;
+    ss >> sType;
+
+    uint16_t type( dns::type::A );
+    if ( !sType.empty() && !query::Type( sType, type ) ) {
+      sError = sPath + ":" + std::to_string( nLine ) + ": bad type " + sType;
+      return false;
+    }
+    query_t query;
+    if ( !query::Encode( sName, type, dns::cls::IN, query ) ) {
+      sError = sPath + ":" + std::to_string( nLine ) + ": bad name " + sName;
+      return false;
+    }
+    vQuery.emplace_back( std::move( query ) );
+  }
+  if ( vQuery.empty() ) {
+    sError = sPath + ": no queries";
+    return false;
+  }
+  return true;
+}
+
+int loadgen::Run() {
+
+  vQuery_t vQuery;
+  std::string sError;
+  if ( !LoadQueries( m_config.sQueryFile, vQuery, sError ) ) {
+    std::cerr << sError << std::endl;
+    return 1;
+  }
+  if ( 0 != m_config.nEdnsPayload ) {
+    for ( query_t& query: vQuery ) query::Edns( m_config.nEdnsPayload, query );
+  }
+  if ( ( 0.0 >= m_config.qps ) && ( 0 == m_config.nOutstanding ) ) {
+    std::cerr << "a target rate or a number outstanding is required" << std::endl;
+    return 1;
+  }
+
+  asio::io_context io_context;
+  ip::udp::resolver resolver( io_context );
+  boost::system::error_code ec;
+  const auto results = resolver.resolve( ip::udp::v4(), m_config.sHost, m_config.sPort, ec );
+  if ( ec || results.empty() ) {
+    std::cerr << "can not resolve " << m_config.sHost << ":" << m_config.sPort << std::endl;
+    return 1;
+  }
+  const ip::udp::endpoint endpoint( *results.begin() );
+
+  std::cout
+    << "loadgen " << endpoint << ", " << vQuery.size() << " queries, "
+    << m_config.nThreads << " thread(s) x " << m_config.nSockets << " socket(s), ";
+  if ( 0.0 < m_config.qps ) std::cout << "open loop at " << m_config.qps << " qps";
+  else std::cout << "closed loop with " << m_config.nOutstanding << " outstanding";
+  std::cout << ", " << m_config.seconds << " s." << std::endl;
+
+  std::vector<std::unique_ptr<worker> > vWorker;
+  for ( unsigned ix = 0; ix < m_config.nThreads; ix++ ) {
+    const unsigned nOutstanding
+      = m_config.nOutstanding / m_config.nThreads + ( ( ix < m_config.nOutstanding % m_config.nThreads ) ? 1 : 0 );
+    vWorker.emplace_back(
+      new worker( m_config, vQuery, endpoint, ix, m_config.qps / m_config.nThreads, nOutstanding ) );
+  }
+  const auto tStart = std::chrono::steady_clock::now();
+  for ( auto& pWorker: vWorker ) pWorker->start();
+  for ( auto& pWorker: vWorker ) pWorker->join();
+  const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - tStart ).count();
+
+  stats_t stats;
+  for ( auto& pWorker: vWorker ) stats.merge( pWorker->stats() );
+
+  // replies keep arriving for up to the timeout after sending stops
+  const double secondsSending = std::min( seconds, m_config.seconds );
+  const auto percent = [&stats]( uint64_t n ){ return ( 0 == stats.nSent ) ? 0.0 : 100.0 * n / stats.nSent; };
+  const auto us = []( uint64_t ns ){ return ns / 1000.0; };
+
+  std::cout << std::fixed << std::setprecision( 2 )
+    << "sent " << stats.nSent << " (" << stats.nSent / secondsSending << " qps)"
+    << ", answered " << stats.nAnswered << " (" << percent( stats.nAnswered ) << "%, "
+    << stats.nAnswered / secondsSending << " qps)"
+    << ", lost " << stats.nLost << " (" << percent( stats.nLost ) << "%)"
+    << ", send errors " << stats.nSendError
+    << ", unmatched " << stats.nUnmatched
+    << ", truncated " << stats.nTruncated << " (" << percent( stats.nTruncated ) << "%)" << std::endl;
+
+  std::cout << "rcode";
+  for ( std::size_t ix = 0; ix < stats.rcode.size(); ix++ ) {
+    if ( 0 == stats.rcode[ ix ] ) continue;
+    std::cout << " " << query::Rcode( ix ) << " " << stats.rcode[ ix ];
+  }
+  std::cout << std::endl;
+
+  const latency_histogram& latency( stats.latency );
+  std::cout
+    << "latency us: min " << us( latency.min() )
+    << " mean " << us( latency.mean() )
+    << " p50 " << us( latency.percentile( 0.5 ) )
+    << " p90 " << us( latency.percentile( 0.9 ) )
+    << " p99 " << us( latency.percentile( 0.99 ) )
+    << " p99.9 " << us( latency.percentile( 0.999 ) )
+    << " max " << us( latency.max() ) << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * File:   loadgen.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 9:40 AM
+ */
+
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Benchmark mode of the client:  replays a query list against a server over
+// udp, for a fixed time, and reports achieved rate, loss, rcodes and latency
+// percentiles.
+//
+// Open loop (qps set):  queries go out on a 1 ms schedule at the target rate
+// whether or not answers come back, so a slow server shows up as latency and
+// loss rather than as a lower offered load.  Closed loop (nOutstanding set):
+// each reply or timeout releases the next query.
+//
+// Load is spread over nThreads threads, each with its own io_context and
+// nSockets connected sockets (so as many source ports); transaction ids are
+// tracked per socket.
+
+struct loadgen_config {
+  std::string sHost;
+  std::string sPort;
+  std::string sQueryFile;  // lines of "<name> [<type>]", '#' or ';' comments
+  unsigned nThreads;
+  unsigned nSockets;       // per thread
+  double qps;              // target, open loop
+  unsigned nOutstanding;   // in flight, all threads together, closed loop
+  double seconds;          // sending time, replies are awaited for msTimeout more
+  unsigned msTimeout;      // a query unanswered this long is lost
+  uint16_t nEdnsPayload;   // an OPT advertising this size on each query, 0 for none
+  loadgen_config()
+    : sHost( "127.0.0.1" ), sPort( "53" ),
+      nThreads( 1 ), nSockets( 4 ), qps( 0.0 ), nOutstanding( 0 ), seconds( 10.0 ), msTimeout( 1000 ),
+      nEdnsPayload( 0 )
+  {}
+};
+
+class loadgen {
+public:
+
+  typedef std::vector<uint8_t> query_t;  // wire format, id zero
+  typedef std::vector<query_t> vQuery_t;
+
+  explicit loadgen( const loadgen_config& );
+
+  // the query list, false with sError filled in on a bad line
+  static bool LoadQueries( const std::string& sPath, vQuery_t&, std::string& sError );
+
+  // runs to completion and prints the report, returns a process exit code
+  int Run();
+
+private:
+  loadgen_config m_config;
+};
+
+#endif /* LOADGEN_H */
@@ -8,7 +8,10 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 #include <iostream>
+#include <cstdlib>
+#include <algorithm>
 
 #include <boost/bind.hpp>
 
@@ -21,6 +24,12 @@
 #include <boost/asio/placeholders.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
+#include <getopt.h>
+
+#include "dns.h"
+#include "loadgen.h"
+#include "resolver.h"
+
 //#include "session.h"
 
 namespace asio = boost::asio;
@@ -54,86 +63,6 @@ private:
 
 //  ==============
 
-// https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/networking/protocols.html
-// https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/tutorial/tutdaytime7.html
-
-// Data may be read from or written to an unconnected UDP socket using the 
-//   receive_from(), async_receive_from(), send_to() or async_send_to() member functions. 
-// For a connected UDP socket, use the 
-//   receive(), async_receive(), send() or async_send() member functions. 
-
-class client_udp {
-public:
-  client_udp( asio::io_context& io_context, const std::string& host, const std::string& port )
-    : m_resolver( io_context ), 
-      m_endpointRemote( *m_resolver.resolve( ip::udp::v4(), host, port, m_ec ).begin() ),
-      m_socket( io_context )
-    {
-      m_socket.open( ip::udp::v4() );
-      send();
-      start_receive();
-    }
-protected:
-private:
-  
-  ip::udp::resolver m_resolver;
-  //ip::udp::endpoint m_endpoint;
-  ip::udp::socket m_socket;
-  std::array<std::uint8_t, 1024> m_bufReceive;
-  ip::udp::endpoint m_endpointRemote; // are multiple endpoints required?
-  boost::system::error_code m_ec;
-  
-  void send_complete( std::shared_ptr<std::string> message, const boost::system::error_code& ec, std::size_t bytes_transferred ) {
-    // used for destroying the message for now
-    std::cout << "client udp send complete with " << bytes_transferred << " bytes transmitted" << std::endl;
-  }
-  
-  void send() {
-    
-    std::shared_ptr<std::string> message( new std::string( "client out test" ) );
-
-    m_socket.async_send_to(
-      asio::buffer( *message ),
-      m_endpointRemote,
-      boost::bind( 
-        &client_udp::send_complete, this, 
-        message, 
-        asio::placeholders::error,
-        asio::placeholders::bytes_transferred
-      )
-    );
-
-  }
-  
-  void handle_receive( const boost::system::error_code& ec, std::size_t bytes_transferred ) {
-    if ( !ec ) {
-      
-      std::cout << "client udp received " << bytes_transferred << "bytes" << std::endl;
-      
-      start_receive();  // start over again
-    }
-  }
-  
-  void start_receive() {
-    m_socket.async_receive_from(
-      asio::buffer( m_bufReceive ),
-      m_endpointRemote,
-      boost::bind(
-        &client_udp::handle_receive, this,
-        asio::placeholders::error,
-        asio::placeholders::bytes_transferred
-      )
-    );
-  }
-  
-  void start() {
-      
-  }
-  
-};
-
-//  ==============
-
 // Data may be read from or written to a connected TCP socket using the 
 //  receive(), async_receive(), send() or async_send() member functions. 
 // However, as these could result in short writes or reads, 
@@ -210,13 +139,15 @@ private:
 class client_tcp {
 public:
   client_tcp( asio::io_context& io_context, short port )
-    : m_acceptor( io_context, ip::tcp::endpoint( ip::tcp::v4(), port ) )
+    : m_io_context( io_context ),
+      m_acceptor( io_context, ip::tcp::endpoint( ip::tcp::v4(), port ) )
   {
     start_accept(); // accept first connection
   }
 
 private:
   
+  asio::io_context& m_io_context;
   ip::tcp::acceptor m_acceptor;
   
   void handle_accept( session::pointer new_connection, const boost::system::error_code& ec ) {
@@ -230,7 +161,7 @@ private:
   }
   
   void start_accept() {
-    session::pointer new_connection = session::create( m_acceptor.get_executor().context() );
+    session::pointer new_connection = session::create( m_io_context );
     
     m_acceptor.async_accept( 
       new_connection->socket(),
@@ -248,49 +179,116 @@ int main( int argc, char* argv[] ) {
   //int port( 53 ); // default but can be over-written
   std::string host( "127.0.0.1" );
   std::string port( "53" );
-    
-  asio::io_context io_context;
 
-  // https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/signals.html
-  boost::asio::signal_set signals( io_context, SIGINT, SIGTERM );
-  signals.async_wait( []( const boost::system::error_code& error, int signal_number ){
-    if ( !error ) {
-      switch ( signal_number ) {
-        default:
-          std::cerr << "signal " << signal_number << " received." << std::endl;
-          break;
-      }
+  loadgen_config config;
+  std::vector<std::string> vQuestion;  // "<name>[/<type>]"
+  resolver::options_t optionsStub;
+
+  const char* szUsage =
+    "Usage: client (-q <name>[/<type>] ... | -f <query file> (-Q <qps> | -c <outstanding>) [-t <threads>] [-s <sockets>]"
+    " [-l <seconds>] [-w <timeout ms>]) [-e <edns udp size>] <host> <port>";
+  int opt;
+  while ( -1 != ( opt = getopt( argc, argv, "q:f:Q:c:t:s:l:w:e:" ) ) ) {
+    switch ( opt ) {
+      case 'q': vQuestion.push_back( optarg ); break;
+      case 'f': config.sQueryFile = optarg; break;
+      case 'Q': config.qps = std::atof( optarg ); break;
+      case 'c': config.nOutstanding = std::max( 0, std::atoi( optarg ) ); break;
+      case 't': config.nThreads = std::max( 1, std::atoi( optarg ) ); break;
+      case 's': config.nSockets = std::max( 1, std::atoi( optarg ) ); break;
+      case 'l': config.seconds = std::atof( optarg ); break;
+      case 'w': config.msTimeout = std::max( 1, std::atoi( optarg ) ); break;
+      case 'e':
+        config.nEdnsPayload = optionsStub.nEdnsPayload = std::min( 0xffff, std::max( 512, std::atoi( optarg ) ) );
+        break;
+      default:
+        std::cerr << szUsage << std::endl;
+        return 1;
     }
-  } );
+  }
   
-  switch ( argc ) {
-    case 1: // no parameters
+  switch ( argc - optind ) {
+    case 0: // no parameters
       break;
-    case 2: // host only
-      host = std::string( argv[ 1 ] );
+    case 1: // host only
+      host = std::string( argv[ optind ] );
       break;
-    case 3: // host, port
-      host = std::string( argv[ 1 ] );
-      port = std::string(argv[ 2 ]);
+    case 2: // host, port
+      host = std::string( argv[ optind ] );
+      port = std::string( argv[ optind + 1 ] );
       break;
     default:
-      std::cerr << "Usage: client <host> <port> (default " << host << ", " << port << ")" << std::endl;;
+      std::cerr << szUsage << " (default " << host << ", " << port << ")" << std::endl;;
       break;
   }
-  
-  std::cerr << "client using port " << port << "." << std::endl;;
-  
+
+  if ( !config.sQueryFile.empty() ) { // benchmark
+    config.sHost = host;
+    config.sPort = port;
+    loadgen lg( config );
+    return lg.Run();
+  }
+    
+  if ( vQuestion.empty() ) {
+    std::cerr << szUsage << std::endl;
+    return 1;
+  }
+
+  asio::io_context io_context;
+  int status( 0 );
+
   try   {
 
-    //client_tcp tcpClient( io_context, port );
-    client_udp udpClient( io_context, host, port );
-    //client_icmp icmpClient( io_context );
+    ip::udp::resolver lookup( io_context );
+    const ip::udp::endpoint endpoint( *lookup.resolve( ip::udp::v4(), host, port ).begin() );
+    resolver stub( io_context, endpoint, optionsStub );
+
+    // https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/signals.html
+    boost::asio::signal_set signals( io_context, SIGINT, SIGTERM );
+    signals.async_wait( [&stub]( const boost::system::error_code& error, int signal_number ){
+      if ( !error ) {
+        std::cerr << "signal " << signal_number << " received." << std::endl;
+        stub.shutdown();
+      }
+    } );
+
+    std::size_t nPending( vQuestion.size() );
+    for ( const std::string& sQuestion: vQuestion ) {
+      const std::size_t ixSlash = sQuestion.find( '/' );
+      const std::string sName( sQuestion.substr( 0, ixSlash ) );
+      uint16_t type( dns::type::A );
+      if ( ( std::string::npos != ixSlash ) && !query::Type( sQuestion.substr( ixSlash + 1 ), type ) ) {
+        std::cerr << sQuestion << ": bad type" << std::endl;
+        return 1;
+      }
+      stub.query( sName, type,
+        [sQuestion, &nPending, &status, &signals, &stub]( const boost::system::error_code& ec, const resolver::response_t& response ){
+          if ( ec ) {
+            std::cout << sQuestion << ": " << ec.message() << std::endl;
+            status = 1;
+          }
+          else {
+            std::cout
+              << sQuestion << ": " << query::Rcode( response[ 3 ] & 0x0f )
+              << ( ( 0 != ( dns::flag::AA & dns::get16( &response[ 2 ] ) ) ) ? " aa" : "" )
+              << ", answers " << dns::get16( &response[ 6 ] )
+              << ", authority " << dns::get16( &response[ 8 ] )
+              << ", additional " << dns::get16( &response[ 10 ] )
+              << ", " << response.size() << " octets" << std::endl;
+          }
+          if ( 0 == --nPending ) {
+            signals.cancel();
+            stub.shutdown();
+          }
+        } );
+    }
 
     io_context.run();
   }
   catch ( std::exception& e )   {
     std::cerr << "Exception: " << e.what() << std::endl;
+    status = 1;
   }
 
-  return 0;
+  return status;
 }
@@ -35,7 +35,11 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/main.o
+	${OBJECTDIR}/latency_histogram.o \
+	${OBJECTDIR}/loadgen.o \
+	${OBJECTDIR}/main.o \
+	${OBJECTDIR}/query.o \
+	${OBJECTDIR}/resolver.o
 
 
 # C Compiler Flags
@@ -64,10 +68,30 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/client: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/client ${OBJECTFILES} ${LDLIBSOPTIONS}
 
+${OBJECTDIR}/latency_histogram.o: latency_histogram.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I/usr/local/include -I../server -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/latency_histogram.o latency_histogram.cpp
+
+${OBJECTDIR}/loadgen.o: loadgen.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I/usr/local/include -I../server -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/loadgen.o loadgen.cpp
+
 ${OBJECTDIR}/main.o: main.cpp
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
-	$(COMPILE.cc) -g -D_DEBUG -I/usr/local/include -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+	$(COMPILE.cc) -g -D_DEBUG -I/usr/local/include -I../server -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+
+${OBJECTDIR}/query.o: query.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I/usr/local/include -I../server -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/query.o query.cpp
+
+${OBJECTDIR}/resolver.o: resolver.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I/usr/local/include -I../server -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/resolver.o resolver.cpp
 
 # Subprojects
 .build-subprojects:
@@ -0,0 +1,94 @@
+/*
+ * File:   query.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 2:15 PM
+ */
+
+#include <cctype>
+
+#include "dns.h"
+#include "query.h"
+
+namespace {
+
+  struct type_name_t {
+    const char* sz;
+    uint16_t type;
+  };
+
+  const type_name_t rTypeName[] = {
+    { "A", dns::type::A }, { "NS", dns::type::NS }, { "CNAME", dns::type::CNAME },
+    { "SOA", dns::type::SOA }, { "PTR", dns::type::PTR }, { "MX", dns::type::MX },
+    { "TXT", dns::type::TXT }, { "AAAA", dns::type::AAAA }, { "SRV", dns::type::SRV },
+    { "ANY", dns::type::ANY }
+  };
+
+  const char* rRcodeName[] = {
+    "NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED"
+  };
+
+} // namespace anonymous
+
+namespace query {
+
+bool Type( const std::string& s, uint16_t& type ) {
+  std::string sUpper( s );
+  for ( char& ch: sUpper ) ch = std::toupper( static_cast<unsigned char>( ch ) );
+  for ( const type_name_t& entry: rTypeName ) {
+    if ( sUpper == entry.sz ) {
+      type = entry.type;
+      return true;
+    }
+  }
+  const std::string sNumber( ( 0 == sUpper.compare( 0, 4, "TYPE" ) ) ? sUpper.substr( 4 ) : sUpper );
+  if ( sNumber.empty() || ( 5 < sNumber.size() )
+    || ( std::string::npos != sNumber.find_first_not_of( "0123456789" ) ) ) return false;
+  const unsigned long n = std::stoul( sNumber );
+  if ( 0xffff < n ) return false;
+  type = static_cast<uint16_t>( n );
+  return true;
+}
+
+bool Encode( const std::string& sName, uint16_t type, uint16_t cls, wire_t& query ) {
+
+  query.assign( dns::header_length, 0 );
+  dns::put16( &query[ 2 ], dns::flag::RD );
+  dns::put16( &query[ 4 ], 1 );  // qdcount
+
+  // always absolute, the root as "."
+  std::size_t ix( 0 );
+  std::size_t end( sName.size() );
+  if ( ( 0 < end ) && ( '.' == sName[ end - 1 ] ) ) end--;
+  if ( ( 0 == end ) && sName.empty() ) return false;
+  while ( ix < end ) {
+    std::size_t ixDot = sName.find( '.', ix );
+    if ( ( std::string::npos == ixDot ) || ( end < ixDot ) ) ixDot = end;
+    const std::size_t lenLabel = ixDot - ix;
+    if ( ( 0 == lenLabel ) || ( dns::max_label_length < lenLabel ) ) return false;
+    query.push_back( static_cast<uint8_t>( lenLabel ) );
+    query.insert( query.end(), sName.begin() + ix, sName.begin() + ixDot );
+    ix = ixDot + 1;
+  }
+  query.push_back( 0 );
+  if ( dns::max_name_length < query.size() - dns::header_length ) return false;
+
+  query.resize( query.size() + 4 );
+  dns::put16( &query[ query.size() - 4 ], type );
+  dns::put16( &query[ query.size() - 2 ], cls );
+  return true;
+}
+
+void Edns( uint16_t nUdpPayload, wire_t& query ) {
+  const uint8_t opt[] = { 0, 0, dns::type::OPT, uint8_t( nUdpPayload >> 8 ), uint8_t( nUdpPayload ), 0, 0, 0, 0, 0, 0 };
+  query.insert( query.end(), opt, opt + sizeof( opt ) );
+  dns::put16( &query[ 10 ], dns::get16( &query[ 10 ] ) + 1 ); // arcount
+}
+
+std::string Rcode( uint8_t rcode ) {
+  if ( rcode < sizeof( rRcodeName ) / sizeof( rRcodeName[ 0 ] ) ) return rRcodeName[ rcode ];
+  return "RCODE" + std::to_string( rcode );
+}
+
+} // namespace query
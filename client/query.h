@@ -0,0 +1,38 @@
+/*
+ * File:   query.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 2:15 PM
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Building queries from presentation format, shared by the load generator and
+// the resolver.
+
+namespace query {
+
+typedef std::vector<uint8_t> wire_t;
+
+// a mnemonic (A, MX, ...), TYPEnnn or a plain number
+bool Type( const std::string&, uint16_t& type );
+
+// a header with RD and id 0, then one question; false for a bad name
+//   (empty or oversized label, over 255 octets; no escapes)
+bool Encode( const std::string& sName, uint16_t type, uint16_t cls, wire_t& query );
+
+// append an OPT record advertising nUdpPayload (RFC 6891), DO clear
+void Edns( uint16_t nUdpPayload, wire_t& query );
+
+// the name of an rcode, or "RCODEn"
+std::string Rcode( uint8_t rcode );
+
+} // namespace query
+
+#endif /* QUERY_H */
@@ -0,0 +1,251 @@
+/*
+ * File:   resolver.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 2:30 PM
+ */
+
+#include <array>
+#include <chrono>
+#include <algorithm>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "dns.h"
+#include "resolver.h"
+
+namespace asio = boost::asio;
+namespace ip = boost::asio::ip;
+
+struct resolver::socket_t {
+  ip::udp::socket socket;
+  uint16_t port;
+  std::array<uint8_t, 65535> buf;
+  explicit socket_t( asio::io_context& io_context ): socket( io_context ), port( 0 ) {}
+};
+
+struct resolver::query_t {
+  query::wire_t request;
+  fCompletion_t fCompletion;
+  asio::steady_timer timer;
+  socket_t* pSocket;
+  uint32_t key;
+  unsigned nSent;
+  unsigned msTimeout;
+  bool bDone;
+  // after truncation
+  std::unique_ptr<ip::tcp::socket> pTcp;
+  std::array<uint8_t, 2> bufLength;
+  response_t response;
+  query_t( asio::io_context& io_context, fCompletion_t&& fCompletion_ )
+  : fCompletion( std::move( fCompletion_ ) ), timer( io_context ),
+    pSocket( nullptr ), key( 0 ), nSent( 0 ), msTimeout( 0 ), bDone( false )
+  {}
+};
+
+resolver::resolver( asio::io_context& io_context, const ip::udp::endpoint& server, const options_t& options )
+: m_io_context( io_context ), m_endpointServer( server ), m_options( options ),
+  m_ixSocket( 0 ), m_bShutdown( false ), m_rng( std::random_device()() )
+{
+  for ( unsigned ix = 0; ix < std::max( 1u, m_options.nSockets ); ix++ ) {
+    m_vSocket.emplace_back( new socket_t( m_io_context ) );
+    socket_t& socket( *m_vSocket.back() );
+    socket.socket.open( m_endpointServer.protocol() );
+    socket.socket.connect( m_endpointServer );  // an ephemeral port, and replies from the server only
+    socket.port = socket.socket.local_endpoint().port();
+    StartReceive( socket );
+  }
+}
+
+resolver::~resolver() {
+  shutdown();
+}
+
+void resolver::shutdown() {
+  m_bShutdown = true; // first:  a completion below asking again is refused, rather than left on a closing socket
+  decltype( m_mapOutstanding ) mapOutstanding;
+  mapOutstanding.swap( m_mapOutstanding );
+  for ( auto& pair: mapOutstanding ) Complete( pair.second, asio::error::operation_aborted );
+  for ( auto& pSocket: m_vSocket ) { // kept until destruction, a receive handler may be on the stack
+    boost::system::error_code ec;
+    pSocket->socket.close( ec );
+  }
+}
+
+void resolver::query( const std::string& sName, uint16_t type, fCompletion_t fCompletion ) {
+  query( sName, type, dns::cls::IN, std::move( fCompletion ) );
+}
+
+void resolver::query( const std::string& sName, uint16_t type, uint16_t cls, fCompletion_t fCompletion ) {
+
+  pQuery_t pQuery = std::make_shared<query_t>( m_io_context, std::move( fCompletion ) );
+
+  boost::system::error_code ec;
+  if ( m_bShutdown ) ec = asio::error::operation_aborted;
+  else if ( !query::Encode( sName, type, cls, pQuery->request ) ) ec = asio::error::invalid_argument;
+  else if ( 0 != m_options.nEdnsPayload ) query::Edns( m_options.nEdnsPayload, pQuery->request );
+  if ( ec ) { // never from within the call
+    asio::post( m_io_context, [pQuery, ec](){ pQuery->fCompletion( ec, response_t() ); } );
+    return;
+  }
+
+  socket_t& socket( *m_vSocket[ m_ixSocket ] );
+  if ( m_vSocket.size() == ++m_ixSocket ) m_ixSocket = 0;
+
+  uint16_t id;
+  do {
+    id = static_cast<uint16_t>( m_rng() );
+  } while ( m_mapOutstanding.end() != m_mapOutstanding.find( Key( socket.port, id ) ) );
+
+  dns::put16( pQuery->request.data(), id );
+  pQuery->pSocket = &socket;
+  pQuery->key = Key( socket.port, id );
+  pQuery->msTimeout = m_options.msTimeout;
+  m_mapOutstanding.emplace( pQuery->key, pQuery );
+
+  Send( pQuery );
+}
+
+void resolver::Send( pQuery_t pQuery ) {
+
+  pQuery->nSent++;
+  pQuery->pSocket->socket.async_send(
+    asio::buffer( pQuery->request ),
+    [pQuery]( const boost::system::error_code&, std::size_t ){} ); // a failed send is as good as lost
+
+  pQuery->timer.expires_after( std::chrono::milliseconds( pQuery->msTimeout ) );
+  pQuery->timer.async_wait( [this, pQuery]( const boost::system::error_code& ec ){
+    if ( ec || pQuery->bDone ) return;
+    if ( m_options.nAttempts <= pQuery->nSent ) {
+      Complete( pQuery, asio::error::timed_out );
+    }
+    else {
+      pQuery->msTimeout = std::min( 2 * pQuery->msTimeout, m_options.msTimeoutMax );
+      Send( pQuery );
+    }
+  } );
+}
+
+void resolver::StartReceive( socket_t& socket ) {
+  socket.socket.async_receive(
+    asio::buffer( socket.buf ),
+    [this, &socket]( const boost::system::error_code& ec, std::size_t length ){
+      if ( m_bShutdown ) return;
+      if ( !ec ) Received( socket, length );
+      if ( !m_bShutdown ) StartReceive( socket ); // icmp unreachable shows up as an error, keep listening
+    } );
+}
+
+void resolver::Received( socket_t& socket, std::size_t length ) {
+
+  if ( dns::header_length > length ) return;
+  const uint8_t* pResponse = socket.buf.data();
+
+  auto iter = m_mapOutstanding.find( Key( socket.port, dns::get16( pResponse ) ) );
+  if ( m_mapOutstanding.end() == iter ) return; // late, duplicate or forged
+  pQuery_t pQuery = iter->second;
+  if ( pQuery->pTcp ) return; // already gone to tcp
+
+  const uint16_t flags = dns::get16( pResponse + 2 );
+  if ( ( 0 == ( dns::flag::QR & flags ) ) || !SameQuestion( pQuery->request, pResponse, length ) ) return;
+
+  if ( 0 != ( dns::flag::TC & flags ) ) {
+    StartTcp( pQuery );
+  }
+  else {
+    Complete( pQuery, boost::system::error_code(), response_t( pResponse, pResponse + length ) );
+  }
+}
+
+void resolver::StartTcp( pQuery_t pQuery ) {
+
+  pQuery->pTcp.reset( new ip::tcp::socket( m_io_context ) );
+  pQuery->timer.expires_after( std::chrono::milliseconds( m_options.msTimeoutTcp ) );
+  pQuery->timer.async_wait( [this, pQuery]( const boost::system::error_code& ec ){
+    if ( ec || pQuery->bDone ) return;
+    Complete( pQuery, asio::error::timed_out ); // closes the socket, which ends the rest
+  } );
+
+  dns::put16( pQuery->bufLength.data(), pQuery->request.size() );
+
+  const ip::tcp::endpoint endpoint( m_endpointServer.address(), m_endpointServer.port() );
+  pQuery->pTcp->async_connect( endpoint, [this, pQuery]( const boost::system::error_code& ec ){
+    if ( pQuery->bDone ) return;
+    if ( ec ) {
+      Complete( pQuery, ec );
+      return;
+    }
+    const std::array<asio::const_buffer, 2> buffers = {
+      asio::buffer( pQuery->bufLength ), asio::buffer( pQuery->request ) };
+    asio::async_write( *pQuery->pTcp, buffers, [this, pQuery]( const boost::system::error_code& ec, std::size_t ){
+      if ( pQuery->bDone ) return;
+      if ( ec ) {
+        Complete( pQuery, ec );
+        return;
+      }
+      asio::async_read( *pQuery->pTcp, asio::buffer( pQuery->bufLength ), [this, pQuery]( const boost::system::error_code& ec, std::size_t ){
+        if ( pQuery->bDone ) return;
+        if ( ec ) {
+          Complete( pQuery, ec );
+          return;
+        }
+        pQuery->response.resize( dns::get16( pQuery->bufLength.data() ) );
+        asio::async_read( *pQuery->pTcp, asio::buffer( pQuery->response ), [this, pQuery]( const boost::system::error_code& ec, std::size_t ){
+          if ( pQuery->bDone ) return;
+          const response_t& response( pQuery->response );
+          if ( ec ) Complete( pQuery, ec );
+          else if (
+               ( dns::header_length > response.size() )
+            || ( dns::get16( response.data() ) != dns::get16( pQuery->request.data() ) )
+            || !SameQuestion( pQuery->request, response.data(), response.size() )
+          ) {
+            Complete( pQuery, asio::error::message_size ); // not the answer to this question
+          }
+          else Complete( pQuery, boost::system::error_code(), response );
+        } );
+      } );
+    } );
+  } );
+}
+
+void resolver::Complete( pQuery_t pQuery, const boost::system::error_code& ec, const response_t& response ) {
+
+  if ( pQuery->bDone ) return;
+  pQuery->bDone = true;
+
+  auto iter = m_mapOutstanding.find( pQuery->key );
+  if ( ( m_mapOutstanding.end() != iter ) && ( pQuery == iter->second ) ) m_mapOutstanding.erase( iter );
+
+  pQuery->timer.cancel();
+  if ( pQuery->pTcp ) {
+    boost::system::error_code ecClose;
+    pQuery->pTcp->close( ecClose );
+  }
+
+  fCompletion_t fCompletion;
+  fCompletion.swap( pQuery->fCompletion ); // whatever it holds goes when it returns
+  fCompletion( ec, response );
+}
+
+bool resolver::SameQuestion( const query::wire_t& request, const uint8_t* pResponse, std::size_t length ) {
+
+  // the request may have an OPT after its question
+  const uint8_t* pAsked = request.data() + dns::header_length;
+  std::size_t lenName( 1 );
+  while ( 0 != pAsked[ lenName - 1 ] ) lenName += 1 + pAsked[ lenName - 1 ];
+  const std::size_t lenQuestion = lenName + 4;
+  if ( ( 1 != dns::get16( pResponse + 4 ) ) || ( dns::header_length + lenQuestion > length ) ) return false;
+
+  // the name ignoring case, the server may echo it otherwise; type and class exactly
+  const uint8_t* pGot = pResponse + dns::header_length;
+  const auto fold = []( uint8_t ch ){ return ( ( 'A' <= ch ) && ( 'Z' >= ch ) ) ? ch | 0x20 : ch; };
+  for ( std::size_t ix = 0; ix < lenName; ix++ ) {
+    if ( fold( pAsked[ ix ] ) != fold( pGot[ ix ] ) ) return false;
+  }
+  return std::equal( pAsked + lenName, pAsked + lenQuestion, pGot + lenName );
+}
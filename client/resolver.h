@@ -0,0 +1,113 @@
+/*
+ * File:   resolver.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 2:30 PM
+ */
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <random>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include "query.h"
+
+// Asynchronous stub resolver:  many queries in flight to one server, sharing a
+// few connected udp sockets, each run on the caller's io_context.
+//
+// Outstanding queries are kept by source port and transaction id (random), a
+// reply is taken only when both match and its question is the one asked.  An
+// unanswered query is sent again with the timeout doubled each time; a reply
+// with TC set is asked again over tcp.  Completion is a callback, or any asio
+// completion token through async_query (use_future, use_awaitable, ...).
+//
+// Handlers run on the io_context; the resolver has to outlive them.  shutdown()
+// finishes whatever is in flight with operation_aborted and closes the sockets,
+// so the io_context can run out of work.
+
+class resolver {
+public:
+
+  typedef query::wire_t response_t;
+  typedef std::function<void( const boost::system::error_code&, const response_t& )> fCompletion_t;
+
+  struct options_t {
+    unsigned nSockets;     // source ports
+    unsigned msTimeout;    // first udp attempt, doubled for each retry
+    unsigned msTimeoutMax;
+    unsigned nAttempts;    // udp sends, in all
+    unsigned msTimeoutTcp; // connect, send and receive together
+    uint16_t nEdnsPayload; // an OPT advertising this size on each query, 0 for none
+    options_t(): nSockets( 4 ), msTimeout( 400 ), msTimeoutMax( 3200 ), nAttempts( 4 ), msTimeoutTcp( 5000 ), nEdnsPayload( 0 ) {}
+  };
+
+  resolver( boost::asio::io_context&, const boost::asio::ip::udp::endpoint& server, const options_t& = options_t() );
+  ~resolver();
+
+  // error_code is timed_out after the last attempt, invalid_argument for a bad
+  //   name;  on success, the whole reply, any rcode
+  void query( const std::string& sName, uint16_t type, fCompletion_t );
+  void query( const std::string& sName, uint16_t type, uint16_t cls, fCompletion_t );
+
+  template<typename CompletionToken>
+  auto async_query( const std::string& sName, uint16_t type, CompletionToken&& token )
+    -> BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void( boost::system::error_code, response_t ) )
+  {
+    return boost::asio::async_initiate<CompletionToken, void( boost::system::error_code, response_t )>(
+      [this, sName, type]( auto handler ){
+        // fCompletion_t needs something copyable
+        auto pHandler = std::make_shared<decltype( handler )>( std::move( handler ) );
+        query( sName, type, [pHandler]( const boost::system::error_code& ec, const response_t& response ){
+          ( *pHandler )( ec, response );
+        } );
+      },
+      token );
+  }
+
+  void shutdown(); // may be called from a completion
+
+  std::size_t outstanding() const { return m_mapOutstanding.size(); }
+
+private:
+
+  struct query_t;
+  typedef std::shared_ptr<query_t> pQuery_t;
+
+  struct socket_t;
+
+  boost::asio::io_context& m_io_context;
+  const boost::asio::ip::udp::endpoint m_endpointServer;
+  const options_t m_options;
+
+  std::vector<std::unique_ptr<socket_t> > m_vSocket;
+  std::size_t m_ixSocket;  // round robin
+  bool m_bShutdown;
+
+  // source port << 16 | id
+  std::unordered_map<uint32_t, pQuery_t> m_mapOutstanding;
+
+  std::mt19937 m_rng;
+
+  static uint32_t Key( uint16_t port, uint16_t id ) { return ( uint32_t( port ) << 16 ) | id; }
+
+  void Send( pQuery_t );
+  void StartReceive( socket_t& );
+  void Received( socket_t&, std::size_t length );
+  void StartTcp( pQuery_t );
+  void Complete( pQuery_t, const boost::system::error_code&, const response_t& = response_t() );
+
+  static bool SameQuestion( const query::wire_t& request, const uint8_t* pResponse, std::size_t length );
+};
+
+#endif /* RESOLVER_H */
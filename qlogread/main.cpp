@@ -0,0 +1,240 @@
+/*
+ * File:   main.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 24, 2026, 11:15 AM
+ */
+
+// qlogread:  decode the segments written by 'server -q', a line per frame,
+//   or with -s counts by transport, qtype and rcode over all of them
+
+#include <map>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <getopt.h>
+#include <arpa/inet.h>
+
+#include "dns.h"
+#include "dns_parse.h"
+#include "query_log.h"
+
+namespace {
+
+  const char* rType[] = { "query", "response" };
+  const char* rTransport[] = { "udp", "tcp" };
+  const char* rRcode[] = {
+    "NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED", "YXDOMAIN", "YXRRSET",
+    "NXRRSET", "NOTAUTH", "NOTZONE", "RCODE11", "RCODE12", "RCODE13", "RCODE14", "RCODE15" };
+
+  std::string Qtype( uint16_t qtype ) {
+    switch ( qtype ) {
+      case dns::type::A: return "A";
+      case dns::type::NS: return "NS";
+      case dns::type::CNAME: return "CNAME";
+      case dns::type::SOA: return "SOA";
+      case dns::type::PTR: return "PTR";
+      case dns::type::MX: return "MX";
+      case dns::type::TXT: return "TXT";
+      case dns::type::AAAA: return "AAAA";
+      case dns::type::SRV: return "SRV";
+      case dns::type::ANY: return "ANY";
+      default: return "TYPE" + std::to_string( qtype );
+    }
+  }
+
+  std::string Peer( const query_log::peer_t& peer ) {
+    char sz[ INET6_ADDRSTRLEN ];
+    switch ( peer.family ) {
+      case 4:
+        inet_ntop( AF_INET, peer.addr, sz, sizeof( sz ) );
+        return std::string( sz ) + '#' + std::to_string( peer.port );
+      case 6:
+        inet_ntop( AF_INET6, peer.addr, sz, sizeof( sz ) );
+        return std::string( sz ) + '#' + std::to_string( peer.port );
+      default:
+        return "-";
+    }
+  }
+
+  std::string Time( int64_t ns ) {
+    char sz[ 48 ];
+    const time_t seconds = ns / 1000000000;
+    struct tm tm;
+    localtime_r( &seconds, &tm );
+    std::size_t len = std::strftime( sz, sizeof( sz ), "%Y-%m-%d %H:%M:%S", &tm );
+    std::snprintf( sz + len, sizeof( sz ) - len, ".%06u", unsigned( ( ns % 1000000000 ) / 1000 ) );
+    return sz;
+  }
+
+  struct summary_t {
+    uint64_t nFrames;
+    uint64_t nUnparsed;
+    uint64_t rnType[ 2 ][ 2 ]; // transport, type
+    std::map<std::string, uint64_t> mapQtype;   // of queries
+    uint64_t rnRcode[ 16 ];                     // of responses
+    int64_t nsFirst;
+    int64_t nsLast;
+    summary_t(): nFrames( 0 ), nUnparsed( 0 ), rnType{}, rnRcode{}, nsFirst( 0 ), nsLast( 0 ) {}
+  };
+
+  void Line( const query_log::frame_t& frame, const uint8_t* pMessage ) {
+
+    std::cout
+      << Time( frame.ns ) << " [" << frame.worker << "] "
+      << rTransport[ frame.transport & 1 ] << ' ' << Peer( frame.peer ) << ' ' << rType[ frame.type - 1 ];
+
+    dns::message_view message;
+    const dns::parse_status status = message.parse( pMessage, pMessage + frame.lenMessage );
+    if ( dns::parse_status::short_header == status ) {
+      std::cout << " short, " << frame.lenMessage << " octets" << std::endl;
+      return;
+    }
+    const dns::header_view& header( message.header() );
+    std::cout << " id " << header.id();
+    if ( 0 < header.qdcount() && ( dns::parse_status::ok == status ) ) {
+      std::cout << ' ' << message.question().name.to_string() << ' ' << Qtype( message.question().qtype );
+    }
+    if ( query_log::response == frame.type ) {
+      std::cout
+        << ' ' << rRcode[ header.rcode() ]
+        << " an " << header.ancount() << " ns " << header.nscount() << " ar " << header.arcount();
+      if ( header.tc() ) std::cout << " tc";
+    }
+    else {
+      if ( header.rd() ) std::cout << " rd";
+      const dns::edns_view edns( message.edns() );
+      if ( edns.present() ) std::cout << " edns " << edns.udp_payload << ( edns.dnssec_ok ? " do" : "" );
+    }
+    if ( dns::parse_status::ok != status ) std::cout << " malformed";
+    std::cout << ", " << frame.lenMessage << " octets" << std::endl;
+  }
+
+  void Count( const query_log::frame_t& frame, const uint8_t* pMessage, summary_t& summary ) {
+    if ( 0 == summary.nFrames++ ) summary.nsFirst = frame.ns;
+    summary.nsLast = std::max( summary.nsLast, frame.ns );
+    summary.rnType[ frame.transport & 1 ][ frame.type - 1 ]++;
+    dns::message_view message;
+    if ( dns::parse_status::ok != message.parse( pMessage, pMessage + frame.lenMessage ) ) {
+      summary.nUnparsed++;
+      return;
+    }
+    if ( query_log::query == frame.type ) {
+      if ( 0 < message.header().qdcount() ) summary.mapQtype[ Qtype( message.question().qtype ) ]++;
+    }
+    else summary.rnRcode[ message.header().rcode() ]++;
+  }
+
+  // every frame of the segment;  false on one that could not be read at all
+  bool Read( const std::string& sPath, bool bSummary, summary_t& summary ) {
+
+    std::ifstream ifs( sPath, std::ios::binary );
+    if ( !ifs ) {
+      std::cerr << sPath << ": " << std::strerror( errno ) << std::endl;
+      return false;
+    }
+    const std::vector<uint8_t> v( ( std::istreambuf_iterator<char>( ifs ) ), std::istreambuf_iterator<char>() );
+
+    query_log::segment_t header;
+    if ( v.size() < sizeof( header ) ) {
+      std::cerr << sPath << ": too short for a segment" << std::endl;
+      return false;
+    }
+    std::memcpy( &header, v.data(), sizeof( header ) );
+    if ( 0 != std::memcmp( header.magic, "cppdnsql", sizeof( header.magic ) ) ) {
+      std::cerr << sPath << ": not a query log segment" << std::endl;
+      return false;
+    }
+    if ( query_log::segment_t::byte_order != header.order ) {
+      std::cerr << sPath << ": written with the other byte order" << std::endl;
+      return false;
+    }
+    if ( query_log::segment_t::current_version != header.version ) {
+      std::cerr << sPath << ": version " << header.version << " is not read" << std::endl;
+      return false;
+    }
+    if ( ( header.lenHeader < sizeof( header ) ) || ( v.size() < header.lenHeader ) ) {
+      std::cerr << sPath << ": corrupt segment header" << std::endl;
+      return false;
+    }
+
+    std::size_t ix( header.lenHeader );
+    while ( sizeof( query_log::frame_t ) <= v.size() - ix ) {
+      query_log::frame_t frame;
+      std::memcpy( &frame, &v[ ix ], sizeof( frame ) );
+      if ( 0 == frame.lenFrame ) break; // the unwritten end of a segment cut short
+      if ( ( frame.lenFrame < sizeof( frame ) + frame.lenMessage ) || ( v.size() - ix < frame.lenFrame )
+        || ( ( query_log::query != frame.type ) && ( query_log::response != frame.type ) ) ) {
+        std::cerr << sPath << ": corrupt frame at offset " << ix << std::endl;
+        break;
+      }
+      const uint8_t* pMessage = &v[ ix + sizeof( frame ) ];
+      if ( bSummary ) Count( frame, pMessage, summary );
+      else Line( frame, pMessage );
+      ix += frame.lenFrame;
+    }
+    return true;
+  }
+
+  void Report( const summary_t& summary ) {
+    std::cout << summary.nFrames << " frames";
+    if ( 0 != summary.nFrames ) {
+      std::cout << ", " << Time( summary.nsFirst ) << " to " << Time( summary.nsLast );
+    }
+    std::cout << std::endl;
+    for ( unsigned ixTransport = 0; ixTransport < 2; ixTransport++ ) {
+      std::cout
+        << std::left << std::setw( 10 ) << rTransport[ ixTransport ] << std::right
+        << std::setw( 12 ) << summary.rnType[ ixTransport ][ 0 ] << " queries"
+        << std::setw( 12 ) << summary.rnType[ ixTransport ][ 1 ] << " responses" << std::endl;
+    }
+    for ( const auto& pair: summary.mapQtype ) {
+      std::cout << std::left << std::setw( 10 ) << pair.first << std::right << std::setw( 12 ) << pair.second << std::endl;
+    }
+    for ( unsigned ixRcode = 0; ixRcode < 16; ixRcode++ ) {
+      if ( 0 == summary.rnRcode[ ixRcode ] ) continue;
+      std::cout << std::left << std::setw( 10 ) << rRcode[ ixRcode ] << std::right << std::setw( 12 ) << summary.rnRcode[ ixRcode ] << std::endl;
+    }
+    if ( 0 != summary.nUnparsed ) std::cout << summary.nUnparsed << " messages did not parse" << std::endl;
+  }
+
+} // namespace anonymous
+
+int main( int argc, char* argv[] ) {
+
+  const char* szUsage = "Usage: qlogread [-s] <segment> ...";
+
+  bool bSummary( false );
+  int opt;
+  while ( -1 != ( opt = getopt( argc, argv, "s" ) ) ) {
+    switch ( opt ) {
+      case 's':
+        bSummary = true;
+        break;
+      default:
+        std::cerr << szUsage << std::endl;
+        return 1;
+    }
+  }
+  if ( optind == argc ) {
+    std::cerr << szUsage << std::endl;
+    return 1;
+  }
+
+  summary_t summary;
+  int status( 0 );
+  for ( int ix = optind; ix < argc; ix++ ) {
+    if ( !Read( argv[ ix ], bSummary, summary ) ) status = 1;
+  }
+  if ( bSummary ) Report( summary );
+
+  return status;
+}
@@ -0,0 +1,50 @@
+/*
+ * File:   allocations.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 22, 2026, 10:40 AM
+ */
+
+#include <new>
+#include <cstdlib>
+
+#include "allocations.h"
+
+namespace {
+  thread_local metrics::counter* tl_pCounter = nullptr; // constant initialized, no guard
+}
+
+namespace allocations {
+
+metrics::counter* Exchange( metrics::counter* pCounter ) {
+  metrics::counter* pPrevious( tl_pCounter );
+  tl_pCounter = pCounter;
+  return pPrevious;
+}
+
+} // namespace allocations
+
+// libstdc++ routes the array and nothrow forms through these;  the sized
+//   delete is replaced along with the unsized, as -Wsized-deallocation asks;
+//   the aligned forms are left alone, nothing on the query path uses them
+
+void* operator new( std::size_t size ) {
+  if ( nullptr != tl_pCounter ) tl_pCounter->add();
+  if ( 0 == size ) size = 1;
+  while ( true ) {
+    void* p = std::malloc( size );
+    if ( nullptr != p ) return p;
+    const std::new_handler handler = std::get_new_handler();
+    if ( nullptr == handler ) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void operator delete( void* p ) noexcept {
+  std::free( p );
+}
+
+void operator delete( void* p, std::size_t /* size */ ) noexcept {
+  std::free( p );
+}
@@ -0,0 +1,36 @@
+/*
+ * File:   allocations.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 22, 2026, 10:40 AM
+ */
+
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include "metrics.h"
+
+// The global operator new is replaced (allocations.cpp) to count allocations
+// against a counter of the calling thread, while one is set.  A scope around a
+// handler counts what that handler allocates, so the query path can be seen
+// to stay off the heap in steady state.  Everything else costs one thread
+// local test per allocation.
+
+namespace allocations {
+
+metrics::counter* Exchange( metrics::counter* ); // this thread's, returns the previous one
+
+class scope {
+public:
+  explicit scope( metrics::counter& counter ): m_pPrevious( Exchange( &counter ) ) {}
+  ~scope() { Exchange( m_pPrevious ); }
+  scope( const scope& ) = delete;
+  scope& operator=( const scope& ) = delete;
+private:
+  metrics::counter* m_pPrevious;
+};
+
+} // namespace allocations
+
+#endif /* ALLOCATIONS_H */
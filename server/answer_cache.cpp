@@ -0,0 +1,321 @@
+/*
+ * File:   answer_cache.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 1:40 PM
+ */
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include "name_kernels.h"
+#include "answer_cache.h"
+
+namespace {
+  enum { entry_bytes = 256 }; // a typical entry, for the count out of the budget
+}
+
+answer_cache::answer_cache( const options_t& options, metrics::worker_metrics& metrics_ )
+  : m_options( options ), m_ixFree( none ), m_maskIndex( 0 ), m_maskGhost( 0 ),
+    m_metrics( metrics_ ), m_nBytesReported( 0 )
+{
+  std::size_t nEntries( 64 );
+  while ( nEntries * entry_bytes < m_options.nBytes ) nEntries <<= 1;
+  m_vEntry.resize( nEntries );
+  m_vIndex.resize( 2 * nEntries );  // at most half full, probes stay short
+  m_maskIndex = m_vIndex.size() - 1;
+  m_vGhost.resize( nEntries );
+  m_maskGhost = m_vGhost.size() - 1;
+  Clear();
+}
+
+void answer_cache::Clear() {
+  for ( std::size_t ix = 0; ix < m_vEntry.size(); ix++ ) {
+    entry_t& entry( m_vEntry[ ix ] );
+    entry.hash = 0;
+    entry.freq = 0;
+    entry.bRefreshing = false;
+    vByte_t().swap( entry.vKey );
+    vByte_t().swap( entry.vResponse );
+    std::vector<uint16_t>().swap( entry.vTtlOffset );
+    entry.next = ( ix + 1 < m_vEntry.size() ) ? uint32_t( ix + 1 ) : uint32_t( none );
+  }
+  m_ixFree = 0;
+  std::fill( m_vIndex.begin(), m_vIndex.end(), 0 );
+  std::fill( m_vGhost.begin(), m_vGhost.end(), 0 );
+  m_small = fifo_t();
+  m_main = fifo_t();
+  Report();
+}
+
+void answer_cache::Report() {
+  m_metrics.cache_bytes.add( int64_t( bytes() ) - int64_t( m_nBytesReported ) );
+  m_nBytesReported = bytes();
+}
+
+// the question name is patched in place on a hit, so it has to be
+//   stored uncompressed at the same offset in both query and response
+bool answer_cache::Cacheable( const dns::message_view& query ) {
+  return ( 1 == query.header().qdcount() ) && !query.question().name.compressed();
+}
+
+uint32_t answer_cache::Now() {
+  return 1 + std::chrono::duration_cast<std::chrono::seconds>( // never 0
+    std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+uint64_t answer_cache::BuildKey( const dns::message_view& query, uint8_t flags, key_t& key ) {
+
+  // Cacheable():  the name is contiguous in the message, and parse validated it
+  const dns::question_view& question( query.question() );
+  uint64_t hash;
+  uint8_t* p = key.octets + dns::canonical( question.name.data(), question.name.length(), key.octets, hash );
+  dns::put16( p, question.qtype );
+  dns::put16( p + 2, question.qclass );
+  p[ 4 ] = flags;
+  key.len = p + 5 - key.octets;
+
+  hash = dns::mix( hash, ( uint64_t( question.qtype ) << 24 ) | ( uint64_t( question.qclass ) << 8 ) | flags );
+  return ( 0 == hash ) ? 1 : hash; // 0 marks a free entry
+}
+
+// what an entry holds on to, by capacity
+std::size_t answer_cache::Size( const entry_t& entry ) {
+  return sizeof( entry_t ) + entry.vKey.capacity() + entry.vResponse.capacity()
+    + entry.vTtlOffset.capacity() * sizeof( uint16_t );
+}
+
+bool answer_cache::Expired( const entry_t& entry, uint32_t tNow, uint32_t secondsGrace ) const {
+  return ( 0 != entry.ttl ) && ( tNow - entry.tInserted >= entry.ttl + secondsGrace );
+}
+
+uint32_t answer_cache::Find( uint64_t hash, const key_t& key ) const {
+  for ( std::size_t ix = hash & m_maskIndex; ; ix = ( ix + 1 ) & m_maskIndex ) {
+    const uint32_t n = m_vIndex[ ix ];
+    if ( 0 == n ) return none;
+    const entry_t& entry( m_vEntry[ n - 1 ] );
+    if ( ( hash == entry.hash )
+      && ( key.len == entry.vKey.size() )
+      && ( 0 == std::memcmp( key.octets, entry.vKey.data(), key.len ) )
+    ) {
+      return n - 1;
+    }
+  }
+}
+
+void answer_cache::IndexInsert( uint64_t hash, uint32_t ixEntry ) {
+  std::size_t ix = hash & m_maskIndex;
+  while ( 0 != m_vIndex[ ix ] ) ix = ( ix + 1 ) & m_maskIndex;
+  m_vIndex[ ix ] = ixEntry + 1;
+}
+
+// backward shift:  no tombstones, so probes stay as short as the load allows
+void answer_cache::IndexErase( uint64_t hash, uint32_t ixEntry ) {
+  std::size_t ixHole = hash & m_maskIndex;
+  while ( ixEntry + 1 != m_vIndex[ ixHole ] ) ixHole = ( ixHole + 1 ) & m_maskIndex;
+  for ( std::size_t ix = ( ixHole + 1 ) & m_maskIndex; 0 != m_vIndex[ ix ]; ix = ( ix + 1 ) & m_maskIndex ) {
+    const std::size_t ixHome = m_vEntry[ m_vIndex[ ix ] - 1 ].hash & m_maskIndex;
+    if ( ( ( ix - ixHome ) & m_maskIndex ) >= ( ( ix - ixHole ) & m_maskIndex ) ) {
+      m_vIndex[ ixHole ] = m_vIndex[ ix ];
+      ixHole = ix;
+    }
+  }
+  m_vIndex[ ixHole ] = 0;
+}
+
+void answer_cache::Push( fifo_t& fifo, uint32_t ix ) {
+  entry_t& entry( m_vEntry[ ix ] );
+  entry.next = none;
+  if ( none == fifo.last ) fifo.first = ix;
+  else m_vEntry[ fifo.last ].next = ix;
+  fifo.last = ix;
+  fifo.nBytes += Size( entry );
+}
+
+uint32_t answer_cache::Pop( fifo_t& fifo ) {
+  const uint32_t ix = fifo.first;
+  entry_t& entry( m_vEntry[ ix ] );
+  fifo.first = entry.next;
+  if ( none == fifo.first ) fifo.last = none;
+  fifo.nBytes -= Size( entry );
+  return ix;
+}
+
+void answer_cache::Free( uint32_t ix ) {
+  entry_t& entry( m_vEntry[ ix ] );
+  IndexErase( entry.hash, ix );
+  entry.hash = 0;
+  vByte_t().swap( entry.vKey );  // given back, so what is held stays within the budget
+  vByte_t().swap( entry.vResponse );
+  std::vector<uint16_t>().swap( entry.vTtlOffset );
+  entry.next = m_ixFree;
+  m_ixFree = ix;
+  m_metrics.cache_evictions.add();
+}
+
+// S3-FIFO:  small gets evicted from while it holds more than its tenth;
+//   entries hit there move to main, the others leave a ghost;  main gives
+//   entries with hits another lap, one hit fewer.  Expired entries, past the
+//   stale window, go whatever their hits.
+void answer_cache::Evict() {
+  const uint32_t tNow = Now();
+  for ( ;; ) {
+    if ( ( none != m_small.first ) && ( ( 10 * m_small.nBytes >= m_options.nBytes ) || ( none == m_main.first ) ) ) {
+      const uint32_t ix = Pop( m_small );
+      entry_t& entry( m_vEntry[ ix ] );
+      if ( ( 0 < entry.freq ) && !Expired( entry, tNow, m_options.secondsStale ) ) {
+        entry.freq = 0;
+        entry.bMain = true;
+        Push( m_main, ix );
+        continue;
+      }
+      m_vGhost[ entry.hash & m_maskGhost ] = entry.hash;
+      Free( ix );
+      return;
+    }
+    if ( none == m_main.first ) return;  // nothing left
+    const uint32_t ix = Pop( m_main );
+    entry_t& entry( m_vEntry[ ix ] );
+    if ( ( 0 < entry.freq ) && !Expired( entry, tNow, m_options.secondsStale ) ) {
+      entry.freq--;
+      Push( m_main, ix );
+      continue;
+    }
+    Free( ix );
+    return;
+  }
+}
+
+std::size_t answer_cache::Copy( const entry_t& entry, const dns::message_view& query, uint8_t* pReply, std::size_t lenReplyMax ) const {
+
+  const std::size_t lenReply = entry.vResponse.size();
+  if ( lenReplyMax < lenReply ) return 0;
+
+  const uint8_t* pQuery = query.data();
+  std::memcpy( pReply, entry.vResponse.data(), lenReply );
+  pReply[ 0 ] = pQuery[ 0 ]; // transaction id
+  pReply[ 1 ] = pQuery[ 1 ];
+  pReply[ 2 ] = ( pReply[ 2 ] & 0xfe ) | ( pQuery[ 2 ] & 0x01 ); // RD
+  std::memcpy( // question name, as the client cased it
+    pReply + dns::header_length,
+    query.question().name.data(),
+    query.question().name.length() );
+
+  return lenReply;
+}
+
+std::size_t answer_cache::Lookup( const dns::message_view& query, uint8_t flags, uint8_t* pReply, std::size_t lenReplyMax, bool& bRefresh ) {
+
+  bRefresh = false;
+  if ( !Cacheable( query ) ) return 0;
+
+  key_t key;
+  const uint64_t hash = BuildKey( query, flags, key );
+
+  const uint32_t ix = Find( hash, key );
+  if ( none != ix ) {
+    entry_t& entry( m_vEntry[ ix ] );
+    const uint32_t tNow = ( 0 == entry.ttl ) ? 0 : Now();
+    const std::size_t lenReply = Expired( entry, tNow, 0 ) ? 0 : Copy( entry, query, pReply, lenReplyMax );
+    if ( 0 != lenReply ) {
+
+      if ( freq_max > entry.freq ) entry.freq++;
+
+      if ( 0 != entry.ttl ) {
+        const uint32_t age = tNow - entry.tInserted;
+        for ( const uint16_t offset: entry.vTtlOffset ) {
+          const uint32_t ttl = dns::get32( entry.vResponse.data() + offset );
+          dns::put32( pReply + offset, ( ttl > age ) ? ttl - age : 0 );
+        }
+        if ( ( 0 != m_options.nPrefetchPercent ) && !entry.bRefreshing && ( 2 <= entry.freq )
+          && ( 100 * uint64_t( entry.ttl - age ) < uint64_t( entry.ttl ) * m_options.nPrefetchPercent )
+        ) {
+          entry.bRefreshing = true;
+          bRefresh = true;
+        }
+      }
+
+      return lenReply;
+    }
+  }
+
+  return 0;
+}
+
+std::size_t answer_cache::Stale( const dns::message_view& query, uint8_t flags, uint8_t* pReply, std::size_t lenReplyMax ) {
+
+  if ( ( 0 == m_options.secondsStale ) || !Cacheable( query ) ) return 0;
+
+  key_t key;
+  const uint64_t hash = BuildKey( query, flags, key );
+
+  const uint32_t ix = Find( hash, key );
+  if ( none == ix ) return 0;
+  const entry_t& entry( m_vEntry[ ix ] );
+  if ( ( 0 == entry.ttl ) || Expired( entry, Now(), m_options.secondsStale ) ) return 0;
+
+  const std::size_t lenReply = Copy( entry, query, pReply, lenReplyMax );
+  if ( 0 != lenReply ) {
+    for ( const uint16_t offset: entry.vTtlOffset ) dns::put32( pReply + offset, stale_ttl );
+  }
+  return lenReply;
+}
+
+void answer_cache::Insert( const dns::message_view& query, uint8_t flags, const uint8_t* pReply, std::size_t lenReply, uint32_t ttl ) {
+
+  if ( !Cacheable( query ) ) return;
+
+  key_t key;
+  const uint64_t hash = BuildKey( query, flags, key );
+
+  // where the ttls are, to count them down on a hit
+  std::vector<uint16_t> vTtlOffset;
+  if ( 0 != ttl ) {
+    dns::message_view reply;
+    if ( dns::parse_status::ok != reply.parse( pReply, pReply + lenReply ) ) return;
+    const auto scan = [pReply, &vTtlOffset]( const dns::message_view::rr_range& range ){
+      for ( const dns::rr_view& rr: range ) { // ttl, rdlength, rdata
+        if ( dns::type::OPT != rr.type ) vTtlOffset.push_back( rr.rdata - 6 - pReply );
+      }
+    };
+    scan( reply.answers() );
+    scan( reply.authority() );
+    scan( reply.additional() );
+  }
+
+  uint32_t ix = Find( hash, key );
+  if ( none != ix ) { // refreshed in place, keeping its hits and its place
+    entry_t& entry( m_vEntry[ ix ] );
+    fifo_t& fifo( entry.bMain ? m_main : m_small );
+    fifo.nBytes -= Size( entry );
+    entry.vResponse.assign( pReply, pReply + lenReply );
+    entry.vTtlOffset.swap( vTtlOffset );
+    fifo.nBytes += Size( entry );
+  }
+  else {
+    const std::size_t nBytes = sizeof( entry_t ) + key.len + lenReply + vTtlOffset.size() * sizeof( uint16_t );
+    while ( ( none == m_ixFree ) || ( ( 0 != bytes() ) && ( bytes() + nBytes > m_options.nBytes ) ) ) Evict();
+
+    ix = m_ixFree;
+    entry_t& entry( m_vEntry[ ix ] );
+    m_ixFree = entry.next;
+
+    entry.hash = hash;
+    entry.freq = 0;
+    entry.bMain = ( hash == m_vGhost[ hash & m_maskGhost ] ); // asked for again soon after eviction
+    entry.vKey.assign( key.octets, key.octets + key.len );
+    entry.vResponse.assign( pReply, pReply + lenReply );
+    entry.vTtlOffset.swap( vTtlOffset );
+    Push( entry.bMain ? m_main : m_small, ix );
+    IndexInsert( hash, ix );
+  }
+
+  entry_t& entry( m_vEntry[ ix ] );
+  entry.tInserted = Now();
+  entry.ttl = ttl;
+  entry.bRefreshing = false;
+
+  Report();
+}
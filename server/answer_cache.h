@@ -0,0 +1,143 @@
+/*
+ * File:   answer_cache.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 1:40 PM
+ */
+
+#ifndef ANSWER_CACHE_H
+#define ANSWER_CACHE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.h"
+#include "metrics.h"
+#include "dns_parse.h"
+
+// Complete encoded responses, keyed on (qname, qtype, qclass, edns flags).
+// A hit is a memcpy followed by patching the transaction id, the RD bit, and the
+// question name (so 0x20 case randomization is echoed back, and answer owner
+// names compressed against the question follow along).
+//
+// One instance per thread:  no locking.  The workers are the shards, the
+// kernel spreading clients over them (SO_REUSEPORT).
+//
+// Bounded by a byte budget (keys, responses and bookkeeping, by capacity) and
+// by an entry count derived from it, evicted S3-FIFO:  new entries go to a
+// small fifo, a tenth of the budget, and only those hit while there move on
+// to the main fifo;  the rest leave just their hash in a ghost table, and come
+// straight back into main when asked for again soon.  Main is a CLOCK:  a hit
+// bumps a two bit counter, eviction gives an entry with a count another lap.
+// So a hit never moves anything, and a flood of names asked once (a random
+// subdomain attack) churns the small fifo without touching main.
+//
+// Answers from the zone image stay until evicted.  Forwarded ones expire, and
+// their ttls are counted down on each hit.  A popular one hit near the end of
+// its ttl asks to be refreshed ahead of time;  an expired one can still be
+// served, with a short ttl, when the upstream fails (RFC 8767).
+
+class answer_cache {
+public:
+
+  enum : uint8_t { // key flags
+    edns = 0x01,  // query carried an OPT record
+    dnssec_ok = 0x02 // DO bit set in the OPT record
+  };
+
+  struct options_t {
+    std::size_t nBytes;        // budget
+    uint32_t secondsStale;     // past expiry still served on upstream failure, 0 for never
+    unsigned nPrefetchPercent; // refresh a popular entry hit with less than this much of its ttl left, 0 for never
+    options_t(): nBytes( 4 << 20 ), secondsStale( 0 ), nPrefetchPercent( 10 ) {}
+  };
+
+  // evictions and bytes held are kept up to date in metrics
+  answer_cache( const options_t&, metrics::worker_metrics& );
+
+  // for the query already parsed, copy a cached response into pReply,
+  //   returns 0 on a miss (or when the reply doesn't fit);  bRefresh is set
+  //   when the caller should ask upstream again, once, for this entry
+  std::size_t Lookup( const dns::message_view& query, uint8_t flags, uint8_t* pReply, std::size_t lenReplyMax, bool& bRefresh );
+
+  // as Lookup, for an expired answer within the stale window, ttls set to stale_ttl
+  std::size_t Stale( const dns::message_view& query, uint8_t flags, uint8_t* pReply, std::size_t lenReplyMax );
+
+  // remember the response just encoded for the query, for ttl seconds (0:  until evicted)
+  void Insert( const dns::message_view& query, uint8_t flags, const uint8_t* pReply, std::size_t lenReply, uint32_t ttl = 0 );
+
+  void Clear();
+
+  std::size_t bytes() const { return m_small.nBytes + m_main.nBytes; }
+
+  enum { stale_ttl = 30 };
+
+protected:
+private:
+
+  enum : uint32_t { none = 0xffffffff };
+  enum : uint8_t { freq_max = 3 };
+
+  struct key_t {
+    std::size_t len;
+    uint8_t octets[ dns::max_name_length + 5 ]; // lower cased name, qtype, qclass, flags
+  };
+
+  struct entry_t {
+    uint64_t hash;      // 0 when free
+    uint32_t next;      // in its fifo, or the free list
+    uint32_t tInserted; // Now()
+    uint32_t ttl;       // 0 for never expiring
+    uint8_t freq;       // hits, saturating at freq_max
+    bool bMain;         // which fifo
+    bool bRefreshing;   // asked for once, until the next Insert
+    vByte_t vKey;
+    vByte_t vResponse;
+    std::vector<uint16_t> vTtlOffset; // of each record's ttl in vResponse, when it expires
+    entry_t(): hash( 0 ), next( none ), tInserted( 0 ), ttl( 0 ), freq( 0 ), bMain( false ), bRefreshing( false ) {}
+  };
+
+  struct fifo_t {
+    uint32_t first;   // oldest
+    uint32_t last;
+    std::size_t nBytes;
+    fifo_t(): first( none ), last( none ), nBytes( 0 ) {}
+  };
+
+  const options_t m_options;
+
+  std::vector<entry_t> m_vEntry;
+  uint32_t m_ixFree;        // list through entry_t::next
+  std::vector<uint32_t> m_vIndex; // linear probing on hash, entry index + 1, 0 empty
+  std::size_t m_maskIndex;
+  std::vector<uint64_t> m_vGhost; // hashes recently evicted from small, direct mapped
+  std::size_t m_maskGhost;
+
+  fifo_t m_small;
+  fifo_t m_main;
+
+  metrics::worker_metrics& m_metrics;
+  std::size_t m_nBytesReported; // this cache's part of m_metrics.cache_bytes
+
+  void Report();
+
+  static bool Cacheable( const dns::message_view& query );
+  static uint32_t Now(); // seconds, steady
+  static uint64_t BuildKey( const dns::message_view& query, uint8_t flags, key_t& key );
+  static std::size_t Size( const entry_t& );
+
+  uint32_t Find( uint64_t hash, const key_t& key ) const; // entry index, or none
+  std::size_t Copy( const entry_t&, const dns::message_view& query, uint8_t* pReply, std::size_t lenReplyMax ) const;
+  bool Expired( const entry_t&, uint32_t tNow, uint32_t secondsGrace ) const;
+
+  void Push( fifo_t&, uint32_t ix );
+  uint32_t Pop( fifo_t& );
+  void Evict();        // one entry
+  void Free( uint32_t ix );
+  void IndexInsert( uint64_t hash, uint32_t ix );
+  void IndexErase( uint64_t hash, uint32_t ix );
+};
+
+#endif /* ANSWER_CACHE_H */
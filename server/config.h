@@ -0,0 +1,52 @@
+/*
+ * File:   config.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 3:05 PM
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <vector>
+
+#include "dns.h"
+#include "logger.h"
+
+// settings from the command line, read-only once the workers start
+
+struct config {
+
+  int port;
+  unsigned nWorkers;  // threads, each with its own io_context and udp socket
+  bool bPinWorkers;   // pin worker n to cpu n (modulo the cpu count)
+  unsigned nBatch;    // datagrams per recvmmsg/sendmmsg, 1 for one per async_receive_from
+  bool bUring;        // udp through io_uring rather than the asio reactor, when the kernel has it
+  std::string sZoneImage; // compiled by zonec, empty to refuse everything
+  std::vector<std::string> vUpstream; // <address>[:<port>] or [<v6 address>]:<port>, forwarding when any
+  unsigned short portStats;  // metrics over http on 127.0.0.1, 0 for none
+  std::string sStatsFile;    // metrics rewritten every secondsStatsFile, empty for none
+  unsigned secondsStatsFile;
+  logger::level levelLog;
+  unsigned nRrlPerSecond; // udp responses per second per client prefix and question, 0 for no limit
+  unsigned nRrlSlip;      // every nth limited response sent truncated, 0 to drop all
+  std::size_t nCacheBytes; // answer cache budget, per responder
+  unsigned secondsStale;   // expired forwarded answers served on upstream failure, 0 for never
+  unsigned nUdpPayload;    // EDNS0 size advertised, and the largest udp reply, 512 .. 4096
+  std::string sQueryLog;   // segment path prefix, every query and reply logged, empty for none
+  std::size_t nQueryLogSegmentBytes;
+  unsigned nQueryLogSegments; // kept, 0 for all
+
+  config()
+    : port( 53 ), nWorkers( 1 ), bPinWorkers( false ), nBatch( 32 ), bUring( false ),
+      portStats( 0 ), secondsStatsFile( 10 ), levelLog( logger::level::info ),
+      nRrlPerSecond( 0 ), nRrlSlip( 2 ),
+      nCacheBytes( 4 << 20 ), secondsStale( 0 ),
+      nUdpPayload( dns::edns_udp_length ),
+      nQueryLogSegmentBytes( 64 << 20 ), nQueryLogSegments( 0 )
+  {}
+};
+
+#endif /* CONFIG_H */
@@ -0,0 +1,86 @@
+/*
+ * File:   dns.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 9:05 AM
+ */
+
+#ifndef DNS_H
+#define DNS_H
+
+#include <cstdint>
+
+// https://tools.ietf.org/html/rfc1035 - wire format constants and accessors
+
+namespace dns {
+
+enum {
+  header_length = 12,
+  max_name_length = 255,   // uncompressed, including the root label
+  max_label_length = 63,
+  max_labels = 128,        // 255 octets can hold at most 127 labels + root
+  max_udp_length = 512,    // without EDNS0
+  edns_udp_length = 1232,  // advertised by default:  no fragmentation on common paths
+  max_edns_udp_length = 4096,
+  max_message_length = 0xffff // over tcp, all a two octet length prefix can carry
+};
+
+namespace type {
+  enum : uint16_t {
+    A = 1, NS = 2, CNAME = 5, SOA = 6, PTR = 12, MX = 15, TXT = 16,
+    AAAA = 28, SRV = 33, OPT = 41, ANY = 255
+  };
+}
+
+namespace cls {
+  enum : uint16_t { IN = 1, CH = 3, ANY = 255 };
+}
+
+namespace opcode {
+  enum : uint8_t { QUERY = 0, IQUERY = 1, STATUS = 2, NOTIFY = 4, UPDATE = 5 };
+}
+
+namespace rcode {
+  enum : uint8_t { NOERROR = 0, FORMERR = 1, SERVFAIL = 2, NXDOMAIN = 3, NOTIMP = 4, REFUSED = 5,
+    BADVERS = 16 // extended, the upper eight bits carried in the OPT record (RFC 6891)
+  };
+}
+
+// header flag bits, as seen in the 16 bit flags word
+namespace flag {
+  enum : uint16_t {
+    QR = 0x8000, AA = 0x0400, TC = 0x0200, RD = 0x0100,
+    RA = 0x0080, AD = 0x0020, CD = 0x0010
+  };
+}
+
+// network order accessors, no alignment assumptions
+
+inline uint16_t get16( const uint8_t* p ) {
+  return static_cast<uint16_t>( ( p[ 0 ] << 8 ) | p[ 1 ] );
+}
+
+inline uint32_t get32( const uint8_t* p ) {
+  return ( uint32_t( p[ 0 ] ) << 24 ) | ( uint32_t( p[ 1 ] ) << 16 ) | ( uint32_t( p[ 2 ] ) << 8 ) | p[ 3 ];
+}
+
+inline void put16( uint8_t* p, uint16_t value ) {
+  p[ 0 ] = static_cast<uint8_t>( value >> 8 );
+  p[ 1 ] = static_cast<uint8_t>( value );
+}
+
+inline void put32( uint8_t* p, uint32_t value ) {
+  p[ 0 ] = static_cast<uint8_t>( value >> 24 );
+  p[ 1 ] = static_cast<uint8_t>( value >> 16 );
+  p[ 2 ] = static_cast<uint8_t>( value >> 8 );
+  p[ 3 ] = static_cast<uint8_t>( value );
+}
+
+inline uint8_t to_lower( uint8_t ch ) {
+  return ( ( 'A' <= ch ) && ( 'Z' >= ch ) ) ? ch + ( 'a' - 'A' ) : ch;
+}
+
+} // namespace dns
+
+#endif /* DNS_H */
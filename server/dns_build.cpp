@@ -0,0 +1,148 @@
+/*
+ * File:   dns_build.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 10:30 AM
+ */
+
+#include "name_kernels.h"
+#include "dns_build.h"
+
+namespace dns {
+
+namespace {
+
+  // does the (possibly compressed) name at offset in the message equal the
+  //   uncompressed suffix, ignoring case
+  bool SuffixEqual( const uint8_t* pMsg, uint16_t offset, const uint8_t* pSuffix ) {
+    const uint8_t* p = pMsg + offset;
+    while ( true ) {
+      while ( 0xc0 == ( *p & 0xc0 ) ) p = pMsg + ( ( ( p[ 0 ] & 0x3f ) << 8 ) | p[ 1 ] );
+      if ( *p != *pSuffix ) return false;
+      if ( 0 == *p ) return true;
+      if ( !equal_nocase( p + 1, pSuffix + 1, *p ) ) return false;
+      pSuffix += 1 + *p;
+      p += 1 + *p;
+    }
+  }
+
+  inline uint32_t Mix( uint32_t hash, uint8_t octet ) { // FNV-1a
+    return ( hash ^ octet ) * 16777619u;
+  }
+
+} // namespace anonymous
+
+uint16_t compression_table::find( const uint8_t* pMsg, const uint8_t* pSuffix, uint32_t hash ) const {
+  for ( unsigned ix = 0; ix < probe_limit; ix++ ) {
+    const slot_t& slot( m_slot[ ( hash + ix ) & ( slots - 1 ) ] );
+    if ( 0 == slot.offset ) return 0;
+    if ( ( hash == slot.hash ) && SuffixEqual( pMsg, slot.offset, pSuffix ) ) return slot.offset;
+  }
+  return 0;
+}
+
+void compression_table::insert( uint32_t hash, uint16_t offset ) {
+  if ( ( slots * 3 / 4 ) <= m_nUsed ) return;  // keep probes short, later names just compress less
+  for ( unsigned ix = 0; ix < probe_limit; ix++ ) {
+    slot_t& slot( m_slot[ ( hash + ix ) & ( slots - 1 ) ] );
+    if ( 0 == slot.offset ) {
+      slot.hash = hash;
+      slot.offset = offset;
+      m_nUsed++;
+      return;
+    }
+  }
+}
+
+void writer::name( const uint8_t* pWire, bool bCompress ) {
+
+  // label offsets, then suffix hashes from the root outwards
+  uint8_t offsets[ max_labels ];
+  uint32_t hashes[ max_labels ];
+  unsigned nLabels( 0 );
+  for ( unsigned ix = 0; 0 != pWire[ ix ]; ix += 1 + pWire[ ix ] ) offsets[ nLabels++ ] = ix;
+  const std::size_t len = ( 0 == nLabels ) ? 1 : offsets[ nLabels - 1 ] + pWire[ offsets[ nLabels - 1 ] ] + 2;
+
+  uint32_t hash( 2166136261u );
+  for ( unsigned ixLabel = nLabels; 0 < ixLabel; ) {
+    ixLabel--;
+    const uint8_t* pLabel = pWire + offsets[ ixLabel ];
+    hash = Mix( hash, *pLabel );
+    for ( std::size_t ix = 1; ix <= *pLabel; ix++ ) hash = Mix( hash, to_lower( pLabel[ ix ] ) );
+    hashes[ ixLabel ] = hash;
+  }
+
+  // longest suffix already in the message
+  unsigned ixMatch( nLabels );
+  uint16_t offsetMatch( 0 );
+  if ( bCompress ) {
+    for ( unsigned ixLabel = 0; ixLabel < nLabels; ixLabel++ ) {
+      offsetMatch = m_table.find( m_pBegin, pWire + offsets[ ixLabel ], hashes[ ixLabel ] );
+      if ( 0 != offsetMatch ) {
+        ixMatch = ixLabel;
+        break;
+      }
+    }
+  }
+
+  // labels ahead of the match are written out, and become candidates themselves
+  const std::size_t lenLabels = ( nLabels == ixMatch ) ? len - 1 : offsets[ ixMatch ];
+  const std::size_t offsetName = m_p - m_pBegin;
+  if ( pWire != m_p ) std::memmove( m_p, pWire, lenLabels );
+  for ( unsigned ixLabel = 0; ixLabel < ixMatch; ixLabel++ ) {
+    const std::size_t offset = offsetName + offsets[ ixLabel ];
+    if ( 0x3fff >= offset ) m_table.insert( hashes[ ixLabel ], static_cast<uint16_t>( offset ) );
+  }
+  m_p += lenLabels;
+
+  if ( nLabels == ixMatch ) {
+    *m_p++ = 0;
+  }
+  else {
+    put16( m_p, 0xc000 | offsetMatch );
+    m_p += 2;
+  }
+}
+
+std::size_t trim( const message_view& response, uint8_t* pOut, std::size_t lenMax ) {
+
+  const uint8_t* pMsg = response.data();
+  if ( response.size() <= lenMax ) {
+    if ( pOut != pMsg ) std::memmove( pOut, pMsg, response.size() );
+    return response.size();
+  }
+
+  const header_view& header( response.header() );
+  const edns_view edns( response.edns() );
+  const std::size_t lenOpt = edns.length; // 0 without one
+
+  uint16_t flags = header.flags();
+  uint16_t counts[ 3 ] = { header.ancount(), header.nscount(), uint16_t( edns.present() ? 1 : 0 ) };
+
+  // answer and authority never point into additional, so the cut is clean
+  std::size_t len = response.authority_end() - pMsg;
+  if ( len + lenOpt <= lenMax ) {
+    const message_view::rr_range authority( response.authority() );
+    const bool bReferral
+      = ( 0 == header.ancount() ) && !header.aa() && ( authority.begin() != authority.end() )
+      && ( type::NS == authority.begin()->type );
+    if ( bReferral && ( header.arcount() > counts[ 2 ] ) ) flags |= flag::TC; // without glue, RFC 9471
+  }
+  else {
+    len = response.question_end() - pMsg;
+    if ( len + lenOpt > lenMax ) return 0;
+    flags |= flag::TC;
+    counts[ 0 ] = counts[ 1 ] = 0;
+  }
+
+  if ( pOut != pMsg ) std::memmove( pOut, pMsg, len );
+  if ( 0 != lenOpt ) std::memmove( pOut + len, edns.pRecord, lenOpt ); // from further along, when in place
+  put16( pOut + 2, flags );
+  put16( pOut + 6, counts[ 0 ] );
+  put16( pOut + 8, counts[ 1 ] );
+  put16( pOut + 10, counts[ 2 ] );
+  return len + lenOpt;
+}
+
+} // namespace dns
@@ -0,0 +1,224 @@
+/*
+ * File:   dns_build.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 10:30 AM
+ */
+
+#ifndef DNS_BUILD_H
+#define DNS_BUILD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "dns.h"
+#include "dns_parse.h"
+
+// Response encoding composed at compile time.
+//
+// A part is any type with:
+//   enum { section = ... }               which counter it adds to (0..3: qd, an, ns, ar)
+//   uint16_t count() const               records it contributes
+//   std::size_t max_size() const         octets it needs, uncompressed
+//   void write( writer& ) const          encode it
+//
+// encode( pOut, cap, header, parts... ) expands the parts in place:  one pass
+// to sum sizes and section counts (so capacity is checked once), one pass to
+// write.  No virtual calls and no heap; name compression uses a small open
+// addressed table of suffix hashes on the stack.
+
+namespace dns {
+
+namespace section {
+  enum { question = 0, answer = 1, authority = 2, additional = 3 };
+}
+
+// suffix hash -> offset of that suffix in the message being built
+class compression_table {
+public:
+
+  compression_table(): m_nUsed( 0 ) { std::memset( m_slot, 0, sizeof( m_slot ) ); }
+
+  // offset of a previously written name equal (case insensitively) to the
+  //   uncompressed suffix at pSuffix, 0 when none
+  uint16_t find( const uint8_t* pMsg, const uint8_t* pSuffix, uint32_t hash ) const;
+  void insert( uint32_t hash, uint16_t offset );
+
+private:
+  enum { slots = 64, probe_limit = 4 };  // more names than this per response is rare
+  struct slot_t {
+    uint32_t hash;
+    uint16_t offset;  // 0 is empty, no name can start in the header
+  };
+  slot_t m_slot[ slots ];
+  unsigned m_nUsed;
+};
+
+// unchecked output cursor:  encode() has already checked capacity
+class writer {
+public:
+  explicit writer( uint8_t* pBegin ): m_pBegin( pBegin ), m_p( pBegin ) {}
+
+  void u8( uint8_t value ) { *m_p++ = value; }
+  void u16( uint16_t value ) { put16( m_p, value ); m_p += 2; }
+  void u32( uint32_t value ) { put32( m_p, value ); m_p += 4; }
+  void bytes( const void* p, std::size_t n ) { std::memcpy( m_p, p, n ); m_p += n; }
+
+  // uncompressed wire format name, compressed against names already written;
+  //   with bCompress false it is written out in full (the question, which the
+  //   answer cache patches in place) but still offered to later names.
+  //   pWire may be position(), for a name already copied into place.
+  void name( const uint8_t* pWire, bool bCompress = true );
+
+  uint8_t* position() const { return m_p; }
+  std::size_t size() const { return m_p - m_pBegin; }
+
+private:
+  uint8_t* m_pBegin;
+  uint8_t* m_p;
+  compression_table m_table;
+};
+
+// octets in an uncompressed wire format name, including the root label
+inline std::size_t name_length( const uint8_t* pWire ) {
+  const uint8_t* p( pWire );
+  while ( 0 != *p ) p += 1 + *p;
+  return p + 1 - pWire;
+}
+
+// ==== parts
+
+struct header_fields {
+  uint16_t id;
+  uint16_t flags;  // QR, opcode, AA, TC, RD, RA ... and rcode in the low four bits
+  header_fields( uint16_t id_, uint16_t flags_ ): id( id_ ), flags( flags_ ) {}
+};
+
+// the question of a parsed query, written uncompressed at offset 12
+struct question_part {
+  enum { section = section::question };
+  const question_view& question;
+  explicit question_part( const question_view& question_ ): question( question_ ) {}
+  uint16_t count() const { return 1; }
+  std::size_t max_size() const { return question.name.length() + 4; }
+  void write( writer& w ) const {
+    uint8_t* p = w.position();
+    question.name.copy( p ); // resolved into place, then registered
+    w.name( p, false );
+    w.u16( question.qtype );
+    w.u16( question.qclass );
+  }
+};
+
+// rdata kinds for rr_part
+
+struct rdata_octets { // opaque, already in wire format (A, AAAA, TXT, ...)
+  const uint8_t* p;
+  uint16_t len;
+  rdata_octets( const uint8_t* p_, uint16_t len_ ): p( p_ ), len( len_ ) {}
+  std::size_t max_size() const { return len; }
+  void write( writer& w ) const { w.bytes( p, len ); }
+};
+
+struct rdata_name { // NS, CNAME, PTR:  compressible
+  const uint8_t* pWire;
+  explicit rdata_name( const uint8_t* pWire_ ): pWire( pWire_ ) {}
+  std::size_t max_size() const { return name_length( pWire ); }
+  void write( writer& w ) const { w.name( pWire ); }
+};
+
+struct rdata_mx {
+  uint16_t preference;
+  const uint8_t* pWire;
+  rdata_mx( uint16_t preference_, const uint8_t* pWire_ ): preference( preference_ ), pWire( pWire_ ) {}
+  std::size_t max_size() const { return 2 + name_length( pWire ); }
+  void write( writer& w ) const { w.u16( preference ); w.name( pWire ); }
+};
+
+template<int Section, typename RData>
+struct rr_part {
+  enum { section = Section };
+  const uint8_t* pOwner; // uncompressed wire format
+  uint16_t type;
+  uint16_t rrclass;
+  uint32_t ttl;
+  RData rdata;
+  rr_part( const uint8_t* pOwner_, uint16_t type_, uint16_t rrclass_, uint32_t ttl_, const RData& rdata_ )
+    : pOwner( pOwner_ ), type( type_ ), rrclass( rrclass_ ), ttl( ttl_ ), rdata( rdata_ ) {}
+  uint16_t count() const { return 1; }
+  std::size_t max_size() const { return name_length( pOwner ) + 10 + rdata.max_size(); }
+  void write( writer& w ) const {
+    w.name( pOwner );
+    w.u16( type );
+    w.u16( rrclass );
+    w.u32( ttl );
+    uint8_t* pRdLength = w.position();
+    w.u16( 0 );
+    rdata.write( w );
+    put16( pRdLength, static_cast<uint16_t>( w.position() - pRdLength - 2 ) );
+  }
+};
+
+template<int Section, typename RData>
+rr_part<Section, RData> make_rr( const uint8_t* pOwner, uint16_t type, uint16_t rrclass, uint32_t ttl, const RData& rdata ) {
+  return rr_part<Section, RData>( pOwner, type, rrclass, ttl, rdata );
+}
+
+// the OPT record of a response (RFC 6891), or nothing at all when the query
+//   carried none:  our udp payload size, the upper bits of an extended rcode,
+//   DO echoed (RFC 3225)
+struct opt_part {
+  enum { section = section::additional };
+  bool bPresent;
+  uint16_t udp_payload;
+  uint8_t rcode_high;
+  bool dnssec_ok;
+  opt_part( bool bPresent_, uint16_t udp_payload_, uint8_t rcode_high_, bool dnssec_ok_ )
+    : bPresent( bPresent_ ), udp_payload( udp_payload_ ), rcode_high( rcode_high_ ), dnssec_ok( dnssec_ok_ ) {}
+  uint16_t count() const { return bPresent ? 1 : 0; }
+  std::size_t max_size() const { return bPresent ? 11 : 0; }
+  void write( writer& w ) const {
+    if ( !bPresent ) return;
+    w.u8( 0 ); // root
+    w.u16( type::OPT );
+    w.u16( udp_payload );
+    w.u8( rcode_high );
+    w.u8( 0 ); // version
+    w.u16( dnssec_ok ? 0x8000 : 0 );
+    w.u16( 0 ); // no options
+  }
+};
+
+// ==== composition
+
+namespace detail {
+  typedef int expand_t[]; // pack expansion in order, pre-C++17
+}
+
+template<typename... Parts>
+std::size_t encode( uint8_t* pOut, std::size_t cap, const header_fields& header, const Parts&... parts ) {
+
+  uint16_t counts[ 4 ] = { 0, 0, 0, 0 };
+  std::size_t size( header_length );
+  (void) detail::expand_t{ 0, ( counts[ Parts::section ] += parts.count(), size += parts.max_size(), 0 )... };
+  if ( cap < size ) return 0;
+
+  writer w( pOut );
+  w.u16( header.id );
+  w.u16( header.flags );
+  for ( uint16_t count: counts ) w.u16( count );
+  (void) detail::expand_t{ 0, ( parts.write( w ), 0 )... };
+  return w.size();
+}
+
+// an encoded response cut down to lenMax octets (RFC 2181 section 9):  the
+//   additional records go first, keeping the OPT, setting TC only when they
+//   were a referral's glue;  then everything after the question, with TC.
+//   pOut may be the response's own buffer.  0 when not even that fits.
+std::size_t trim( const message_view& response, uint8_t* pOut, std::size_t lenMax );
+
+} // namespace dns
+
+#endif /* DNS_BUILD_H */
@@ -0,0 +1,206 @@
+/*
+ * File:   dns_parse.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 9:20 AM
+ */
+
+#include "name_kernels.h"
+#include "dns_parse.h"
+
+namespace dns {
+
+const char* to_string( parse_status status ) {
+  switch ( status ) {
+    case parse_status::ok: return "ok";
+    case parse_status::short_header: return "short header";
+    case parse_status::short_name: return "short name";
+    case parse_status::bad_label: return "bad label type";
+    case parse_status::long_name: return "name too long";
+    case parse_status::bad_pointer: return "bad compression pointer";
+    case parse_status::short_question: return "short question";
+    case parse_status::short_rr: return "short resource record";
+  }
+  return "unknown";
+}
+
+// Pointers are only accepted when they point strictly before the label
+// currently being examined.  Each hop therefore moves backwards in the message,
+// which bounds the walk without needing a visited set, and rejects loops.
+parse_status ScanName( const uint8_t* pMsg, const uint8_t* pEnd, const uint8_t* p, uint16_t& lenWire, uint16_t& lenName ) {
+
+  const uint8_t* pFloor = p;  // pointers must land before this
+  std::size_t nName( 0 );
+  lenWire = 0;
+
+  while ( true ) {
+    if ( p >= pEnd ) return parse_status::short_name;
+    const uint8_t octet = *p;
+    switch ( octet & 0xc0 ) {
+      case 0x00:
+        if ( p + 1 + octet > pEnd ) return parse_status::short_name;
+        nName += 1 + octet;
+        if ( max_name_length < nName ) return parse_status::long_name;
+        if ( 0 == octet ) {
+          if ( 0 == lenWire ) lenWire = static_cast<uint16_t>( p + 1 - pFloor );
+          lenName = static_cast<uint16_t>( nName );
+          return parse_status::ok;
+        }
+        p += 1 + octet;
+        break;
+      case 0xc0: {
+          if ( p + 2 > pEnd ) return parse_status::short_name;
+          const uint8_t* pTarget = pMsg + ( ( ( octet & 0x3f ) << 8 ) | p[ 1 ] );
+          if ( 0 == lenWire ) lenWire = static_cast<uint16_t>( p + 2 - pFloor );
+          if ( pTarget >= pFloor ) return parse_status::bad_pointer;
+          pFloor = pTarget;
+          p = pTarget;
+        }
+        break;
+      default:
+        return parse_status::bad_label;
+    }
+  }
+}
+
+// ==== name_view
+
+std::size_t name_view::copy( uint8_t* dst ) const {
+  uint8_t* p( dst );
+  for ( const uint8_t* pLabel: *this ) {
+    const std::size_t n = 1 + *pLabel;
+    for ( std::size_t ix = 0; ix < n; ix++ ) *p++ = pLabel[ ix ];
+  }
+  return p - dst;
+}
+
+std::size_t name_view::copy_lower( uint8_t* dst ) const {
+  uint8_t* p( dst );
+  for ( const uint8_t* pLabel: *this ) {
+    *p++ = *pLabel;
+    lower( pLabel + 1, *pLabel, p );
+    p += *pLabel;
+  }
+  return p - dst;
+}
+
+bool name_view::equal( const name_view& rhs ) const {
+  if ( m_lenName != rhs.m_lenName ) return false;
+  label_iterator iterL = begin();
+  label_iterator iterR = rhs.begin();
+  while ( end() != iterL ) {
+    const uint8_t* pL = *iterL;
+    const uint8_t* pR = *iterR;
+    if ( ( *pL != *pR ) || !equal_nocase( pL + 1, pR + 1, *pL ) ) return false;
+    ++iterL;
+    ++iterR;
+  }
+  return true;
+}
+
+bool name_view::equal( const uint8_t* pWire ) const {
+  for ( const uint8_t* pLabel: *this ) {
+    if ( ( *pLabel != *pWire ) || !equal_nocase( pLabel + 1, pWire + 1, *pLabel ) ) return false;
+    pWire += 1 + *pLabel;
+  }
+  return true;
+}
+
+std::string name_view::to_string() const {
+  std::string s;
+  if ( empty() ) return s;
+  if ( root() ) return ".";
+  for ( const uint8_t* pLabel: *this ) {
+    for ( std::size_t ix = 1; ix <= *pLabel; ix++ ) {
+      const char ch = static_cast<char>( pLabel[ ix ] );
+      if ( ( '.' == ch ) || ( '\\' == ch ) ) s += '\\';
+      s += ch;
+    }
+    if ( 0 != *pLabel ) s += '.';
+  }
+  return s;
+}
+
+// ==== message_view
+
+void message_view::rr_iterator::load() {
+  if ( 0 == m_nRemaining ) return;
+  uint16_t lenWire;
+  uint16_t lenName;
+  ScanName( m_pMsg, m_pEnd, m_p, lenWire, lenName ); // already validated by parse
+  m_rr.name = name_view( m_pMsg, m_p, lenWire, lenName );
+  const uint8_t* p = m_p + lenWire;
+  m_rr.type = get16( p );
+  m_rr.rrclass = get16( p + 2 );
+  m_rr.ttl = get32( p + 4 );
+  m_rr.rdlength = get16( p + 8 );
+  m_rr.rdata = p + 10;
+}
+
+message_view::message_view()
+  : m_pBegin( nullptr ), m_pEnd( nullptr )
+{
+  for ( auto& p: m_pSection ) p = nullptr;
+}
+
+parse_status message_view::parse( const uint8_t* pBegin, const uint8_t* pEnd ) {
+
+  m_pBegin = pBegin;
+  m_pEnd = pEnd;
+  m_question = question_view();
+
+  if ( pEnd - pBegin < header_length ) return parse_status::short_header;
+  m_header = header_view( pBegin );
+
+  const uint8_t* p = pBegin + header_length;
+  uint16_t lenWire;
+  uint16_t lenName;
+  parse_status status;
+
+  m_pSection[ 0 ] = p;
+  for ( uint16_t ix = 0; ix < m_header.qdcount(); ix++ ) {
+    status = ScanName( pBegin, pEnd, p, lenWire, lenName );
+    if ( parse_status::ok != status ) return status;
+    if ( p + lenWire + 4 > pEnd ) return parse_status::short_question;
+    if ( 0 == ix ) {
+      m_question.name = name_view( pBegin, p, lenWire, lenName );
+      m_question.qtype = get16( p + lenWire );
+      m_question.qclass = get16( p + lenWire + 2 );
+    }
+    p += lenWire + 4;
+  }
+
+  const uint16_t counts[ 3 ] = { m_header.ancount(), m_header.nscount(), m_header.arcount() };
+  for ( unsigned ixSection = 0; ixSection < 3; ixSection++ ) {
+    m_pSection[ ixSection + 1 ] = p;
+    for ( uint16_t ix = 0; ix < counts[ ixSection ]; ix++ ) {
+      status = ScanName( pBegin, pEnd, p, lenWire, lenName );
+      if ( parse_status::ok != status ) return status;
+      p += lenWire;
+      if ( p + 10 > pEnd ) return parse_status::short_rr;
+      p += 10 + get16( p + 8 );
+      if ( p > pEnd ) return parse_status::short_rr;
+    }
+  }
+
+  return parse_status::ok;
+}
+
+edns_view message_view::edns() const {
+  edns_view edns;
+  for ( const rr_view& rr: additional() ) {
+    if ( type::OPT != rr.type ) continue;
+    if ( 0 == edns.count++ ) {
+      edns.udp_payload = rr.rrclass;
+      edns.rcode_high = static_cast<uint8_t>( rr.ttl >> 24 );
+      edns.version = static_cast<uint8_t>( rr.ttl >> 16 );
+      edns.dnssec_ok = 0 != ( rr.ttl & 0x8000 );
+      edns.pRecord = rr.name.data();
+      edns.length = static_cast<uint16_t>( rr.rdata + rr.rdlength - rr.name.data() );
+    }
+  }
+  return edns;
+}
+
+} // namespace dns
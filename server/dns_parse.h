@@ -0,0 +1,252 @@
+/*
+ * File:   dns_parse.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 9:20 AM
+ */
+
+#ifndef DNS_PARSE_H
+#define DNS_PARSE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "dns.h"
+
+// Non-allocating views over a received message.  message_view::parse makes one
+// validating pass over the whole buffer (bounds, label lengths, compression
+// pointers, rdlength), so the views and iterators handed out afterwards can walk
+// the buffer without re-checking.  Nothing is copied:  the receive buffer must
+// outlive the views.
+
+namespace dns {
+
+enum class parse_status: uint8_t {
+  ok,
+  short_header,     // fewer than 12 octets
+  short_name,       // name runs past the end of the message
+  bad_label,        // 0x40/0x80 label types are not supported
+  long_name,        // more than 255 octets uncompressed
+  bad_pointer,      // pointer past the end, or not strictly backwards
+  short_question,
+  short_rr,         // fixed part or rdata runs past the end
+  };
+
+const char* to_string( parse_status );
+
+// validate the name starting at p, following compression pointers
+//   lenWire: octets occupied at p (through the first pointer, or the root label)
+//   lenName: octets of the uncompressed name, including the root label
+parse_status ScanName( const uint8_t* pMsg, const uint8_t* pEnd, const uint8_t* p, uint16_t& lenWire, uint16_t& lenName );
+
+class header_view {
+public:
+  header_view(): m_p( nullptr ) {}
+  explicit header_view( const uint8_t* p ): m_p( p ) {}
+
+  uint16_t id() const { return get16( m_p ); }
+  uint16_t flags() const { return get16( m_p + 2 ); }
+  bool qr() const { return 0 != ( m_p[ 2 ] & 0x80 ); }
+  uint8_t opcode() const { return ( m_p[ 2 ] >> 3 ) & 0x0f; }
+  bool aa() const { return 0 != ( m_p[ 2 ] & 0x04 ); }
+  bool tc() const { return 0 != ( m_p[ 2 ] & 0x02 ); }
+  bool rd() const { return 0 != ( m_p[ 2 ] & 0x01 ); }
+  bool ra() const { return 0 != ( m_p[ 3 ] & 0x80 ); }
+  bool ad() const { return 0 != ( m_p[ 3 ] & 0x20 ); }
+  bool cd() const { return 0 != ( m_p[ 3 ] & 0x10 ); }
+  uint8_t rcode() const { return m_p[ 3 ] & 0x0f; }
+  uint16_t qdcount() const { return get16( m_p + 4 ); }
+  uint16_t ancount() const { return get16( m_p + 6 ); }
+  uint16_t nscount() const { return get16( m_p + 8 ); }
+  uint16_t arcount() const { return get16( m_p + 10 ); }
+
+  const uint8_t* data() const { return m_p; }
+
+private:
+  const uint8_t* m_p;
+};
+
+// a validated, possibly compressed, name inside a message.
+// labels are only resolved (pointers followed) when iterated.
+class name_view {
+public:
+
+  // iterates labels from the leftmost to the root label (inclusive),
+  // *iter is the length octet of the label, followed by its characters
+  class label_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef const uint8_t* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const uint8_t* const* pointer;
+    typedef const uint8_t* reference;
+
+    label_iterator(): m_pMsg( nullptr ), m_p( nullptr ) {}
+    label_iterator( const uint8_t* pMsg, const uint8_t* p ): m_pMsg( pMsg ), m_p( p ) { resolve(); }
+
+    const uint8_t* operator*() const { return m_p; }
+    label_iterator& operator++() {
+      if ( 0 == *m_p ) m_p = nullptr; // past the root label
+      else {
+        m_p += 1 + *m_p;
+        resolve();
+      }
+      return *this;
+    }
+    bool operator==( const label_iterator& rhs ) const { return m_p == rhs.m_p; }
+    bool operator!=( const label_iterator& rhs ) const { return m_p != rhs.m_p; }
+  private:
+    const uint8_t* m_pMsg;
+    const uint8_t* m_p;
+    void resolve() { // already validated, so simply chase pointers
+      while ( 0xc0 == ( *m_p & 0xc0 ) ) m_p = m_pMsg + ( ( ( m_p[ 0 ] & 0x3f ) << 8 ) | m_p[ 1 ] );
+    }
+  };
+
+  name_view(): m_pMsg( nullptr ), m_pName( nullptr ), m_lenWire( 0 ), m_lenName( 0 ) {}
+  name_view( const uint8_t* pMsg, const uint8_t* pName, uint16_t lenWire, uint16_t lenName )
+    : m_pMsg( pMsg ), m_pName( pName ), m_lenWire( lenWire ), m_lenName( lenName ) {}
+
+  bool empty() const { return nullptr == m_pName; }
+  const uint8_t* data() const { return m_pName; }  // position in the message
+  uint16_t wire_length() const { return m_lenWire; } // octets occupied in the message
+  uint16_t length() const { return m_lenName; } // uncompressed, including the root
+  bool compressed() const { return m_lenWire != m_lenName; }
+  bool root() const { return 1 == m_lenName; }
+
+  label_iterator begin() const { return label_iterator( m_pMsg, m_pName ); }
+  label_iterator end() const { return label_iterator(); }
+
+  // write the uncompressed name, returns octets written (length())
+  //   dst must hold at least length() octets
+  std::size_t copy( uint8_t* dst ) const;
+  // as copy, but folds to lower case
+  std::size_t copy_lower( uint8_t* dst ) const;
+
+  // case insensitive comparison of the resolved labels
+  bool equal( const name_view& rhs ) const;
+  // case insensitive against an uncompressed wire format name
+  bool equal( const uint8_t* pWire ) const;
+
+  std::string to_string() const; // presentation format, for diagnostics only
+
+private:
+  const uint8_t* m_pMsg;
+  const uint8_t* m_pName;
+  uint16_t m_lenWire;
+  uint16_t m_lenName;
+};
+
+struct question_view {
+  name_view name;
+  uint16_t qtype;
+  uint16_t qclass;
+  question_view(): qtype( 0 ), qclass( 0 ) {}
+};
+
+struct rr_view {
+  name_view name;
+  uint16_t type;
+  uint16_t rrclass;
+  uint32_t ttl;
+  uint16_t rdlength;
+  const uint8_t* rdata;
+  rr_view(): type( 0 ), rrclass( 0 ), ttl( 0 ), rdlength( 0 ), rdata( nullptr ) {}
+};
+
+// the OPT pseudo record of a message (RFC 6891), when there is one
+struct edns_view {
+  uint16_t count;          // OPT records seen, more than one is a FORMERR
+  uint16_t udp_payload;    // the sender's size, from the class field
+  uint8_t rcode_high;      // upper eight bits of the extended rcode
+  uint8_t version;
+  bool dnssec_ok;          // DO, RFC 3225
+  const uint8_t* pRecord;  // the first one, as it sits in the message
+  uint16_t length;
+  edns_view(): count( 0 ), udp_payload( 0 ), rcode_high( 0 ), version( 0 ), dnssec_ok( false ), pRecord( nullptr ), length( 0 ) {}
+  bool present() const { return 0 != count; }
+};
+
+class message_view {
+public:
+
+  // walks consecutive records of one section, the message has already been validated
+  class rr_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef rr_view value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const rr_view* pointer;
+    typedef const rr_view& reference;
+
+    rr_iterator(): m_pMsg( nullptr ), m_pEnd( nullptr ), m_p( nullptr ), m_nRemaining( 0 ) {}
+    rr_iterator( const uint8_t* pMsg, const uint8_t* pEnd, const uint8_t* p, uint16_t nRemaining )
+      : m_pMsg( pMsg ), m_pEnd( pEnd ), m_p( p ), m_nRemaining( nRemaining ) { load(); }
+
+    const rr_view& operator*() const { return m_rr; }
+    const rr_view* operator->() const { return &m_rr; }
+    rr_iterator& operator++() {
+      m_p = m_rr.rdata + m_rr.rdlength;
+      m_nRemaining--;
+      load();
+      return *this;
+    }
+    bool operator==( const rr_iterator& rhs ) const { return m_nRemaining == rhs.m_nRemaining; }
+    bool operator!=( const rr_iterator& rhs ) const { return m_nRemaining != rhs.m_nRemaining; }
+  private:
+    const uint8_t* m_pMsg;
+    const uint8_t* m_pEnd;
+    const uint8_t* m_p;
+    uint16_t m_nRemaining;
+    rr_view m_rr;
+    void load();
+  };
+
+  struct rr_range {
+    rr_iterator first;
+    rr_iterator last;
+    rr_iterator begin() const { return first; }
+    rr_iterator end() const { return last; }
+  };
+
+  message_view();
+
+  parse_status parse( const uint8_t* pBegin, const uint8_t* pEnd );
+
+  const uint8_t* data() const { return m_pBegin; }
+  std::size_t size() const { return m_pEnd - m_pBegin; }
+
+  const header_view& header() const { return m_header; }
+
+  // the first question, the only one used in practice (qdcount is almost always 1)
+  const question_view& question() const { return m_question; }
+  const uint8_t* question_end() const { return m_pSection[ 1 ]; }
+  const uint8_t* authority_end() const { return m_pSection[ 3 ]; }
+
+  rr_range answers() const { return range( 1, m_header.ancount() ); }
+  rr_range authority() const { return range( 2, m_header.nscount() ); }
+  rr_range additional() const { return range( 3, m_header.arcount() ); }
+
+  edns_view edns() const; // a walk of the additional section
+
+private:
+  const uint8_t* m_pBegin;
+  const uint8_t* m_pEnd;
+  header_view m_header;
+  question_view m_question;
+  const uint8_t* m_pSection[ 4 ]; // start of question, answer, authority, additional
+
+  rr_range range( unsigned ix, uint16_t count ) const {
+    rr_range r;
+    r.first = rr_iterator( m_pBegin, m_pEnd, m_pSection[ ix ], count );
+    r.last = rr_iterator( m_pBegin, m_pEnd, m_pSection[ ix ], 0 );
+    return r;
+  }
+};
+
+} // namespace dns
+
+#endif /* DNS_PARSE_H */
@@ -0,0 +1,506 @@
+/*
+ * File:   forwarder.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 5:20 PM
+ */
+
+#include <array>
+#include <chrono>
+#include <limits>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <system_error>
+
+#include <sys/random.h>
+
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include "dns.h"
+#include "dns_build.h"
+#include "name_kernels.h"
+#include "answer_cache.h"
+#include "forwarder.h"
+
+namespace asio = boost::asio;
+namespace ip = boost::asio::ip;
+
+namespace {
+  enum {
+    udp_payload = dns::edns_udp_length  // advertised upstream when the client used EDNS0
+  };
+}
+
+struct forwarder::pending_t {
+  std::string sKey;          // coalescing
+  vByte_t vRequest;          // header, question, OPT when edns;  id patched per attempt
+  std::size_t lenQuestion;   // header and question, for SERVFAIL and truncation
+  uint8_t flags;             // cache key flags
+  answer_cache* pCache;      // of the responder which started it
+  std::vector<waiter_t> vWaiter;
+  asio::steady_timer timer;
+  std::chrono::steady_clock::time_point tStart;
+  std::size_t ixUpstream;
+  unsigned nAttempts;
+  ip::udp::socket socket;    // this attempt's, closed with the next or when done
+  std::array<uint8_t, rx_length> buf;
+  std::shared_ptr<tcp_connection> pTcp; // once gone to tcp
+  uint16_t idTcp;
+  bool bDone;
+  explicit pending_t( asio::io_context& io_context )
+  : lenQuestion( 0 ), flags( 0 ), pCache( nullptr ), timer( io_context ),
+    ixUpstream( 0 ), nAttempts( 0 ), socket( io_context ), idTcp( 0 ), bDone( false )
+  {}
+};
+
+// ==== pipelined tcp, one per upstream
+
+class forwarder::tcp_connection: public std::enable_shared_from_this<tcp_connection> {
+public:
+
+  tcp_connection( forwarder& forwarder_, asio::io_context& io_context, const ip::tcp::endpoint& endpoint )
+  : m_forwarder( forwarder_ ), m_socket( io_context ), m_endpoint( endpoint ),
+    m_state( state::idle ), m_bWriting( false ), m_idNext( 0 )
+  {}
+
+  bool closed() const { return state::closed == m_state; }
+
+  void Send( pPending_t pPending ) {
+    uint16_t id;
+    do {
+      id = m_idNext++;
+    } while ( m_mapById.end() != m_mapById.find( id ) ); // ids are for matching only over tcp
+    pPending->idTcp = id;
+    m_mapById.emplace( id, pPending );
+
+    vByte_t v( 2 + pPending->vRequest.size() );
+    dns::put16( v.data(), pPending->vRequest.size() );
+    std::memcpy( v.data() + 2, pPending->vRequest.data(), pPending->vRequest.size() );
+    dns::put16( v.data() + 2, id );
+    m_qWrite.emplace_back( std::move( v ) );
+
+    switch ( m_state ) {
+      case state::idle:
+        Connect();
+        break;
+      case state::open:
+        if ( !m_bWriting ) Write();
+        break;
+      default:
+        break;
+    }
+  }
+
+  void Forget( uint16_t id ) { m_mapById.erase( id ); }
+
+  // with bFail, whatever is waiting for a reply gets SERVFAIL
+  void Close( bool bFail = true ) {
+    if ( state::closed == m_state ) return;
+    m_state = state::closed;
+    boost::system::error_code ec;
+    m_socket.close( ec );
+    decltype( m_mapById ) mapById;
+    mapById.swap( m_mapById );
+    if ( bFail ) {
+      for ( auto& pair: mapById ) m_forwarder.Fail( pair.second );
+    }
+  }
+
+private:
+
+  enum class state { idle, connecting, open, closed };
+
+  forwarder& m_forwarder;
+  ip::tcp::socket m_socket;
+  const ip::tcp::endpoint m_endpoint;
+  state m_state;
+  std::deque<vByte_t> m_qWrite;  // framed
+  bool m_bWriting;
+  uint16_t m_idNext;
+  std::array<uint8_t, 2> m_bufLength;
+  vByte_t m_vRead;
+  std::unordered_map<uint16_t, pPending_t> m_mapById;
+
+  void Connect() {
+    m_state = state::connecting;
+    auto self( shared_from_this() );
+    m_socket.async_connect( m_endpoint, [this, self]( const boost::system::error_code& ec ){
+      if ( state::closed == m_state ) return;
+      if ( ec ) {
+        Close();
+        return;
+      }
+      m_state = state::open;
+      Read();
+      Write();
+    } );
+  }
+
+  void Write() {
+    if ( m_qWrite.empty() ) {
+      m_bWriting = false;
+      return;
+    }
+    m_bWriting = true;
+    auto self( shared_from_this() );
+    asio::async_write( m_socket, asio::buffer( m_qWrite.front() ), [this, self]( const boost::system::error_code& ec, std::size_t ){
+      if ( state::closed == m_state ) return;
+      if ( ec ) {
+        Close();
+        return;
+      }
+      m_qWrite.pop_front();
+      Write();
+    } );
+  }
+
+  void Read() {
+    auto self( shared_from_this() );
+    asio::async_read( m_socket, asio::buffer( m_bufLength ), [this, self]( const boost::system::error_code& ec, std::size_t ){
+      if ( state::closed == m_state ) return;
+      if ( ec ) {
+        Close(); // the upstream closing an idle connection ends up here, the next query re-opens
+        return;
+      }
+      m_vRead.resize( dns::get16( m_bufLength.data() ) );
+      asio::async_read( m_socket, asio::buffer( m_vRead ), [this, self]( const boost::system::error_code& ec, std::size_t ){
+        if ( state::closed == m_state ) return;
+        if ( ec ) {
+          Close();
+          return;
+        }
+        if ( dns::header_length <= m_vRead.size() ) {
+          auto iter = m_mapById.find( dns::get16( m_vRead.data() ) );
+          if ( m_mapById.end() != iter ) {
+            pPending_t pPending( iter->second );
+            m_mapById.erase( iter );
+            if ( SameQuestion( pPending->vRequest, m_vRead.data(), m_vRead.size() ) ) {
+              m_forwarder.Complete( pPending, m_vRead.data(), m_vRead.size() );
+            }
+            else m_forwarder.Fail( pPending );
+          }
+        }
+        Read();
+      } );
+    } );
+  }
+
+};
+
+// ====
+
+forwarder::forwarder( asio::io_context& io_context, const vEndpoint_t& vUpstream, metrics::worker_metrics& metrics_, const options_t& options )
+: m_io_context( io_context ), m_options( options ),
+  m_vUpstream( vUpstream.size() ), m_ixUpstream( 0 ),
+  m_ixId( m_rId.size() ),
+  m_metrics( metrics_ )
+{
+  for ( std::size_t ix = 0; ix < vUpstream.size(); ix++ ) {
+    m_vUpstream[ ix ].endpoint = vUpstream[ ix ];
+  }
+  Id(); // a kernel without getrandom fails here, at start up, rather than on the first miss
+  m_ixId = 0;
+}
+
+forwarder::~forwarder() {
+  for ( upstream_t& upstream: m_vUpstream ) {
+    if ( upstream.pTcp ) upstream.pTcp->Close( false ); // whoever was waiting may be gone already
+  }
+}
+
+void forwarder::Forward( const dns::message_view& query, uint8_t flags, std::size_t lenReplyMax, fReply_t&& fReply, answer_cache& cache ) {
+
+  const dns::question_view& question( query.question() );
+
+  waiter_t waiter;
+  waiter.id = query.header().id();
+  waiter.bRD = query.header().rd();
+  waiter.lenReplyMax = lenReplyMax;
+  waiter.vName.resize( question.name.length() );
+  question.name.copy( waiter.vName.data() );
+  waiter.fReply = std::move( fReply );
+
+  // the key is the request's question, folded:  name, qtype, qclass, and the flags
+  uint8_t name[ dns::max_name_length ];
+  const std::size_t lenName = question.name.copy_lower( name );
+  std::string sKey( reinterpret_cast<const char*>( name ), lenName );
+  sKey.push_back( static_cast<char>( question.qtype >> 8 ) );
+  sKey.push_back( static_cast<char>( question.qtype ) );
+  sKey.push_back( static_cast<char>( question.qclass >> 8 ) );
+  sKey.push_back( static_cast<char>( question.qclass ) );
+  sKey.push_back( static_cast<char>( flags ) );
+
+  auto iter = m_mapByQuestion.find( sKey );
+  if ( m_mapByQuestion.end() != iter ) {
+    if ( !waiter.fReply ) return; // already on its way into the cache
+    iter->second->vWaiter.emplace_back( std::move( waiter ) );
+    m_metrics.upstream_coalesced.add();
+    return;
+  }
+
+  pPending_t pPending = std::make_shared<pending_t>( m_io_context );
+  pPending->flags = flags;
+  pPending->pCache = &cache;
+
+  vByte_t& request( pPending->vRequest );
+  request.resize( dns::header_length );
+  dns::put16( &request[ 0 ], 0 );
+  dns::put16( &request[ 2 ], dns::flag::RD | ( query.header().flags() & dns::flag::CD ) );
+  dns::put16( &request[ 4 ], 1 );
+  dns::put16( &request[ 6 ], 0 );
+  dns::put16( &request[ 8 ], 0 );
+  dns::put16( &request[ 10 ], ( 0 != ( flags & answer_cache::edns ) ) ? 1 : 0 );
+  request.insert( request.end(), name, name + lenName );
+  request.resize( request.size() + 4 );
+  dns::put16( &request[ request.size() - 4 ], question.qtype );
+  dns::put16( &request[ request.size() - 2 ], question.qclass );
+  pPending->lenQuestion = request.size();
+  if ( 0 != ( flags & answer_cache::edns ) ) { // RFC 6891 OPT:  root owner, payload size as class, DO in the ttl
+    const uint8_t opt[] = {
+      0, 0, dns::type::OPT, udp_payload >> 8, udp_payload & 0xff,
+      0, 0, uint8_t( ( 0 != ( flags & answer_cache::dnssec_ok ) ) ? 0x80 : 0 ), 0, 0, 0 };
+    request.insert( request.end(), opt, opt + sizeof( opt ) );
+  }
+
+  if ( waiter.fReply ) pPending->vWaiter.emplace_back( std::move( waiter ) );
+  pPending->sKey = std::move( sKey );
+  pPending->ixUpstream = m_ixUpstream;
+  if ( m_vUpstream.size() == ++m_ixUpstream ) m_ixUpstream = 0;
+  m_mapByQuestion.emplace( pPending->sKey, pPending );
+
+  m_metrics.upstream_queries.add();
+  pPending->tStart = std::chrono::steady_clock::now();
+  Send( pPending );
+}
+
+// unpredictable 16 bit values, the kernel's CSPRNG read a block at a time so
+//   the system call is paid once every m_rId.size() queries
+uint16_t forwarder::Id() {
+  if ( m_rId.size() == m_ixId ) {
+    uint8_t* p = reinterpret_cast<uint8_t*>( m_rId.data() );
+    std::size_t len = sizeof( m_rId );
+    while ( 0 < len ) {
+      const ssize_t n = getrandom( p, len, 0 );
+      if ( 0 > n ) {
+        if ( EINTR == errno ) continue;
+        throw std::system_error( errno, std::generic_category(), "getrandom" );
+      }
+      p += n;
+      len -= n;
+    }
+    m_ixId = 0;
+  }
+  return m_rId[ m_ixId++ ];
+}
+
+void forwarder::Send( pPending_t pPending ) {
+
+  const upstream_t& upstream( m_vUpstream[ pPending->ixUpstream ] );
+
+  // a new socket each attempt:  connected, so a new ephemeral port from the
+  //   kernel, and only the upstream's datagrams get through.  A late answer
+  //   to an earlier attempt dies with that attempt's socket.
+  boost::system::error_code ec;
+  pPending->socket.close( ec );
+  pPending->socket.open( upstream.endpoint.protocol(), ec );
+  if ( !ec ) pPending->socket.connect( upstream.endpoint, ec );
+
+  dns::put16( pPending->vRequest.data(), Id() );
+
+  pPending->nAttempts++;
+  if ( !ec ) {
+    StartReceive( pPending );
+    pPending->socket.send( asio::buffer( pPending->vRequest ), 0, ec ); // a failed send waits out the timer like a loss
+  }
+
+  pPending->timer.expires_after( std::chrono::milliseconds( m_options.msTimeout ) );
+  pPending->timer.async_wait( [this, pPending]( const boost::system::error_code& ec ){
+    if ( ec || pPending->bDone ) return;
+    m_metrics.upstream_retries.add();
+    if ( m_options.nAttempts <= pPending->nAttempts ) Fail( pPending );
+    else {
+      if ( m_vUpstream.size() == ++pPending->ixUpstream ) pPending->ixUpstream = 0;
+      Send( pPending );
+    }
+  } );
+}
+
+void forwarder::StartReceive( pPending_t pPending ) {
+  const unsigned nAttempt( pPending->nAttempts );
+  pPending->socket.async_receive(
+    asio::buffer( pPending->buf ),
+    [this, pPending, nAttempt]( const boost::system::error_code& ec, std::size_t length ){
+      if ( asio::error::operation_aborted == ec ) return;
+      if ( pPending->bDone || ( nAttempt != pPending->nAttempts ) ) return; // queued before its socket was closed
+      if ( !ec && Received( pPending, length ) ) return;
+      StartReceive( pPending ); // icmp unreachable shows up as an error, keep listening
+    } );
+}
+
+// true when the answer was taken, false to keep listening
+bool forwarder::Received( pPending_t pPending, std::size_t length ) {
+
+  if ( dns::header_length > length ) return false;
+  const uint8_t* pResponse = pPending->buf.data();
+
+  if ( dns::get16( pPending->vRequest.data() ) != dns::get16( pResponse ) ) return false; // forged, or a stray
+  const uint16_t flags = dns::get16( pResponse + 2 );
+  if ( ( 0 == ( dns::flag::QR & flags ) ) || !SameQuestion( pPending->vRequest, pResponse, length ) ) return false;
+
+  if ( 0 != ( dns::flag::TC & flags ) ) {
+    boost::system::error_code ec;
+    pPending->socket.close( ec );
+    SendTcp( pPending );
+  }
+  else {
+    Complete( pPending, pResponse, length );
+  }
+  return true;
+}
+
+void forwarder::SendTcp( pPending_t pPending ) {
+
+  upstream_t& upstream( m_vUpstream[ pPending->ixUpstream ] );
+  if ( !upstream.pTcp || upstream.pTcp->closed() ) {
+    upstream.pTcp = std::make_shared<tcp_connection>(
+      *this, m_io_context, ip::tcp::endpoint( upstream.endpoint.address(), upstream.endpoint.port() ) );
+  }
+  pPending->pTcp = upstream.pTcp;
+  m_metrics.upstream_tcp.add();
+
+  pPending->timer.expires_after( std::chrono::milliseconds( m_options.msTimeoutTcp ) );
+  pPending->timer.async_wait( [this, pPending]( const boost::system::error_code& ec ){
+    if ( ec || pPending->bDone ) return;
+    Fail( pPending );
+  } );
+
+  upstream.pTcp->Send( pPending );
+}
+
+void forwarder::Release( pPending_t pPending ) {
+  pPending->bDone = true;
+  auto iter = m_mapByQuestion.find( pPending->sKey );
+  if ( ( m_mapByQuestion.end() != iter ) && ( pPending == iter->second ) ) m_mapByQuestion.erase( iter );
+  boost::system::error_code ec;
+  pPending->socket.close( ec );
+  if ( pPending->pTcp ) {
+    pPending->pTcp->Forget( pPending->idTcp );
+    pPending->pTcp.reset();
+  }
+  pPending->timer.cancel();
+}
+
+void forwarder::Complete( pPending_t pPending, const uint8_t* pResponse, std::size_t lenResponse ) {
+
+  if ( pPending->bDone ) return;
+  Release( pPending );
+  m_metrics.upstream_latency.record(
+    std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - pPending->tStart ).count() );
+
+  dns::message_view response;
+  const bool bParsed = ( dns::parse_status::ok == response.parse( pResponse, pResponse + lenResponse ) );
+  const bool bPatchName = bParsed && ( 1 == response.header().qdcount() ) && !response.question().name.compressed();
+
+  if ( bParsed && !response.header().tc() ) {
+    const uint8_t rcode = response.header().rcode();
+    if ( ( dns::rcode::NOERROR == rcode ) || ( dns::rcode::NXDOMAIN == rcode ) ) {
+      const uint32_t ttl = Ttl( response );
+      if ( 0 != ttl ) pPending->pCache->Insert( response, pPending->flags, pResponse, lenResponse, ttl );
+    }
+  }
+
+  for ( waiter_t& waiter: pPending->vWaiter ) {
+    m_vReply.assign( pResponse, pResponse + lenResponse );
+    if ( lenResponse > waiter.lenReplyMax ) {
+      const std::size_t lenTrimmed = bParsed ? dns::trim( response, m_vReply.data(), waiter.lenReplyMax ) : 0;
+      if ( 0 != lenTrimmed ) m_vReply.resize( lenTrimmed ); // additional records dropped first
+      else { // the question alone, truncated, so the client retries over tcp
+        m_vReply.resize( std::min( lenResponse, pPending->lenQuestion ) );
+        m_vReply[ 2 ] |= dns::flag::TC >> 8;
+        std::memset( &m_vReply[ 6 ], 0, 6 );
+      }
+    }
+    dns::put16( &m_vReply[ 0 ], waiter.id );
+    m_vReply[ 2 ] = ( m_vReply[ 2 ] & 0xfe ) | ( waiter.bRD ? 0x01 : 0x00 );
+    if ( bPatchName && ( waiter.vName.size() == response.question().name.length() ) ) {
+      std::memcpy( &m_vReply[ dns::header_length ], waiter.vName.data(), waiter.vName.size() );
+    }
+    waiter.fReply( m_vReply.data(), m_vReply.size() );
+  }
+}
+
+void forwarder::Fail( pPending_t pPending ) {
+
+  if ( pPending->bDone ) return;
+  Release( pPending );
+  m_metrics.upstream_failures.add();
+
+  // an expired answer, when the cache still has one, rather than SERVFAIL (RFC 8767)
+  dns::message_view request;
+  const bool bRequest = ( dns::parse_status::ok == request.parse( pPending->vRequest.data(), pPending->vRequest.data() + pPending->vRequest.size() ) );
+
+  for ( waiter_t& waiter: pPending->vWaiter ) {
+    m_vReply.resize( waiter.lenReplyMax );
+    const std::size_t lenStale
+      = bRequest ? pPending->pCache->Stale( request, pPending->flags, m_vReply.data(), m_vReply.size() ) : 0;
+    if ( 0 != lenStale ) {
+      m_metrics.cache_stale.add();
+      m_vReply.resize( lenStale );
+      dns::put16( &m_vReply[ 0 ], waiter.id );
+      m_vReply[ 2 ] = ( m_vReply[ 2 ] & 0xfe ) | ( waiter.bRD ? 0x01 : 0x00 );
+      std::memcpy( &m_vReply[ dns::header_length ], waiter.vName.data(), waiter.vName.size() );
+      waiter.fReply( m_vReply.data(), m_vReply.size() );
+      continue;
+    }
+    m_vReply.assign( pPending->vRequest.begin(), pPending->vRequest.begin() + pPending->lenQuestion );
+    dns::put16( &m_vReply[ 0 ], waiter.id );
+    dns::put16( &m_vReply[ 2 ],
+      dns::flag::QR | dns::flag::RA | ( waiter.bRD ? dns::flag::RD : 0 ) | dns::rcode::SERVFAIL );
+    std::memset( &m_vReply[ 6 ], 0, 6 );
+    std::memcpy( &m_vReply[ dns::header_length ], waiter.vName.data(), waiter.vName.size() );
+    waiter.fReply( m_vReply.data(), m_vReply.size() );
+  }
+}
+
+bool forwarder::SameQuestion( const vByte_t& request, const uint8_t* pResponse, std::size_t length ) {
+  // the request's question is lower case and uncompressed, the upstream may echo other casing
+  if ( ( 1 != dns::get16( pResponse + 4 ) ) || ( length < dns::header_length + 1 ) ) return false;
+  const uint8_t* pAsked = request.data() + dns::header_length;
+  const std::size_t lenName = dns::name_length( pAsked );
+  if ( length < dns::header_length + lenName + 4 ) return false;
+  const uint8_t* pGot = pResponse + dns::header_length;
+  return dns::equal_nocase( pAsked, pGot, lenName ) && ( 0 == std::memcmp( pAsked + lenName, pGot + lenName, 4 ) );
+}
+
+// the smallest ttl of the records, 0 when there are none:  such a reply isn't
+//   worth keeping.  NXDOMAIN and NODATA (RFC 2308):  the smaller of the ttl
+//   and the MINIMUM of the SOA in authority, and not cached without one.
+uint32_t forwarder::Ttl( const dns::message_view& response ) const {
+
+  const bool bNegative
+    = ( dns::rcode::NXDOMAIN == response.header().rcode() ) || ( 0 == response.header().ancount() );
+
+  uint32_t ttl( std::numeric_limits<uint32_t>::max() );
+  bool bAny( false );
+  bool bSoa( false );
+  const auto scan = [&]( const dns::message_view::rr_range& range, bool bAuthority ){
+    for ( const dns::rr_view& rr: range ) {
+      if ( dns::type::OPT == rr.type ) continue;
+      bAny = true;
+      ttl = std::min( ttl, rr.ttl );
+      if ( bNegative && bAuthority && ( dns::type::SOA == rr.type ) && ( 4 <= rr.rdlength ) ) {
+        bSoa = true;
+        ttl = std::min( ttl, dns::get32( rr.rdata + rr.rdlength - 4 ) );
+      }
+    }
+  };
+  scan( response.answers(), false );
+  scan( response.authority(), true );
+  scan( response.additional(), false );
+
+  if ( bNegative ) return bSoa ? std::min( ttl, m_options.ttlNegativeMax ) : 0;
+  return bAny ? std::min( ttl, m_options.ttlMax ) : 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * File:   forwarder.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 19, 2026, 5:20 PM
+ */
+
+#ifndef FORWARDER_H
+#define FORWARDER_H
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "common.h"
+#include "metrics.h"
+#include "dns_parse.h"
+
+class answer_cache;
+
+// Recursive queries the zone image can't answer go to upstream resolvers.
+//
+// Each udp attempt goes out on a socket of its own, connected, so the kernel
+// picks a fresh ephemeral source port every time, and with a transaction id
+// from the kernel's CSPRNG (RFC 5452):  a spoofed answer has to guess both.
+// Each upstream has one tcp connection, opened on first need and kept, with
+// queries pipelined over it (RFC 7766).  A reply with TC
+// set is asked again over tcp.  An unanswered query moves to the next upstream
+// on a timer; when all attempts are used up, the waiters get SERVFAIL.
+//
+// Misses for the same (qname, qtype, qclass, edns flags) while one is already
+// upstream join it:  one upstream query, its answer copied out to every waiter
+// with their own id, RD bit and question casing, and put in the cache of the
+// responder which started it, with the smallest ttl found in it.
+//
+// One per worker thread, like the responder, so coalescing is per worker too.
+
+class forwarder {
+public:
+
+  typedef boost::asio::ip::udp::endpoint endpoint_t;
+  typedef std::vector<endpoint_t> vEndpoint_t;
+
+  // a finished reply for one waiter, in a buffer valid for the call only
+  typedef std::function<void( const uint8_t* pReply, std::size_t lenReply )> fReply_t;
+
+  struct options_t {
+    unsigned msTimeout;    // per udp attempt
+    unsigned nAttempts;    // udp attempts, across upstreams in turn
+    unsigned msTimeoutTcp;
+    uint32_t ttlMax;       // cap on time in the cache
+    uint32_t ttlNegativeMax; // the same for NXDOMAIN and NODATA
+    options_t(): msTimeout( 800 ), nAttempts( 3 ), msTimeoutTcp( 3000 ), ttlMax( 3600 ), ttlNegativeMax( 900 ) {}
+  };
+
+  forwarder(
+    boost::asio::io_context&, const vEndpoint_t& vUpstream,
+    metrics::worker_metrics& metrics_ = metrics::Discard(), const options_t& = options_t() );
+  virtual ~forwarder();
+
+  // the query as parsed by the responder, with the cache key flags;
+  //   fReply is called exactly once, possibly after the receive buffer is gone;
+  //   an empty fReply only refreshes the cache
+  void Forward( const dns::message_view& query, uint8_t flags, std::size_t lenReplyMax, fReply_t&& fReply, answer_cache& cache );
+
+private:
+
+  struct waiter_t {
+    uint16_t id;
+    bool bRD;
+    std::size_t lenReplyMax;
+    vByte_t vName;  // question name as the client cased it
+    fReply_t fReply;
+  };
+
+  struct pending_t;
+  typedef std::shared_ptr<pending_t> pPending_t;
+
+  enum { rx_length = 4096 };
+
+  class tcp_connection;
+
+  struct upstream_t {
+    endpoint_t endpoint;
+    std::shared_ptr<tcp_connection> pTcp;
+  };
+
+  boost::asio::io_context& m_io_context;
+  const options_t m_options;
+  std::vector<upstream_t> m_vUpstream;
+  std::size_t m_ixUpstream;  // round robin for new queries
+
+  // coalescing, by cache key
+  std::unordered_map<std::string, pPending_t> m_mapByQuestion;
+
+  // transaction ids, refilled from getrandom a block at a time
+  std::array<uint16_t, 256> m_rId;
+  std::size_t m_ixId;
+  vByte_t m_vReply;  // scratch, one waiter's reply at a time
+
+  metrics::worker_metrics& m_metrics;
+
+  uint16_t Id();
+  void Send( pPending_t );
+  void StartReceive( pPending_t );
+  bool Received( pPending_t, std::size_t length );
+  void SendTcp( pPending_t );
+  void Complete( pPending_t, const uint8_t* pResponse, std::size_t lenResponse );
+  void Fail( pPending_t );
+  void Release( pPending_t );
+
+  static bool SameQuestion( const vByte_t& request, const uint8_t* pResponse, std::size_t length );
+  uint32_t Ttl( const dns::message_view& response ) const;
+
+};
+
+#endif /* FORWARDER_H */
@@ -0,0 +1,98 @@
+/*
+ * File:   handler_memory.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 22, 2026, 10:15 AM
+ */
+
+#ifndef HANDLER_MEMORY_H
+#define HANDLER_MEMORY_H
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <type_traits>
+
+// Storage for the completion handler of one asynchronous operation at a time,
+// so starting it again doesn't go to the heap:  after
+//   https://www.boost.org/doc/libs/1_74_0/doc/html/boost_asio/example/cpp11/allocation/server.cpp
+// asio asks the handler's associated allocator for the memory of the operation
+// wrapping it, and gives it back before the handler is called, so one block is
+// enough as long as the operation is never started twice concurrently.
+// A larger request, or one made while the block is in use, goes to the heap.
+
+class handler_memory {
+public:
+
+  handler_memory(): m_bInUse( false ) {}
+  handler_memory( const handler_memory& ) = delete;
+  handler_memory& operator=( const handler_memory& ) = delete;
+
+  void* allocate( std::size_t size ) {
+    if ( !m_bInUse && ( size <= sizeof( m_storage ) ) ) {
+      m_bInUse = true;
+      return &m_storage;
+    }
+    return ::operator new( size );
+  }
+
+  void deallocate( void* pointer ) {
+    if ( pointer == &m_storage ) m_bInUse = false;
+    else ::operator delete( pointer );
+  }
+
+private:
+  typename std::aligned_storage<512>::type m_storage; // a bound handler with its endpoint, and asio's op around it
+  bool m_bInUse;
+};
+
+template<typename T>
+class handler_allocator {
+public:
+
+  typedef T value_type;
+
+  explicit handler_allocator( handler_memory& memory ): m_memory( memory ) {}
+
+  template<typename U>
+  handler_allocator( const handler_allocator<U>& other ) noexcept: m_memory( other.m_memory ) {}
+
+  bool operator==( const handler_allocator& other ) const noexcept { return &m_memory == &other.m_memory; }
+  bool operator!=( const handler_allocator& other ) const noexcept { return &m_memory != &other.m_memory; }
+
+  T* allocate( std::size_t n ) const { return static_cast<T*>( m_memory.allocate( sizeof( T ) * n ) ); }
+  void deallocate( T* p, std::size_t /* n */ ) const { m_memory.deallocate( p ); }
+
+private:
+  template<typename> friend class handler_allocator;
+  handler_memory& m_memory;
+};
+
+// a handler carrying the allocator asio will use for it
+template<typename Handler>
+class custom_alloc_handler {
+public:
+
+  typedef handler_allocator<Handler> allocator_type;
+
+  custom_alloc_handler( handler_memory& memory, Handler&& handler )
+    : m_memory( memory ), m_handler( std::move( handler ) ) {}
+
+  allocator_type get_allocator() const noexcept { return allocator_type( m_memory ); }
+
+  template<typename... Args>
+  void operator()( Args&&... args ) { m_handler( std::forward<Args>( args )... ); }
+
+private:
+  handler_memory& m_memory;
+  Handler m_handler;
+};
+
+template<typename Handler>
+inline custom_alloc_handler<typename std::decay<Handler>::type> make_custom_alloc_handler( handler_memory& memory, Handler&& handler ) {
+  return custom_alloc_handler<typename std::decay<Handler>::type>( memory, std::forward<Handler>( handler ) );
+}
+
+#endif /* HANDLER_MEMORY_H */
@@ -0,0 +1,228 @@
+/*
+ * File:   logger.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 2:40 PM
+ */
+
+#include <ctime>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "logger.h"
+
+namespace logger {
+
+std::atomic<uint8_t> g_level( static_cast<uint8_t>( level::info ) );
+
+namespace {
+
+  // one producer, the owning thread;  one consumer, the background thread
+  struct ring_t {
+
+    enum { size = 1024 }; // records, a power of two
+
+    explicit ring_t( unsigned ix_ ): ix( ix_ ), nTailCached( 0 ), nHead( 0 ), nDropped( 0 ), nTail( 0 ) {}
+
+    const unsigned ix;  // shows as the thread in the output
+
+    // producer side
+    uint64_t nTailCached;
+    std::atomic<uint64_t> nHead;
+    std::atomic<uint64_t> nDropped;
+
+    // consumer side
+    alignas( 64 ) std::atomic<uint64_t> nTail;
+
+    alignas( 64 ) record_t rRecord[ size ];
+  };
+
+  std::mutex g_mutexRings;  // adding a thread, or a drain pass taking stock
+  std::vector<std::unique_ptr<ring_t> > g_vRing; // kept to the end, threads come and go rarely
+
+  thread_local ring_t* t_pRing( nullptr );
+
+  ring_t& Ring() {
+    if ( nullptr == t_pRing ) {
+      std::lock_guard<std::mutex> lock( g_mutexRings );
+      g_vRing.emplace_back( new ring_t( g_vRing.size() ) );
+      t_pRing = g_vRing.back().get();
+    }
+    return *t_pRing;
+  }
+
+  std::thread g_thread;
+  std::mutex g_mutexWake;
+  std::condition_variable g_cvWake;
+  bool g_bStop( false );
+
+  const char* rLevel[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+  void Format( const record_t& record, unsigned ixThread, std::string& sOut ) {
+
+    char sz[ 64 ];
+
+    const time_t seconds = record.ns / 1000000000;
+    struct tm tm;
+    localtime_r( &seconds, &tm );
+    std::size_t len = std::strftime( sz, sizeof( sz ), "%Y-%m-%d %H:%M:%S", &tm );
+    len += std::snprintf( sz + len, sizeof( sz ) - len, ".%06u %s [%u] ",
+      unsigned( ( record.ns % 1000000000 ) / 1000 ), rLevel[ static_cast<uint8_t>( record.lvl ) ], ixThread );
+    sOut.append( sz, len );
+
+    unsigned ixArg( 0 );
+    for ( const char* pch = record.szFormat; 0 != *pch; pch++ ) {
+      if ( ( '{' != pch[ 0 ] ) || ( '}' != pch[ 1 ] ) || ( record.nArgs <= ixArg ) ) {
+        sOut += *pch;
+        continue;
+      }
+      const record_t::arg_t& arg( record.rArg[ ixArg ] );
+      switch ( record.rType[ ixArg ] ) {
+        case record_t::is_int:
+          sOut += std::to_string( arg.i );
+          break;
+        case record_t::is_uint:
+          sOut += std::to_string( arg.u );
+          break;
+        case record_t::is_real:
+          std::snprintf( sz, sizeof( sz ), "%g", arg.d );
+          sOut += sz;
+          break;
+        case record_t::is_str:
+          sOut.append( record.text + arg.s.ix, arg.s.len );
+          break;
+      }
+      ixArg++;
+      pch++;
+    }
+    sOut += '\n';
+  }
+
+  uint64_t g_nDroppedReported( 0 );
+
+  // one pass over every ring; true when anything was found
+  bool Drain( std::string& sOut, std::string& sErr ) {
+
+    std::vector<ring_t*> vRing;
+    {
+      std::lock_guard<std::mutex> lock( g_mutexRings );
+      for ( auto& pRing: g_vRing ) vRing.push_back( pRing.get() );
+    }
+
+    bool bAny( false );
+    for ( ring_t* pRing: vRing ) {
+      const uint64_t nHead = pRing->nHead.load( std::memory_order_acquire );
+      uint64_t nTail = pRing->nTail.load( std::memory_order_relaxed );
+      if ( nHead == nTail ) continue;
+      bAny = true;
+      for ( ; nTail != nHead; nTail++ ) {
+        const record_t& record( pRing->rRecord[ nTail & ( ring_t::size - 1 ) ] );
+        Format( record, pRing->ix, ( level::warn <= record.lvl ) ? sErr : sOut );
+      }
+      pRing->nTail.store( nTail, std::memory_order_release );
+    }
+
+    const uint64_t nDropped = Dropped();
+    if ( g_nDroppedReported != nDropped ) {
+      sErr += "logger: " + std::to_string( nDropped - g_nDroppedReported ) + " records dropped\n";
+      g_nDroppedReported = nDropped;
+    }
+
+    if ( !sOut.empty() ) {
+      std::fwrite( sOut.data(), 1, sOut.size(), stdout );
+      std::fflush( stdout );
+      sOut.clear();
+    }
+    if ( !sErr.empty() ) {
+      std::fwrite( sErr.data(), 1, sErr.size(), stderr );
+      std::fflush( stderr );
+      sErr.clear();
+    }
+
+    return bAny;
+  }
+
+  void Run() {
+    std::string sOut;
+    std::string sErr;
+    std::unique_lock<std::mutex> lock( g_mutexWake );
+    while ( !g_bStop ) {
+      lock.unlock();
+      const bool bAny = Drain( sOut, sErr );
+      lock.lock();
+      // producers never signal, that would be a syscall on their side;  poll instead
+      if ( !bAny && !g_bStop ) g_cvWake.wait_for( lock, std::chrono::milliseconds( 10 ) );
+    }
+    lock.unlock();
+    Drain( sOut, sErr );
+  }
+
+} // namespace anonymous
+
+record_t* Claim() {
+  ring_t& ring( Ring() );
+  const uint64_t nHead = ring.nHead.load( std::memory_order_relaxed );
+  if ( ring_t::size <= nHead - ring.nTailCached ) {
+    ring.nTailCached = ring.nTail.load( std::memory_order_acquire );
+    if ( ring_t::size <= nHead - ring.nTailCached ) {
+      ring.nDropped.store( ring.nDropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+      return nullptr;
+    }
+  }
+  return &ring.rRecord[ nHead & ( ring_t::size - 1 ) ];
+}
+
+void Publish() {
+  ring_t& ring( *t_pRing );
+  ring.nHead.store( ring.nHead.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+}
+
+int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch() ).count();
+}
+
+void Level( level lvl ) {
+  g_level.store( static_cast<uint8_t>( lvl ), std::memory_order_relaxed );
+}
+
+bool Parse( const std::string& s, level& lvl ) {
+  if ( "debug" == s ) lvl = level::debug;
+  else if ( "info" == s ) lvl = level::info;
+  else if ( "warn" == s ) lvl = level::warn;
+  else if ( "error" == s ) lvl = level::error;
+  else if ( "off" == s ) lvl = level::off;
+  else return false;
+  return true;
+}
+
+void Start() {
+  if ( g_thread.joinable() ) return;
+  g_bStop = false;
+  g_thread = std::thread( Run );
+}
+
+void Stop() {
+  if ( !g_thread.joinable() ) return;
+  {
+    std::lock_guard<std::mutex> lock( g_mutexWake );
+    g_bStop = true;
+  }
+  g_cvWake.notify_one();
+  g_thread.join();
+}
+
+uint64_t Dropped() {
+  std::lock_guard<std::mutex> lock( g_mutexRings );
+  uint64_t n( 0 );
+  for ( auto& pRing: g_vRing ) n += pRing->nDropped.load( std::memory_order_relaxed );
+  return n;
+}
+
+} // namespace logger
@@ -0,0 +1,135 @@
+/*
+ * File:   logger.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 2:40 PM
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// Leveled logging kept off the io threads.  A call copies a fixed size binary
+// record (time, level, format literal, arguments) into a ring owned by the
+// calling thread, one producer and one consumer, so no lock and no locked
+// instruction.  A background thread drains every ring, formats and writes.
+// A full ring drops the record and counts it, the io thread never waits.
+//
+// The format is a string literal, kept by pointer, with {} for each argument:
+//   LOG_INFO( "server udp received {} bytes, replying with {}", len, lenReply );
+// Arguments are integers, floating point, and strings (copied, truncated to
+// what fits in the record).  A disabled level costs a relaxed load and a
+// compare, the arguments are not evaluated.
+
+namespace logger {
+
+enum class level: uint8_t { debug, info, warn, error, off };
+
+extern std::atomic<uint8_t> g_level;
+
+inline bool Enabled( level lvl ) {
+  return static_cast<uint8_t>( lvl ) >= g_level.load( std::memory_order_relaxed );
+}
+
+void Level( level );
+bool Parse( const std::string&, level& ); // debug, info, warn, error, off
+
+void Start();   // the background thread
+void Stop();    // drain what is left, and join
+
+uint64_t Dropped();  // records lost to full rings
+
+struct record_t {
+
+  enum { max_args = 6, text_length = 48 };
+  enum type_t: uint8_t { is_int, is_uint, is_real, is_str };
+
+  int64_t ns;              // system clock
+  const char* szFormat;
+  level lvl;
+  uint8_t nArgs;
+  uint8_t nText;           // used of text
+  type_t rType[ max_args ];
+  union arg_t {
+    int64_t i;
+    uint64_t u;
+    double d;
+    struct { uint8_t ix, len; } s;  // in text
+  } rArg[ max_args ];
+  char text[ text_length ];
+
+  void Put( const char* sz, std::size_t len ) {
+    const std::size_t n = std::min<std::size_t>( len, text_length - nText );
+    std::memcpy( text + nText, sz, n );
+    rType[ nArgs ] = is_str;
+    rArg[ nArgs ].s.ix = nText;
+    rArg[ nArgs ].s.len = n;
+    nText += n;
+    nArgs++;
+  }
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+  Put( T value ) { rType[ nArgs ] = is_int; rArg[ nArgs++ ].i = value; }
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+  Put( T value ) { rType[ nArgs ] = is_uint; rArg[ nArgs++ ].u = value; }
+
+  template<typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type
+  Put( T value ) { rType[ nArgs ] = is_real; rArg[ nArgs++ ].d = value; }
+
+  void Put( const char* sz ) { Put( sz, std::strlen( sz ) ); }
+  void Put( const std::string& s ) { Put( s.data(), s.size() ); }
+};
+
+static_assert( 128 == sizeof( record_t ), "a record is two cache lines" );
+
+// the calling thread's ring, made on first use;  nullptr when full
+record_t* Claim();
+void Publish();
+
+inline void Fill( record_t& ) {}
+
+template<typename Arg, typename... Args>
+void Fill( record_t& record, const Arg& arg, const Args&... args ) {
+  if ( record_t::max_args > record.nArgs ) {
+    record.Put( arg );
+    Fill( record, args... );
+  }
+}
+
+int64_t Now();
+
+template<typename... Args>
+void Write( level lvl, const char* szFormat, const Args&... args ) {
+  record_t* pRecord = Claim();
+  if ( nullptr == pRecord ) return;
+  pRecord->ns = Now();
+  pRecord->szFormat = szFormat;
+  pRecord->lvl = lvl;
+  pRecord->nArgs = 0;
+  pRecord->nText = 0;
+  Fill( *pRecord, args... );
+  Publish();
+}
+
+} // namespace logger
+
+#define LOG_AT( lvl, ... ) \
+  do { if ( logger::Enabled( lvl ) ) logger::Write( lvl, __VA_ARGS__ ); } while ( false )
+
+#define LOG_DEBUG( ... ) LOG_AT( logger::level::debug, __VA_ARGS__ )
+#define LOG_INFO( ... )  LOG_AT( logger::level::info, __VA_ARGS__ )
+#define LOG_WARN( ... )  LOG_AT( logger::level::warn, __VA_ARGS__ )
+#define LOG_ERROR( ... ) LOG_AT( logger::level::error, __VA_ARGS__ )
+
+#endif /* LOGGER_H */
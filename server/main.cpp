@@ -6,10 +6,19 @@
  */
 
 #include <array>
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <thread>
+#include <cstring>
+#include <functional>
+#include <vector>
 #include <iostream>
 
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
 #include <boost/bind.hpp>
 
 #include <boost/asio/io_context.hpp>
@@ -19,9 +28,18 @@
 #include <boost/asio/signal_set.hpp>
 #include <boost/asio/write.hpp>
 #include <boost/asio/placeholders.hpp>
-#include <boost/enable_shared_from_this.hpp>
 
-//#include "session.h"
+#include "common.h"
+#include "config.h"
+#include "logger.h"
+#include "query_log.h"
+#include "session.h"
+#include "metrics.h"
+#include "stats_server.h"
+#include "forwarder.h"
+#include "server_udp.h"
+#include "zone_image.h"
+#include "zone_store.h"
 
 namespace asio = boost::asio;
 namespace ip = boost::asio::ip;
@@ -54,75 +72,6 @@ private:
 
 //  ==============
 
-// https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/networking/protocols.html
-// https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/tutorial/tutdaytime7.html
-
-// Data may be read from or written to an unconnected UDP socket using the 
-//   receive_from(), async_receive_from(), send_to() or async_send_to() member functions. 
-// For a connected UDP socket, use the 
-//   receive(), async_receive(), send() or async_send() member functions. 
-
-class server_udp {
-public:
-  server_udp( asio::io_context& io_context, short port )
-    : m_socket( io_context, ip::udp::endpoint( ip::udp::v4(), port ) ) 
-    {
-      start_receive();
-    }
-protected:
-private:
-  
-  ip::udp::socket m_socket;
-  std::array<std::uint8_t, 1024> m_bufReceive;
-  ip::udp::endpoint m_endpointRemote; // are multiple endpoints required?
-  
-  void send_complete( std::shared_ptr<std::string> message, const boost::system::error_code& ec, std::size_t bytes_transferred ) {
-    // used for destroying the message for now
-  }
-  
-  void handle_receive( const boost::system::error_code& ec, std::size_t bytes_transferred ) {
-    if ( !ec ) {
-      
-      if ( 0 != bytes_transferred ) {
-        std::string rx( m_bufReceive[ 0 ], bytes_transferred );
-        std::cout << "server udp received " << bytes_transferred << " bytes: '";
-        for ( size_t ix = 0; ix < bytes_transferred; ix++ ) std::cout << m_bufReceive[ ix ];
-        std::cout << "'" << std::endl;
-      } 
-      
-      std::shared_ptr<std::string> message( new std::string( "server out test" ) );
-      
-      m_socket.async_send_to(
-        asio::buffer( *message ),
-        m_endpointRemote,
-        boost::bind( 
-          &server_udp::send_complete, this, 
-          message, 
-          asio::placeholders::error,
-          asio::placeholders::bytes_transferred
-        )
-      );
-      
-      start_receive();  // start over again
-    }
-  }
-  
-  void start_receive() {
-    m_socket.async_receive_from(
-      asio::buffer( m_bufReceive ),
-      m_endpointRemote,
-      boost::bind(
-        &server_udp::handle_receive, this,
-        asio::placeholders::error,
-        asio::placeholders::bytes_transferred
-      )
-    );
-  }
-  
-};
-
-//  ==============
-
 // Data may be read from or written to a connected TCP socket using the 
 //  receive(), async_receive(), send() or async_send() member functions. 
 // However, as these could result in short writes or reads, 
@@ -134,144 +83,371 @@ private:
 // https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/tutorial/tutdaytime3.html
 // https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/example/cpp11/echo/async_tcp_echo_server.cpp
 
-class session: public boost::enable_shared_from_this<session> {
+class server_tcp {
 public:
-  
-  typedef boost::shared_ptr<session> pointer;
-  
-  static pointer create( asio::io_context& io_context ) {
-    return pointer( new session( io_context ) );
+  server_tcp(
+    asio::io_context& io_context, short port, const zone_image* pZone, forwarder* pForwarder,
+    metrics::worker_metrics& metrics_, const answer_cache::options_t& optionsCache, uint16_t nUdpPayload )
+    : m_acceptor( io_context, ip::tcp::endpoint( ip::tcp::v4(), port ) ),
+      m_responder( pZone, pForwarder, metrics_, metrics::tcp, optionsCache, nUdpPayload ),
+      m_pool( io_context, m_responder, metrics_ )
+  {
+    asio::co_spawn( io_context, do_accept(), asio::detached );
   }
-  
-  ip::tcp::socket& socket() { return m_socket; }
-  
-  void start() {
-    m_message = "test this";  // keep the data valid until the asynchronous operation is complete
-    
-    asio::async_write( 
-      m_socket, asio::buffer( m_message ),
-      boost::bind(
-        &session::handle_write_state, shared_from_this(),
-        asio::placeholders::error,
-        asio::placeholders::bytes_transferred
-        )
-      );
+
+  void Zone( const zone_image* pZone ) { m_responder.Zone( pZone ); } // sessions share the responder
+
+  // session gauges, in the acceptor's thread
+  void Metrics( std::string& sOut ) {
+    uint64_t nDepth( 0 ), nDepthMax( 0 ), nHighWater( 0 );
+    for ( const std::unique_ptr<session>& pSession: m_pool.active() ) {
+      nDepth += pSession->tx_queue_depth();
+      nDepthMax = std::max<uint64_t>( nDepthMax, pSession->tx_queue_depth() );
+      nHighWater = std::max<uint64_t>( nHighWater, pSession->tx_queue_high_water() );
+    }
+    metrics::Append( sOut, "tcp_sessions", "gauge", "Open tcp sessions.", m_pool.active().size() );
+    metrics::Append( sOut, "tcp_sessions_idle", "gauge", "Closed tcp sessions kept for reuse.", m_pool.idle() );
+    metrics::Append( sOut, "tcp_tx_queue_depth", "gauge", "Replies queued for write, over all tcp sessions.", nDepth );
+    metrics::Append( sOut, "tcp_tx_queue_depth_max", "gauge", "Replies queued for write, deepest tcp session.", nDepthMax );
+    metrics::Append( sOut, "tcp_tx_queue_high_water", "gauge", "Deepest write queue seen, over open tcp sessions.", nHighWater );
   }
-  
-protected:
+
 private:
-  
-  ip::tcp::socket m_socket;
-  std::string m_message;
-  enum { max_buf_length = 1024 };
-  std::array<std::uint8_t, max_buf_length> m_bufReceive;
-  
-  session( asio::io_context& io_context )
-    : m_socket( io_context )
-  {
-  }
-  
-  void start_read() {
-    
-    auto self( shared_from_this() );
-    
-    m_socket.async_read_some(
-      asio::buffer( m_bufReceive ), 
-      [this, self]( const boost::system::error_code& ec, std::size_t length ){
-        if ( !ec ) {
-          // process buffer, then
-          start_read();
-        }
-        else {
-          // fix things and try again?
-        }
+
+  ip::tcp::acceptor m_acceptor;
+  responder m_responder;  // sessions run in the acceptor's thread
+  session_pool m_pool;
+
+  asio::awaitable<void> do_accept() {
+    boost::system::error_code ec;
+    for ( ;; ) {
+      ip::tcp::socket socket = co_await m_acceptor.async_accept( asio::redirect_error( asio::use_awaitable, ec ) );
+      if ( !ec ) {
+        m_pool.start( std::move( socket ) );  // manage new connection
+      }
+      else {
+        if ( asio::error::operation_aborted == ec ) break;
+        // repair and restart?
       }
-    );
+    }
   }
 
-  void handle_write_state( const boost::system::error_code& ec, size_t bytes_transferred ) {
-    
-  }  
-  
 };
 
+//  ==============
 
-class server_tcp {
+// One thread, one io_context, one udp socket (and so one responder and its
+//   answer cache), and its own forwarder.  Nothing is shared between workers
+//   on the query path.
+
+class worker {
 public:
-  server_tcp( asio::io_context& io_context, short port )
-    : m_acceptor( io_context, ip::tcp::endpoint( ip::tcp::v4(), port ) )
-  {
-    start_accept(); // accept first connection
+  worker( const config& config_, unsigned ix, const zone_image* pZone, const forwarder::vEndpoint_t& vUpstream )
+    : m_ix( ix ), m_bPin( config_.bPinWorkers ),
+      m_pForwarder( vUpstream.empty() ? nullptr : new forwarder( m_io_context, vUpstream, m_metrics ) ),
+      m_udp(
+        m_io_context, config_.port, 1 < config_.nWorkers, config_.nBatch, pZone, m_pForwarder.get(),
+        Rrl( config_ ), m_metrics, Cache( config_ ), config_.nUdpPayload, config_.bUring )
+  {}
+
+  asio::io_context& context() { return m_io_context; }
+  forwarder* upstream() { return m_pForwarder.get(); }
+  metrics::worker_metrics& stats() { return m_metrics; }
+
+  void Zone( const zone_image* pZone ) { m_udp.Zone( pZone ); } // in this worker's thread
+
+  // for each responder, udp or tcp
+  static answer_cache::options_t Cache( const config& config_ ) {
+    answer_cache::options_t options;
+    options.nBytes = config_.nCacheBytes;
+    options.secondsStale = config_.secondsStale;
+    return options;
+  }
+
+  void start() { // in a thread of its own
+    m_thread = std::thread( [this](){ run(); } );
+  }
+
+  void run() { // in the calling thread
+    if ( m_bPin ) Pin();
+    if ( query_log::Enabled() ) query_log::Register();
+    m_io_context.run();
+  }
+
+  void stop() { m_io_context.stop(); }
+
+  void join() {
+    if ( m_thread.joinable() ) m_thread.join();
   }
 
 private:
-  
-  ip::tcp::acceptor m_acceptor;
-  
-  void handle_accept( session::pointer new_connection, const boost::system::error_code& ec ) {
-    if ( !ec ) {
-      new_connection->start();  // manage existing connection
-      start_accept();  // accept another connection
+
+  unsigned m_ix;
+  bool m_bPin;
+  asio::io_context m_io_context;
+  metrics::worker_metrics m_metrics;  // written by this thread only
+  std::unique_ptr<forwarder> m_pForwarder;  // before m_udp, which refers to it
+  server_udp m_udp;
+  std::thread m_thread;
+
+  // the kernel spreads a client's source ports over the workers' sockets, so
+  //   each worker limits to its share of the rate
+  static rrl::options_t Rrl( const config& config_ ) {
+    rrl::options_t options;
+    options.nPerSecond = ( config_.nRrlPerSecond + config_.nWorkers - 1 ) / config_.nWorkers;
+    options.nSlip = config_.nRrlSlip;
+    return options;
+  }
+
+  void Pin() {
+    const unsigned nCpu = std::max( 1u, std::thread::hardware_concurrency() );
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( m_ix % nCpu, &set );
+    int result = pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+    if ( 0 != result ) {
+      LOG_WARN( "worker {} pin failed: {}", m_ix, result );
     }
-    else {
-      // repair and restart?
+  }
+};
+
+//  ==============
+
+// <address>[:<port>] or [<v6 address>]:<port>, port 53 by default
+bool ParseUpstream( const std::string& s, forwarder::endpoint_t& endpoint ) {
+  std::string sAddress( s );
+  unsigned short port( 53 );
+  std::size_t ixPort( std::string::npos );
+  if ( ( 0 < s.size() ) && ( '[' == s[ 0 ] ) ) {
+    const std::size_t ixClose = s.find( ']' );
+    if ( std::string::npos == ixClose ) return false;
+    sAddress = s.substr( 1, ixClose - 1 );
+    if ( ixClose + 1 < s.size() ) {
+      if ( ':' != s[ ixClose + 1 ] ) return false;
+      ixPort = ixClose + 2;
     }
   }
-  
-  void start_accept() {
-    session::pointer new_connection = session::create( m_acceptor.get_executor().context() );
-    
-    m_acceptor.async_accept( 
-      new_connection->socket(),
-      boost::bind( &server_tcp::handle_accept, this, new_connection, asio::placeholders::error )
-    );
-    
+  else if ( 1 == std::count( s.begin(), s.end(), ':' ) ) {
+    ixPort = s.find( ':' ) + 1;
+    sAddress = s.substr( 0, ixPort - 1 );
   }
-
-};
+  if ( std::string::npos != ixPort ) {
+    const int n = std::atoi( s.c_str() + ixPort );
+    if ( ( 0 >= n ) || ( 0xffff < n ) ) return false;
+    port = n;
+  }
+  boost::system::error_code ec;
+  const ip::address address = ip::make_address( sAddress, ec );
+  if ( ec ) return false;
+  endpoint = forwarder::endpoint_t( address, port );
+  return true;
+}
 
 //  ==============
 
 int main( int argc, char* argv[] ) {
   
-  int port( 53 ); // default but can be over-written
-    
-  asio::io_context io_context;
+  config config_; // port 53 by default but can be over-written
 
-  // https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/signals.html
-  boost::asio::signal_set signals( io_context, SIGINT, SIGTERM );
-  signals.async_wait( []( const boost::system::error_code& error, int signal_number ){
-    if ( !error ) {
-      std::cout << "signal " << signal_number << " received." << std::endl;
+  const char* szUsage
+    = "Usage: server [-t <threads>] [-c] [-b <batch>] [-i] [-z <zone image>] [-u <upstream>[:<port>] ...] [-m <stats port>] [-M <stats file>] [-l <log level>] [-r <responses/s> [-s <slip>]] [-C <cache MiB per thread>] [-S <stale seconds>] [-e <edns udp size>] [-q <query log path> [-Q <segment MiB>[,<segments kept>]]] [<port>] (default ";
+  int opt;
+  while ( -1 != ( opt = getopt( argc, argv, "t:cb:iz:u:m:M:l:r:s:C:S:e:q:Q:" ) ) ) {
+    switch ( opt ) {
+      case 'b':
+        config_.nBatch = std::max( 1, std::atoi( optarg ) );
+        break;
+      case 'i':
+        config_.bUring = true;
+        break;
+      case 't':
+        config_.nWorkers = std::max( 1, std::atoi( optarg ) );
+        break;
+      case 'c':
+        config_.bPinWorkers = true;
+        break;
+      case 'z':
+        config_.sZoneImage = optarg;
+        break;
+      case 'u':
+        config_.vUpstream.push_back( optarg );
+        break;
+      case 'm':
+        config_.portStats = std::atoi( optarg );
+        break;
+      case 'M':
+        config_.sStatsFile = optarg;
+        break;
+      case 'l':
+        if ( !logger::Parse( optarg, config_.levelLog ) ) {
+          std::cerr << "log level is one of debug, info, warn, error, off" << std::endl;
+          return 1;
+        }
+        break;
+      case 'r':
+        config_.nRrlPerSecond = std::max( 0, std::atoi( optarg ) );
+        break;
+      case 's':
+        config_.nRrlSlip = std::max( 0, std::atoi( optarg ) );
+        break;
+      case 'C':
+        config_.nCacheBytes = std::size_t( std::max( 1, std::atoi( optarg ) ) ) << 20;
+        break;
+      case 'S':
+        config_.secondsStale = std::max( 0, std::atoi( optarg ) );
+        break;
+      case 'e':
+        config_.nUdpPayload = std::min( int( dns::max_edns_udp_length ), std::max( int( dns::max_udp_length ), std::atoi( optarg ) ) );
+        break;
+      case 'q':
+        config_.sQueryLog = optarg;
+        break;
+      case 'Q': {
+          config_.nQueryLogSegmentBytes = std::size_t( std::max( 1, std::atoi( optarg ) ) ) << 20;
+          const char* szKept = std::strchr( optarg, ',' );
+          if ( nullptr != szKept ) config_.nQueryLogSegments = std::max( 0, std::atoi( szKept + 1 ) );
+        }
+        break;
+      default:
+        std::cerr << szUsage << config_.port << ")" << std::endl;
+        return 1;
     }
-  } );
+  }
   
-  if ( 1 == argc ) {
+  if ( optind == argc ) {
     
   }
   else {
-    if (argc != 2) {
-      std::cerr << "Usage: server <port> (default " << port << ")" << std::endl;;
+    if ( argc != optind + 1 ) {
+      std::cerr << szUsage << config_.port << ")" << std::endl;;
     //      return 1;
     }
     else {
-      port = std::atoi(argv[1]);
+      config_.port = std::atoi(argv[ optind ]);
     }
     
   }
-  std::cout << "server using port " << port << "." << std::endl;;
+  logger::Level( config_.levelLog );
+  logger::Start();
+
+  LOG_INFO(
+    "server using port {} with {} worker(s){}, udp {}.",
+    config_.port, config_.nWorkers, config_.bPinWorkers ? ", pinned" : "",
+    config_.bUring ? std::string( "io_uring" ) : ( "batch " + std::to_string( config_.nBatch ) ) );
+  if ( 0 != config_.nRrlPerSecond ) {
+    LOG_INFO( "rate limiting udp to {} responses/s, slip {}.", config_.nRrlPerSecond, config_.nRrlSlip );
+  }
+
+  // mapped once, read by every worker, replaced on SIGHUP;  outlives the workers
+  zone_store zones;
+  if ( !config_.sZoneImage.empty() ) {
+    std::string sError;
+    if ( !zones.Open( config_.sZoneImage, sError ) ) {
+      LOG_ERROR( "{}", sError );
+      logger::Stop();
+      return 1;
+    }
+    LOG_INFO( "zone image {}, {} bytes.", config_.sZoneImage, zones.current()->size() );
+  }
+
+  forwarder::vEndpoint_t vUpstream;
+  for ( const std::string& sUpstream: config_.vUpstream ) {
+    forwarder::endpoint_t endpoint;
+    if ( !ParseUpstream( sUpstream, endpoint ) ) {
+      LOG_ERROR( "bad upstream {}", sUpstream );
+      logger::Stop();
+      return 1;
+    }
+    vUpstream.push_back( endpoint );
+    LOG_INFO( "forwarding to {} port {}.", endpoint.address().to_string(), endpoint.port() );
+  }
   
+  if ( !config_.sQueryLog.empty() ) {
+    query_log::options_t options;
+    options.sPath = config_.sQueryLog;
+    options.nSegmentBytes = config_.nQueryLogSegmentBytes;
+    options.nSegmentsKept = config_.nQueryLogSegments;
+    std::string sError;
+    if ( !query_log::Start( options, sError ) ) {
+      LOG_ERROR( "{}", sError );
+      logger::Stop();
+      return 1;
+    }
+    LOG_INFO( "query log {}, {} MiB segments.", config_.sQueryLog, config_.nQueryLogSegmentBytes >> 20 );
+  }
+
   try   {
+    
+    std::vector<std::unique_ptr<worker> > vWorker;
+    for ( unsigned ix = 0; ix < config_.nWorkers; ix++ ) {
+      vWorker.emplace_back( new worker( config_, ix, zones.current(), vUpstream ) );
+    }
+    
+    // the first worker runs in this thread, and carries the housekeeping
+    asio::io_context& io_context( vWorker.front()->context() );
+
+    // https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/signals.html
+    boost::asio::signal_set signals( io_context, SIGINT, SIGTERM );
+    signals.async_wait( [&vWorker, &zones]( const boost::system::error_code& error, int signal_number ){
+      if ( !error ) {
+        LOG_INFO( "signal {} received.", signal_number );
+        zones.Stop();
+        for ( auto& pWorker: vWorker ) pWorker->stop();
+      }
+    } );
 
-    server_tcp tcpServer( io_context, port );
-    server_udp udpServer( io_context, port );
+    boost::asio::signal_set signalReload( io_context, SIGHUP );
+    std::function<void()> fAwaitReload = [&](){
+      signalReload.async_wait( [&]( const boost::system::error_code& error, int ){
+        if ( error ) return;
+        if ( config_.sZoneImage.empty() ) LOG_WARN( "SIGHUP:  no zone image to reload" );
+        else if ( zones.Reload() ) LOG_INFO( "SIGHUP:  reloading {}", config_.sZoneImage );
+        else LOG_WARN( "SIGHUP:  a reload is already under way" );
+        fAwaitReload();
+      } );
+    };
+    fAwaitReload();
+  
+    server_tcp tcpServer( io_context, config_.port, zones.current(), vWorker.front()->upstream(), vWorker.front()->stats(),
+      worker::Cache( config_ ), config_.nUdpPayload );
     server_icmp icmpServer( io_context );
 
-    io_context.run();
+    for ( auto& pWorker_: vWorker ) {
+      worker* pWorker( pWorker_.get() );
+      if ( vWorker.front().get() == pWorker ) { // tcp runs in the first worker's thread
+        zones.AddReader( pWorker->context(), [pWorker, &tcpServer]( const zone_image* pZone ){
+          pWorker->Zone( pZone );
+          tcpServer.Zone( pZone );
+        } );
+      }
+      else {
+        zones.AddReader( pWorker->context(), [pWorker]( const zone_image* pZone ){ pWorker->Zone( pZone ); } );
+      }
+    }
+
+    std::unique_ptr<stats_server> pStats;
+    if ( ( 0 != config_.portStats ) || !config_.sStatsFile.empty() ) {
+      metrics::vWorker_t vMetrics;
+      for ( auto& pWorker: vWorker ) vMetrics.push_back( &pWorker->stats() );
+      pStats.reset( new stats_server(
+        io_context, config_.portStats, config_.sStatsFile, config_.secondsStatsFile, vMetrics,
+        [&tcpServer]( std::string& sOut ){
+          tcpServer.Metrics( sOut );
+          metrics::Append( sOut, "log_dropped_total", "counter", "Log records dropped on a full ring.", logger::Dropped() );
+          metrics::Append( sOut, "query_log_dropped_total", "counter", "Query log frames dropped on a full ring.", query_log::Dropped() );
+        } ) );
+      if ( 0 != config_.portStats ) LOG_INFO( "stats on 127.0.0.1:{}", config_.portStats );
+    }
+
+    for ( unsigned ix = 1; ix < vWorker.size(); ix++ ) vWorker[ ix ]->start();
+    vWorker.front()->run();
+    for ( auto& pWorker: vWorker ) pWorker->join();
   }
   catch ( std::exception& e )   {
-    std::cerr << "Exception: " << e.what() << std::endl;
+    LOG_ERROR( "Exception: {}", e.what() );
   }
 
+  query_log::Stop();
+  logger::Stop();
   return 0;
 }
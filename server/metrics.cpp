@@ -0,0 +1,175 @@
+/*
+ * File:   metrics.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 9:15 AM
+ */
+
+#include <cstdio>
+
+#include "dns.h"
+#include "metrics.h"
+
+namespace {
+
+  const char* rTransport[] = { "udp", "tcp" };
+
+  const char* rQtype[] = { "A", "NS", "CNAME", "SOA", "PTR", "MX", "TXT", "AAAA", "SRV", "ANY", "other" };
+
+  const char* rRcode[] = {
+    "NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED", "YXDOMAIN", "YXRRSET",
+    "NXRRSET", "NOTAUTH", "NOTZONE", "RCODE11", "RCODE12", "RCODE13", "RCODE14", "RCODE15"
+  };
+
+  const char* szPrefix = "cppdns_";
+
+  void Header( std::string& sOut, const char* szName, const char* szType, const char* szHelp ) {
+    sOut += "# HELP "; sOut += szPrefix; sOut += szName; sOut += ' '; sOut += szHelp; sOut += '\n';
+    sOut += "# TYPE "; sOut += szPrefix; sOut += szName; sOut += ' '; sOut += szType; sOut += '\n';
+  }
+
+  void Sample( std::string& sOut, const char* szName, const std::string& sLabels, double value ) {
+    char sz[ 32 ];
+    std::snprintf( sz, sizeof( sz ), "%.17g", value );
+    sOut += szPrefix; sOut += szName;
+    if ( !sLabels.empty() ) {
+      sOut += '{'; sOut += sLabels; sOut += '}';
+    }
+    sOut += ' '; sOut += sz; sOut += '\n';
+  }
+
+  template<typename Get>
+  uint64_t Sum( const metrics::vWorker_t& vWorker, Get get ) {
+    uint64_t n( 0 );
+    for ( const metrics::worker_metrics* pWorker: vWorker ) n += get( *pWorker );
+    return n;
+  }
+
+  void Histogram(
+    std::string& sOut, const metrics::vWorker_t& vWorker, const char* szName, const char* szHelp,
+    const metrics::histogram metrics::worker_metrics::* pHistogram
+  ) {
+    Header( sOut, szName, "histogram", szHelp );
+    const std::string sBucket( std::string( szName ) + "_bucket" );
+    uint64_t nCumulative( 0 );
+    for ( unsigned ix = 0; ix <= metrics::histogram::buckets; ix++ ) {
+      nCumulative += Sum( vWorker, [pHistogram, ix]( const metrics::worker_metrics& m ){ return ( m.*pHistogram ).bucket( ix ); } );
+      char szLe[ 32 ];
+      if ( metrics::histogram::buckets == ix ) std::snprintf( szLe, sizeof( szLe ), "+Inf" );
+      else std::snprintf( szLe, sizeof( szLe ), "%g", double( uint64_t( 1 ) << ( metrics::histogram::first_shift + ix ) ) / 1e9 );
+      Sample( sOut, sBucket.c_str(), std::string( "le=\"" ) + szLe + "\"", nCumulative );
+    }
+    Sample( sOut, ( std::string( szName ) + "_sum" ).c_str(), "",
+      Sum( vWorker, [pHistogram]( const metrics::worker_metrics& m ){ return ( m.*pHistogram ).sum(); } ) / 1e9 );
+    Sample( sOut, ( std::string( szName ) + "_count" ).c_str(), "", nCumulative );
+  }
+
+  void Counter(
+    std::string& sOut, const metrics::vWorker_t& vWorker, const char* szName, const char* szHelp,
+    const metrics::counter metrics::worker_metrics::* pCounter
+  ) {
+    Header( sOut, szName, "counter", szHelp );
+    Sample( sOut, szName, "", Sum( vWorker, [pCounter]( const metrics::worker_metrics& m ){ return ( m.*pCounter ).get(); } ) );
+  }
+
+} // namespace anonymous
+
+namespace metrics {
+
+qtype_index QtypeIndex( uint16_t qtype ) {
+  switch ( qtype ) {
+    case dns::type::A: return A;
+    case dns::type::NS: return NS;
+    case dns::type::CNAME: return CNAME;
+    case dns::type::SOA: return SOA;
+    case dns::type::PTR: return PTR;
+    case dns::type::MX: return MX;
+    case dns::type::TXT: return TXT;
+    case dns::type::AAAA: return AAAA;
+    case dns::type::SRV: return SRV;
+    case dns::type::ANY: return ANY;
+    default: return other;
+  }
+}
+
+worker_metrics& Discard() {
+  static worker_metrics discard;
+  return discard;
+}
+
+uint64_t worker_metrics::total_queries() const {
+  uint64_t n( 0 );
+  for ( const auto& byTransport: queries ) {
+    for ( const counter& c: byTransport ) n += c.get();
+  }
+  return n;
+}
+
+void Append( std::string& sOut, const char* szName, const char* szType, const char* szHelp, double value ) {
+  Header( sOut, szName, szType, szHelp );
+  Sample( sOut, szName, "", value );
+}
+
+void Render( const vWorker_t& vWorker, std::string& sOut ) {
+
+  Header( sOut, "queries_total", "counter", "Queries received, by transport and qtype." );
+  for ( unsigned ixTransport = 0; ixTransport < transports; ixTransport++ ) {
+    for ( unsigned ixQtype = 0; ixQtype < qtypes; ixQtype++ ) {
+      const uint64_t n = Sum( vWorker, [=]( const worker_metrics& m ){ return m.queries[ ixTransport ][ ixQtype ].get(); } );
+      if ( 0 == n ) continue;
+      Sample( sOut, "queries_total",
+        std::string( "transport=\"" ) + rTransport[ ixTransport ] + "\",qtype=\"" + rQtype[ ixQtype ] + "\"", n );
+    }
+  }
+
+  Header( sOut, "responses_total", "counter", "Responses sent, by transport and rcode." );
+  for ( unsigned ixTransport = 0; ixTransport < transports; ixTransport++ ) {
+    for ( unsigned ixRcode = 0; ixRcode < 16; ixRcode++ ) {
+      const uint64_t n = Sum( vWorker, [=]( const worker_metrics& m ){ return m.responses[ ixTransport ][ ixRcode ].get(); } );
+      if ( 0 == n ) continue;
+      Sample( sOut, "responses_total",
+        std::string( "transport=\"" ) + rTransport[ ixTransport ] + "\",rcode=\"" + rRcode[ ixRcode ] + "\"", n );
+    }
+  }
+
+  Header( sOut, "received_bytes_total", "counter", "DNS message octets received, by transport." );
+  for ( unsigned ix = 0; ix < transports; ix++ ) {
+    Sample( sOut, "received_bytes_total", std::string( "transport=\"" ) + rTransport[ ix ] + "\"",
+      Sum( vWorker, [ix]( const worker_metrics& m ){ return m.rx_bytes[ ix ].get(); } ) );
+  }
+  Header( sOut, "sent_bytes_total", "counter", "DNS message octets sent, by transport." );
+  for ( unsigned ix = 0; ix < transports; ix++ ) {
+    Sample( sOut, "sent_bytes_total", std::string( "transport=\"" ) + rTransport[ ix ] + "\"",
+      Sum( vWorker, [ix]( const worker_metrics& m ){ return m.tx_bytes[ ix ].get(); } ) );
+  }
+
+  Counter( sOut, vWorker, "dropped_total", "Queries not answered, or replies the kernel would not take.", &worker_metrics::dropped );
+  Counter( sOut, vWorker, "cache_hits_total", "Answers from the answer cache.", &worker_metrics::cache_hits );
+  Counter( sOut, vWorker, "cache_misses_total", "Cache misses, answered from the zone image or upstream.", &worker_metrics::cache_misses );
+  Counter( sOut, vWorker, "cache_prefetches_total", "Popular cache entries refreshed before expiry.", &worker_metrics::cache_prefetches );
+  Counter( sOut, vWorker, "cache_stale_total", "Expired answers served when the upstream failed.", &worker_metrics::cache_stale );
+  Counter( sOut, vWorker, "cache_evictions_total", "Entries evicted from the answer cache.", &worker_metrics::cache_evictions );
+  Header( sOut, "cache_bytes", "gauge", "Bytes held by the answer caches." );
+  Sample( sOut, "cache_bytes", "", Sum( vWorker, []( const worker_metrics& m ){ return uint64_t( m.cache_bytes.get() ); } ) );
+  Counter( sOut, vWorker, "forwarded_total", "Queries handed to the forwarder.", &worker_metrics::forwarded );
+  Counter( sOut, vWorker, "upstream_queries_total", "Queries sent upstream.", &worker_metrics::upstream_queries );
+  Counter( sOut, vWorker, "upstream_coalesced_total", "Queries joined to one already upstream.", &worker_metrics::upstream_coalesced );
+  Counter( sOut, vWorker, "upstream_retries_total", "Upstream udp attempts timed out.", &worker_metrics::upstream_retries );
+  Counter( sOut, vWorker, "upstream_tcp_total", "Truncated upstream answers asked again over tcp.", &worker_metrics::upstream_tcp );
+  Counter( sOut, vWorker, "upstream_failures_total", "Upstream queries answered with SERVFAIL.", &worker_metrics::upstream_failures );
+  Counter( sOut, vWorker, "rrl_slipped_total", "Udp responses over the rate limit, sent truncated.", &worker_metrics::rrl_slipped );
+  Counter( sOut, vWorker, "rrl_dropped_total", "Udp responses over the rate limit, not sent.", &worker_metrics::rrl_dropped );
+  Counter( sOut, vWorker, "tcp_replies_dropped_total", "Tcp replies dropped on a full session write queue.", &worker_metrics::tcp_replies_dropped );
+  Counter( sOut, vWorker, "udp_heap_allocations_total", "Heap allocations made while handling udp queries.", &worker_metrics::udp_heap_allocations );
+
+  Histogram( sOut, vWorker, "latency_seconds", "Time from query to reply, answered locally.", &worker_metrics::latency );
+  Histogram( sOut, vWorker, "upstream_latency_seconds", "Time from upstream query to its answer.", &worker_metrics::upstream_latency );
+
+  Header( sOut, "worker_queries_total", "counter", "Queries received, by worker." );
+  for ( std::size_t ix = 0; ix < vWorker.size(); ix++ ) {
+    Sample( sOut, "worker_queries_total", "worker=\"" + std::to_string( ix ) + "\"", vWorker[ ix ]->total_queries() );
+  }
+}
+
+} // namespace metrics
@@ -0,0 +1,119 @@
+/*
+ * File:   metrics.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 9:15 AM
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Counters kept per worker thread.  Each has a single writer, its thread, so
+// an increment is a relaxed load and store (a plain add, no locked
+// instruction); any thread may read them.  Readers merge the workers when
+// rendering, in the Prometheus text format.
+
+namespace metrics {
+
+class counter {
+public:
+  counter(): m_n( 0 ) {}
+  void add( uint64_t n = 1 ) { m_n.store( m_n.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed ); }
+  uint64_t get() const { return m_n.load( std::memory_order_relaxed ); }
+private:
+  std::atomic<uint64_t> m_n;
+};
+
+// moved up and down by its owners, all in the same thread
+class gauge {
+public:
+  gauge(): m_n( 0 ) {}
+  void add( int64_t n ) { m_n.store( m_n.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed ); }
+  int64_t get() const { return m_n.load( std::memory_order_relaxed ); }
+private:
+  std::atomic<int64_t> m_n;
+};
+
+// power of two buckets of nanoseconds:  bucket ix holds values below
+//   2^( first_shift + ix ), the last one everything else
+class histogram {
+public:
+  enum { first_shift = 8, buckets = 24 };  // 256 ns .. about 2 s, then +Inf
+
+  void record( uint64_t ns ) {
+    const unsigned msb = ( 0 == ns ) ? 0 : 63 - __builtin_clzll( ns );
+    const unsigned ix = ( first_shift > msb ) ? 0 : msb - first_shift + 1;
+    m_bucket[ ( buckets < ix ) ? unsigned( buckets ) : ix ].add();
+    m_sum.add( ns );
+  }
+
+  uint64_t bucket( unsigned ix ) const { return m_bucket[ ix ].get(); }
+  uint64_t sum() const { return m_sum.get(); }
+
+private:
+  std::array<counter, buckets + 1> m_bucket;
+  counter m_sum;
+};
+
+enum transport { udp, tcp, transports };
+
+// the qtypes broken out, others are counted together
+enum qtype_index { A, NS, CNAME, SOA, PTR, MX, TXT, AAAA, SRV, ANY, other, qtypes };
+qtype_index QtypeIndex( uint16_t qtype );
+
+struct worker_metrics {
+
+  counter queries[ transports ][ qtypes ];
+  counter responses[ transports ][ 16 ]; // by rcode
+  counter rx_bytes[ transports ];
+  counter tx_bytes[ transports ];
+  counter dropped;          // malformed beyond reply, or replies the kernel wouldn't take
+
+  counter cache_hits;
+  counter cache_misses;
+  counter cache_prefetches; // popular entries refreshed before they expire
+  counter cache_stale;      // expired answers served when the upstream failed
+  counter cache_evictions;
+  gauge cache_bytes;        // held by the answer caches, against their budgets
+
+  counter forwarded;        // misses handed to the forwarder
+  counter upstream_queries; // sent upstream, after coalescing
+  counter upstream_coalesced;
+  counter upstream_retries; // udp timeouts
+  counter upstream_tcp;     // truncated, asked again over tcp
+  counter upstream_failures;
+
+  counter rrl_slipped;      // over the rate limit, sent truncated
+  counter rrl_dropped;      // over the rate limit, not sent
+
+  counter tcp_replies_dropped; // a tcp session's write queue full
+
+  counter udp_heap_allocations; // made while handling udp queries, none in steady state
+
+  histogram latency;          // query in to reply out, answered locally
+  histogram upstream_latency; // upstream query to its answer
+
+  uint64_t total_queries() const;
+};
+
+// for parts built without a worker around them, never rendered
+worker_metrics& Discard();
+
+typedef std::vector<const worker_metrics*> vWorker_t;
+
+// every counter, summed over the workers, appended to sOut
+void Render( const vWorker_t&, std::string& sOut );
+
+// one sample of a gauge or counter without labels, with its HELP and TYPE
+void Append( std::string& sOut, const char* szName, const char* szType, const char* szHelp, double value );
+
+} // namespace metrics
+
+#endif /* METRICS_H */
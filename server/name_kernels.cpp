@@ -0,0 +1,209 @@
+/*
+ * File:   name_kernels.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 6:05 PM
+ */
+
+#include <cstring>
+#include <algorithm>
+
+#if defined( __SSE2__ )
+#include <immintrin.h>
+#endif
+
+#include "dns.h"
+#include "name_kernels.h"
+
+namespace dns {
+
+namespace {
+
+  inline uint64_t Load64( const uint8_t* p ) {
+    uint64_t word;
+    std::memcpy( &word, p, sizeof( word ) );
+    return word;
+  }
+
+  // label lengths only, returns the name's length or 0
+  inline std::size_t Validate( const uint8_t* pWire, std::size_t lenMax ) {
+    const std::size_t lenLimit = std::min<std::size_t>( lenMax, max_name_length );
+    std::size_t ix( 0 );
+    while ( ix < lenLimit ) {
+      const uint8_t len = pWire[ ix ];
+      if ( 0 == len ) return ix + 1;
+      if ( max_label_length < len ) return 0; // pointers included
+      ix += 1 + len;
+    }
+    return 0;
+  }
+
+#if defined( __SSE2__ )
+
+  inline __m128i Lower16( __m128i v ) {
+    const __m128i upper = _mm_and_si128(
+      _mm_cmpgt_epi8( v, _mm_set1_epi8( 'A' - 1 ) ),  // signed:  octets >= 0x80 are not upper case either
+      _mm_cmplt_epi8( v, _mm_set1_epi8( 'Z' + 1 ) ) );
+    return _mm_or_si128( v, _mm_and_si128( upper, _mm_set1_epi8( 0x20 ) ) );
+  }
+
+  inline uint64_t Mix16( uint64_t hash, __m128i v ) {
+    hash = mix( hash, static_cast<uint64_t>( _mm_cvtsi128_si64( v ) ) );
+    return mix( hash, static_cast<uint64_t>( _mm_cvtsi128_si64( _mm_unpackhi_epi64( v, v ) ) ) );
+  }
+
+#endif
+
+#if defined( __AVX2__ )
+
+  inline __m256i Lower32( __m256i v ) {
+    const __m256i upper = _mm256_and_si256(
+      _mm256_cmpgt_epi8( v, _mm256_set1_epi8( 'A' - 1 ) ),
+      _mm256_cmpgt_epi8( _mm256_set1_epi8( 'Z' + 1 ), v ) );
+    return _mm256_or_si256( v, _mm256_and_si256( upper, _mm256_set1_epi8( 0x20 ) ) );
+  }
+
+#endif
+
+} // namespace anonymous
+
+// ==== scalar
+
+namespace scalar {
+
+void lower( const uint8_t* pSrc, std::size_t len, uint8_t* pDst ) {
+  for ( std::size_t ix = 0; ix < len; ix++ ) pDst[ ix ] = to_lower( pSrc[ ix ] );
+}
+
+bool equal_nocase( const uint8_t* a, const uint8_t* b, std::size_t len ) {
+  for ( std::size_t ix = 0; ix < len; ix++ ) {
+    if ( to_lower( a[ ix ] ) != to_lower( b[ ix ] ) ) return false;
+  }
+  return true;
+}
+
+uint64_t hash( const uint8_t* p, std::size_t len, uint64_t seed ) {
+  uint64_t hash( seed );
+  std::size_t ix( 0 );
+  for ( ; ix + 8 <= len; ix += 8 ) hash = mix( hash, Load64( p + ix ) );
+  if ( ix < len ) {
+    uint64_t word( 0 ); // zero padded
+    std::memcpy( &word, p + ix, len - ix );
+    hash = mix( hash, word );
+  }
+  return mix( hash, len );
+}
+
+std::size_t canonical( const uint8_t* pWire, std::size_t lenMax, uint8_t* pDst, uint64_t& hash ) {
+  const std::size_t len = Validate( pWire, lenMax );
+  if ( 0 == len ) return 0;
+  lower( pWire, len, pDst );
+  hash = scalar::hash( pDst, len );
+  return len;
+}
+
+} // namespace scalar
+
+// ==== vector, when available
+
+#if defined( __SSE2__ )
+
+void lower( const uint8_t* pSrc, std::size_t len, uint8_t* pDst ) {
+  std::size_t ix( 0 );
+#if defined( __AVX2__ )
+  for ( ; ix + 32 <= len; ix += 32 ) {
+    const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + ix ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + ix ), Lower32( v ) );
+  }
+#endif
+  for ( ; ix + 16 <= len; ix += 16 ) {
+    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + ix ) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + ix ), Lower16( v ) );
+  }
+  if ( ix < len ) {
+    uint8_t block[ 16 ] = { 0 };
+    std::memcpy( block, pSrc + ix, len - ix );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( block ),
+      Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( block ) ) ) );
+    std::memcpy( pDst + ix, block, len - ix );
+  }
+}
+
+bool equal_nocase( const uint8_t* a, const uint8_t* b, std::size_t len ) {
+  std::size_t ix( 0 );
+#if defined( __AVX2__ )
+  for ( ; ix + 32 <= len; ix += 32 ) {
+    const __m256i va = Lower32( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + ix ) ) );
+    const __m256i vb = Lower32( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( b + ix ) ) );
+    if ( -1 != _mm256_movemask_epi8( _mm256_cmpeq_epi8( va, vb ) ) ) return false;
+  }
+#endif
+  for ( ; ix + 16 <= len; ix += 16 ) {
+    const __m128i va = Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + ix ) ) );
+    const __m128i vb = Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + ix ) ) );
+    if ( 0xffff != _mm_movemask_epi8( _mm_cmpeq_epi8( va, vb ) ) ) return false;
+  }
+  if ( ix < len ) {
+    uint8_t blockA[ 16 ] = { 0 };
+    uint8_t blockB[ 16 ] = { 0 };
+    std::memcpy( blockA, a + ix, len - ix );
+    std::memcpy( blockB, b + ix, len - ix );
+    const __m128i va = Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( blockA ) ) );
+    const __m128i vb = Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( blockB ) ) );
+    if ( 0xffff != _mm_movemask_epi8( _mm_cmpeq_epi8( va, vb ) ) ) return false;
+  }
+  return true;
+}
+
+uint64_t hash( const uint8_t* p, std::size_t len, uint64_t seed ) {
+  return scalar::hash( p, len, seed ); // word at a time already, each step depends on the last
+}
+
+std::size_t canonical( const uint8_t* pWire, std::size_t lenMax, uint8_t* pDst, uint64_t& hash ) {
+
+  const std::size_t len = Validate( pWire, lenMax );
+  if ( 0 == len ) return 0;
+
+  // fold, store and hash each block while it is in a register
+  uint64_t value( hash_seed );
+  std::size_t ix( 0 );
+#if defined( __AVX2__ )
+  for ( ; ix + 32 <= len; ix += 32 ) {
+    const __m256i v = Lower32( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pWire + ix ) ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + ix ), v );
+    value = Mix16( value, _mm256_castsi256_si128( v ) );
+    value = Mix16( value, _mm256_extracti128_si256( v, 1 ) );
+  }
+#endif
+  for ( ; ix + 16 <= len; ix += 16 ) {
+    const __m128i v = Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pWire + ix ) ) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + ix ), v );
+    value = Mix16( value, v );
+  }
+  if ( ix < len ) {
+    const std::size_t n( len - ix );
+    uint8_t block[ 16 ] = { 0 };
+    std::memcpy( block, pWire + ix, n );
+    const __m128i v = Lower16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( block ) ) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( block ), v );
+    std::memcpy( pDst + ix, block, n );
+    value = mix( value, Load64( block ) ); // the words scalar::hash would see, zero padded
+    if ( 8 < n ) value = mix( value, Load64( block + 8 ) );
+  }
+  hash = mix( value, len );
+  return len;
+}
+
+#else
+
+void lower( const uint8_t* pSrc, std::size_t len, uint8_t* pDst ) { scalar::lower( pSrc, len, pDst ); }
+bool equal_nocase( const uint8_t* a, const uint8_t* b, std::size_t len ) { return scalar::equal_nocase( a, b, len ); }
+uint64_t hash( const uint8_t* p, std::size_t len, uint64_t seed ) { return scalar::hash( p, len, seed ); }
+std::size_t canonical( const uint8_t* pWire, std::size_t lenMax, uint8_t* pDst, uint64_t& hash ) {
+  return scalar::canonical( pWire, lenMax, pDst, hash );
+}
+
+#endif
+
+} // namespace dns
@@ -0,0 +1,62 @@
+/*
+ * File:   name_kernels.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 6:05 PM
+ */
+
+#ifndef NAME_KERNELS_H
+#define NAME_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Case folding, comparison and hashing of wire format names, the inner loops
+// of every cache probe and zone lookup.
+//
+// The dns namespace versions use AVX2 when the build enables it (-mavx2),
+// otherwise SSE2 (always there on x86-64), otherwise the dns::scalar versions,
+// which are kept for other targets and for the benchmark (bench/) to check
+// against.  Both give identical results, hashes included.
+//
+// Folding whole blocks is safe for length octets:  a valid one is at most 63,
+// below 'A', so only label octets change.  Blocks never read past the end:
+// the tail goes through a small zero padded buffer.
+
+namespace dns {
+
+// FNV-1a offset basis, as a seed for hash() and mix()
+const uint64_t hash_seed = 14695981039346656037ull;
+
+// one 64 bit word into a running hash
+inline uint64_t mix( uint64_t hash, uint64_t word ) {
+  hash = ( hash ^ word ) * 0x9e3779b97f4a7c15ull;
+  return hash ^ ( hash >> 29 );
+}
+
+// len octets from pSrc to pDst folded to lower case, pDst may equal pSrc
+void lower( const uint8_t* pSrc, std::size_t len, uint8_t* pDst );
+
+// len octets of a and b equal, ignoring case
+bool equal_nocase( const uint8_t* a, const uint8_t* b, std::size_t len );
+
+// octets hashed eight at a time, as they are (fold first for case insensitivity)
+uint64_t hash( const uint8_t* p, std::size_t len, uint64_t seed = hash_seed );
+
+// in one pass over an uncompressed wire format name of at most lenMax octets:
+//   check the label lengths (no pointers, labels <= 63, name <= 255),
+//   write it folded to lower case into pDst and hash what was written.
+//   Returns the name's length, 0 when it is not valid.
+std::size_t canonical( const uint8_t* pWire, std::size_t lenMax, uint8_t* pDst, uint64_t& hash );
+
+namespace scalar {
+  void lower( const uint8_t* pSrc, std::size_t len, uint8_t* pDst );
+  bool equal_nocase( const uint8_t* a, const uint8_t* b, std::size_t len );
+  uint64_t hash( const uint8_t* p, std::size_t len, uint64_t seed = hash_seed );
+  std::size_t canonical( const uint8_t* pWire, std::size_t lenMax, uint8_t* pDst, uint64_t& hash );
+}
+
+} // namespace dns
+
+#endif /* NAME_KERNELS_H */
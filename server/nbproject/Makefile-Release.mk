@@ -35,8 +35,24 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/allocations.o \
+	${OBJECTDIR}/answer_cache.o \
+	${OBJECTDIR}/dns_build.o \
+	${OBJECTDIR}/dns_parse.o \
+	${OBJECTDIR}/forwarder.o \
+	${OBJECTDIR}/logger.o \
 	${OBJECTDIR}/main.o \
-	${OBJECTDIR}/session.o
+	${OBJECTDIR}/metrics.o \
+	${OBJECTDIR}/name_kernels.o \
+	${OBJECTDIR}/query_log.o \
+	${OBJECTDIR}/responder.o \
+	${OBJECTDIR}/rrl.o \
+	${OBJECTDIR}/server_udp.o \
+	${OBJECTDIR}/session.o \
+	${OBJECTDIR}/stats_server.o \
+	${OBJECTDIR}/uring.o \
+	${OBJECTDIR}/zone_image.o \
+	${OBJECTDIR}/zone_store.o
 
 
 # C Compiler Flags
@@ -53,7 +69,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=
+LDLIBSOPTIONS=-lpthread
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -63,15 +79,95 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/server: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/server ${OBJECTFILES} ${LDLIBSOPTIONS}
 
+${OBJECTDIR}/allocations.o: allocations.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/allocations.o allocations.cpp
+
+${OBJECTDIR}/answer_cache.o: answer_cache.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/answer_cache.o answer_cache.cpp
+
+${OBJECTDIR}/dns_build.o: dns_build.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/dns_build.o dns_build.cpp
+
+${OBJECTDIR}/dns_parse.o: dns_parse.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/dns_parse.o dns_parse.cpp
+
+${OBJECTDIR}/forwarder.o: forwarder.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/forwarder.o forwarder.cpp
+
+${OBJECTDIR}/logger.o: logger.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/logger.o logger.cpp
+
 ${OBJECTDIR}/main.o: main.cpp
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
-	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+
+${OBJECTDIR}/metrics.o: metrics.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/metrics.o metrics.cpp
+
+${OBJECTDIR}/name_kernels.o: name_kernels.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/name_kernels.o name_kernels.cpp
+
+${OBJECTDIR}/query_log.o: query_log.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/query_log.o query_log.cpp
+
+${OBJECTDIR}/responder.o: responder.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/responder.o responder.cpp
+
+${OBJECTDIR}/rrl.o: rrl.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/rrl.o rrl.cpp
+
+${OBJECTDIR}/server_udp.o: server_udp.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/server_udp.o server_udp.cpp
 
 ${OBJECTDIR}/session.o: session.cpp
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
-	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/session.o session.cpp
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/session.o session.cpp
+
+${OBJECTDIR}/stats_server.o: stats_server.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/stats_server.o stats_server.cpp
+
+${OBJECTDIR}/uring.o: uring.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/uring.o uring.cpp
+
+${OBJECTDIR}/zone_image.o: zone_image.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/zone_image.o zone_image.cpp
+
+${OBJECTDIR}/zone_store.o: zone_store.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -std=c++20 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/zone_store.o zone_store.cpp
 
 # Subprojects
 .build-subprojects:
@@ -0,0 +1,336 @@
+/*
+ * File:   query_log.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 24, 2026, 9:30 AM
+ */
+
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <condition_variable>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+
+#include "logger.h"
+#include "query_log.h"
+
+namespace query_log {
+
+std::atomic<bool> g_bEnabled( false );
+
+namespace {
+
+  enum { alignment = 8 };
+
+  std::size_t Aligned( std::size_t n ) { return ( n + alignment - 1 ) & ~std::size_t( alignment - 1 ); }
+
+  // one producer, the owning thread;  one consumer, the background thread.
+  //   A frame is never split:  one that would run past the end is preceded
+  //   by a skip frame to the end, and starts over at the front.
+  struct ring_t {
+
+    enum { size = 4 << 20 }; // octets, a power of two
+
+    explicit ring_t( uint16_t ix_ ): ix( ix_ ), nTailCached( 0 ), nHead( 0 ), nDropped( 0 ), nTail( 0 ) {}
+
+    const uint16_t ix;  // frame_t::worker
+
+    // producer side
+    uint64_t nTailCached;
+    std::atomic<uint64_t> nHead;
+    std::atomic<uint64_t> nDropped;
+
+    // consumer side
+    alignas( 64 ) std::atomic<uint64_t> nTail;
+
+    alignas( 64 ) uint8_t rOctet[ size ];
+
+    frame_t& At( uint64_t n ) { return *reinterpret_cast<frame_t*>( &rOctet[ n & ( size - 1 ) ] ); }
+  };
+
+  std::mutex g_mutexRings;  // adding a thread, or a drain pass taking stock
+  std::vector<std::unique_ptr<ring_t> > g_vRing; // kept to the end, threads come and go rarely
+
+  thread_local ring_t* t_pRing( nullptr );
+
+  ring_t& Ring() {
+    if ( nullptr == t_pRing ) {
+      std::lock_guard<std::mutex> lock( g_mutexRings );
+      g_vRing.emplace_back( new ring_t( static_cast<uint16_t>( g_vRing.size() ) ) );
+      t_pRing = g_vRing.back().get();
+    }
+    return *t_pRing;
+  }
+
+  int64_t Now() {
+    timespec ts;
+    clock_gettime( CLOCK_REALTIME, &ts ); // vdso, no system call
+    return int64_t( ts.tv_sec ) * 1000000000 + ts.tv_nsec;
+  }
+
+  // the file being filled, mapped whole
+  class segment {
+  public:
+
+    segment( const options_t& options ): m_options( options ), m_fd( -1 ), m_pBase( nullptr ), m_lenUsed( 0 ), m_sequence( 0 ), m_nErrno( 0 ) {
+      const time_t seconds = std::time( nullptr );
+      struct tm tm;
+      localtime_r( &seconds, &tm );
+      char sz[ 32 ];
+      std::strftime( sz, sizeof( sz ), "%Y%m%d-%H%M%S", &tm );
+      m_sStarted = sz;
+    }
+
+    ~segment() { Close(); }
+
+    bool Open( std::string& sError ) {
+      char sz[ 16 ];
+      std::snprintf( sz, sizeof( sz ), "%06llu", static_cast<unsigned long long>( m_sequence ) );
+      const std::string sName( m_options.sPath + '.' + m_sStarted + '.' + sz + ".qlog" );
+
+      m_fd = open( sName.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+      if ( 0 > m_fd ) {
+        m_nErrno = errno;
+        sError = sName + ": " + std::strerror( m_nErrno );
+        return false;
+      }
+      if ( 0 > ftruncate( m_fd, m_options.nSegmentBytes ) ) {
+        m_nErrno = errno;
+        sError = sName + ": " + std::strerror( m_nErrno );
+        close( m_fd );
+        m_fd = -1;
+        return false;
+      }
+      void* p = mmap( nullptr, m_options.nSegmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0 );
+      if ( MAP_FAILED == p ) {
+        m_nErrno = errno;
+        sError = sName + ": mmap " + std::strerror( m_nErrno );
+        close( m_fd );
+        m_fd = -1;
+        return false;
+      }
+      m_pBase = static_cast<uint8_t*>( p );
+
+      segment_t& header( *reinterpret_cast<segment_t*>( m_pBase ) );
+      std::memcpy( header.magic, "cppdnsql", sizeof( header.magic ) );
+      header.order = segment_t::byte_order;
+      header.version = segment_t::current_version;
+      header.lenHeader = sizeof( segment_t );
+      header.sequence = m_sequence;
+      header.ns = Now();
+      m_lenUsed = sizeof( segment_t );
+
+      m_dequeName.push_back( sName );
+      if ( ( 0 != m_options.nSegmentsKept ) && ( m_options.nSegmentsKept < m_dequeName.size() ) ) {
+        unlink( m_dequeName.front().c_str() );
+        m_dequeName.pop_front();
+      }
+      m_sequence++;
+      return true;
+    }
+
+    // cut to what was written;  the page cache writes it out from here
+    void Close() {
+      if ( nullptr != m_pBase ) {
+        munmap( m_pBase, m_options.nSegmentBytes );
+        m_pBase = nullptr;
+      }
+      if ( 0 <= m_fd ) {
+        if ( 0 > ftruncate( m_fd, m_lenUsed ) ) {} // left full length, the reader stops at the zeros
+        close( m_fd );
+        m_fd = -1;
+      }
+    }
+
+    // a frame from a ring, into the current segment or the next;  false with no segment to take it
+    bool Put( const frame_t& frame ) {
+      if ( ( nullptr != m_pBase ) && ( m_options.nSegmentBytes - m_lenUsed < frame.lenFrame ) ) {
+        Close();
+        if ( !Open( m_sError ) ) {
+          // the path is in the start up message, and would crowd the reason out of the record
+          LOG_ERROR( "query log segment {}: {}, logging stops", m_sequence, std::strerror( m_nErrno ) );
+          return false;
+        }
+      }
+      if ( nullptr == m_pBase ) return false;
+      std::memcpy( m_pBase + m_lenUsed, &frame, frame.lenFrame );
+      m_lenUsed += frame.lenFrame;
+      return true;
+    }
+
+  private:
+    const options_t m_options;
+    int m_fd;
+    uint8_t* m_pBase;
+    std::size_t m_lenUsed;
+    uint64_t m_sequence;
+    int m_nErrno;       // of the last failed Open
+    std::string m_sStarted;
+    std::string m_sError;
+    std::deque<std::string> m_dequeName; // of this run, oldest first
+  };
+
+  std::unique_ptr<segment> g_pSegment;
+
+  std::thread g_thread;
+  std::mutex g_mutexWake;
+  std::condition_variable g_cvWake;
+  bool g_bStop( false );
+
+  // one pass over every ring; true when anything was found
+  bool Drain() {
+
+    std::vector<ring_t*> vRing;
+    {
+      std::lock_guard<std::mutex> lock( g_mutexRings );
+      for ( auto& pRing: g_vRing ) vRing.push_back( pRing.get() );
+    }
+
+    bool bAny( false );
+    for ( ring_t* pRing: vRing ) {
+      const uint64_t nHead = pRing->nHead.load( std::memory_order_acquire );
+      uint64_t nTail = pRing->nTail.load( std::memory_order_relaxed );
+      if ( nHead == nTail ) continue;
+      bAny = true;
+      while ( nTail != nHead ) {
+        const frame_t& frame( pRing->At( nTail ) );
+        if ( ( skip != frame.type ) && !g_pSegment->Put( frame ) ) {
+          g_bEnabled.store( false, std::memory_order_relaxed );
+        }
+        nTail += frame.lenFrame;
+      }
+      pRing->nTail.store( nTail, std::memory_order_release );
+    }
+    return bAny;
+  }
+
+  void Run() {
+    std::unique_lock<std::mutex> lock( g_mutexWake );
+    while ( !g_bStop ) {
+      lock.unlock();
+      const bool bAny = Drain();
+      lock.lock();
+      // producers never signal, that would be a syscall on their side;  poll instead
+      if ( !bAny && !g_bStop ) g_cvWake.wait_for( lock, std::chrono::milliseconds( 10 ) );
+    }
+    lock.unlock();
+    Drain();
+  }
+
+} // namespace anonymous
+
+void Register() {
+  Ring();
+}
+
+bool Write( type_t type, transport_t transport, const peer_t& peer, const uint8_t* pMessage, std::size_t lenMessage ) {
+
+  ring_t& ring( Ring() );
+  const std::size_t lenFrame = Aligned( sizeof( frame_t ) + lenMessage );
+  const uint64_t nHead = ring.nHead.load( std::memory_order_relaxed );
+  const std::size_t lenToEnd = ring_t::size - ( nHead & ( ring_t::size - 1 ) );
+  const std::size_t lenSkip = ( lenToEnd < lenFrame ) ? lenToEnd : 0;
+
+  if ( ring_t::size < nHead + lenSkip + lenFrame - ring.nTailCached ) {
+    ring.nTailCached = ring.nTail.load( std::memory_order_acquire );
+    if ( ring_t::size < nHead + lenSkip + lenFrame - ring.nTailCached ) {
+      ring.nDropped.store( ring.nDropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+      return false;
+    }
+  }
+
+  if ( 0 != lenSkip ) { // the tail of the ring, a frame header always fits as all are aligned
+    frame_t& frameSkip( ring.At( nHead ) );
+    frameSkip.lenFrame = static_cast<uint32_t>( lenSkip );
+    frameSkip.type = skip;
+  }
+
+  frame_t& frame( ring.At( nHead + lenSkip ) );
+  frame.lenFrame = static_cast<uint32_t>( lenFrame );
+  frame.lenMessage = static_cast<uint16_t>( lenMessage );
+  frame.type = type;
+  frame.transport = transport;
+  frame.ns = Now();
+  frame.worker = ring.ix;
+  frame.reserved = 0;
+  frame.peer = peer;
+  uint8_t* pFrame = reinterpret_cast<uint8_t*>( &frame );
+  std::memcpy( pFrame + sizeof( frame_t ), pMessage, lenMessage );
+  std::memset( pFrame + sizeof( frame_t ) + lenMessage, 0, lenFrame - sizeof( frame_t ) - lenMessage );
+
+  ring.nHead.store( nHead + lenSkip + lenFrame, std::memory_order_release );
+  return true;
+}
+
+peer_t Peer( const sockaddr* pAddr ) {
+  peer_t peer;
+  std::memset( &peer, 0, sizeof( peer ) );
+  if ( nullptr == pAddr ) return peer;
+  switch ( pAddr->sa_family ) {
+    case AF_INET: {
+        const sockaddr_in& addr( *reinterpret_cast<const sockaddr_in*>( pAddr ) );
+        peer.family = 4;
+        peer.port = ntohs( addr.sin_port );
+        std::memcpy( peer.addr, &addr.sin_addr, 4 );
+      }
+      break;
+    case AF_INET6: {
+        const sockaddr_in6& addr( *reinterpret_cast<const sockaddr_in6*>( pAddr ) );
+        peer.family = 6;
+        peer.port = ntohs( addr.sin6_port );
+        std::memcpy( peer.addr, &addr.sin6_addr, 16 );
+      }
+      break;
+  }
+  return peer;
+}
+
+bool Start( const options_t& options, std::string& sError ) {
+  if ( g_thread.joinable() ) return true;
+  if ( options.nSegmentBytes < sizeof( segment_t ) + sizeof( frame_t ) + 0xffff ) {
+    sError = "query log segments hold at least one largest message";
+    return false;
+  }
+  g_pSegment.reset( new segment( options ) );
+  if ( !g_pSegment->Open( sError ) ) {
+    g_pSegment.reset();
+    return false;
+  }
+  g_bStop = false;
+  g_thread = std::thread( Run );
+  g_bEnabled.store( true, std::memory_order_relaxed );
+  return true;
+}
+
+void Stop() {
+  if ( !g_thread.joinable() ) return;
+  g_bEnabled.store( false, std::memory_order_relaxed );
+  {
+    std::lock_guard<std::mutex> lock( g_mutexWake );
+    g_bStop = true;
+  }
+  g_cvWake.notify_one();
+  g_thread.join();
+  g_pSegment.reset();
+}
+
+uint64_t Dropped() {
+  std::lock_guard<std::mutex> lock( g_mutexRings );
+  uint64_t n( 0 );
+  for ( auto& pRing: g_vRing ) n += pRing->nDropped.load( std::memory_order_relaxed );
+  return n;
+}
+
+} // namespace query_log
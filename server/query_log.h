@@ -0,0 +1,97 @@
+/*
+ * File:   query_log.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 24, 2026, 9:30 AM
+ */
+
+#ifndef QUERY_LOG_H
+#define QUERY_LOG_H
+
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/socket.h>
+
+// Every query and every reply, as they went over the wire, for analysis off
+// line (in the spirit of dnstap, without the protobuf).  Nothing is formatted
+// on the io threads:  a call copies a fixed header and the message into a
+// byte ring owned by the calling thread, one producer and one consumer, as
+// the logger does.  A background thread drains the rings into segment files,
+// each mapped whole, and moves on to the next when one fills.  A full ring
+// drops the frame and counts it, the io thread never waits.
+//
+// A segment:  segment_t, then frames back to back, each a frame_t, the
+// message, and padding to a multiple of 8.  Files are closed at their length;
+// one cut short by a crash runs to zeros, where the reader stops.  Host byte
+// order throughout, segment_t::order tells which.  'qlogread' decodes them.
+
+namespace query_log {
+
+struct options_t {
+  std::string sPath;           // segments are <sPath>.<start time>.<sequence>.qlog, empty for no log
+  std::size_t nSegmentBytes;
+  unsigned nSegmentsKept;      // the oldest of this run removed past this, 0 to keep all
+  options_t(): nSegmentBytes( 64 << 20 ), nSegmentsKept( 0 ) {}
+};
+
+struct segment_t {
+  enum : uint32_t { byte_order = 0x01020304, current_version = 1 };
+  char magic[ 8 ];             // "cppdnsql"
+  uint32_t order;              // byte_order as written
+  uint16_t version;
+  uint16_t lenHeader;          // the first frame follows
+  uint64_t sequence;           // from 0, in this run
+  int64_t ns;                  // opened, system clock
+};
+
+static_assert( 32 == sizeof( segment_t ), "segment header layout" );
+
+enum type_t: uint8_t { skip = 0, query = 1, response = 2 };  // skip:  ring padding, never in a file
+enum transport_t: uint8_t { udp = 0, tcp = 1 };
+
+// the client
+struct peer_t {
+  uint8_t family;              // 4, 6, or 0 unknown
+  uint8_t reserved;
+  uint16_t port;
+  uint8_t addr[ 16 ];          // v4 in the first four
+};
+
+struct frame_t {
+  uint32_t lenFrame;           // this header, the message and padding
+  uint16_t lenMessage;
+  type_t type;
+  transport_t transport;
+  int64_t ns;                  // system clock, received or sent
+  uint16_t worker;             // thread, in order of first frame
+  uint16_t reserved;
+  peer_t peer;
+};
+
+static_assert( 40 == sizeof( frame_t ), "frame header layout" );
+
+extern std::atomic<bool> g_bEnabled;
+
+inline bool Enabled() { return g_bEnabled.load( std::memory_order_relaxed ); }
+
+// the first segment opened and the background thread running;  false with sError filled in
+bool Start( const options_t&, std::string& sError );
+void Stop();    // drain what is left, close the segment, and join
+
+uint64_t Dropped();  // frames lost to full rings
+
+peer_t Peer( const sockaddr* ); // nullptr for unknown
+
+// the calling thread's ring made ahead of its first frame, off the query path
+void Register();
+
+// into the calling thread's ring, made on first use;  false when full
+bool Write( type_t, transport_t, const peer_t&, const uint8_t* pMessage, std::size_t lenMessage );
+
+} // namespace query_log
+
+#endif /* QUERY_LOG_H */
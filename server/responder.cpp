@@ -0,0 +1,329 @@
+/*
+ * File:   responder.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 10:10 AM
+ */
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+#include "dns_build.h"
+#include "zone_image.h"
+#include "responder.h"
+
+namespace {
+
+  enum { max_chain = 8 }; // CNAMEs followed within the image
+
+  // RFC 2308 section 5:  the lesser of the SOA ttl and its minimum field
+  uint32_t NegativeTtl( const zone_image& zone, const image::rrset_t& soa ) {
+    const uint8_t* p = zone.rdata( soa );
+    uint16_t len;
+    std::memcpy( &len, p, sizeof( len ) );
+    return std::min( soa.ttl, dns::get32( p + sizeof( len ) + len - 4 ) );
+  }
+
+}
+
+const std::size_t responder::forward;
+
+#if defined( RESPONDER_STAGE_TIMES )
+
+namespace {
+  std::atomic<uint64_t> rnsStage[ static_cast<unsigned>( responder::stage::count ) ];
+}
+
+uint64_t responder::StageNanoseconds( stage stage_ ) {
+  return rnsStage[ static_cast<unsigned>( stage_ ) ].load( std::memory_order_relaxed );
+}
+
+void responder::stage_clock::Lap( stage stage_ ) {
+  const std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+  rnsStage[ static_cast<unsigned>( stage_ ) ].fetch_add(
+    std::chrono::duration_cast<std::chrono::nanoseconds>( tNow - tLap ).count(), std::memory_order_relaxed );
+  tLap = tNow;
+}
+
+#endif
+
+responder::responder(
+  const zone_image* pZone, forwarder* pForwarder, metrics::worker_metrics& metrics_, metrics::transport transport,
+  const answer_cache::options_t& optionsCache, uint16_t nUdpPayload )
+  : m_pZone( pZone ), m_pForwarder( pForwarder ), m_flags( 0 ), m_lenLimit( 0 ), m_bTrimmed( false ),
+    m_nUdpPayload( std::max<uint16_t>( dns::max_udp_length, nUdpPayload ) ),
+    m_metrics( metrics_ ), m_transport( transport ), m_cache( optionsCache, metrics_ ),
+    m_vScratch( 0xffff ), m_pClient( nullptr )
+{
+}
+
+responder::~responder() {
+}
+
+std::size_t responder::Process( const uint8_t* pQuery, std::size_t lenQuery, uint8_t* pReply, std::size_t lenReplyMax ) {
+
+  const auto tStart = std::chrono::steady_clock::now();
+  m_metrics.rx_bytes[ m_transport ].add( lenQuery );
+  if ( query_log::Enabled() ) {
+    query_log::Write( query_log::query, Transport(), query_log::Peer( m_pClient ), pQuery, lenQuery );
+  }
+
+  const std::size_t lenReply = Respond( pQuery, lenQuery, pReply, lenReplyMax );
+
+  if ( forward == lenReply ) m_metrics.forwarded.add();
+  else if ( 0 == lenReply ) m_metrics.dropped.add();
+  else {
+    m_metrics.responses[ m_transport ][ pReply[ 3 ] & 0x0f ].add();
+    m_metrics.tx_bytes[ m_transport ].add( lenReply );
+    m_metrics.latency.record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - tStart ).count() );
+    if ( query_log::Enabled() ) {
+      query_log::Write( query_log::response, Transport(), query_log::Peer( m_pClient ), pReply, lenReply );
+    }
+  }
+  return lenReply;
+}
+
+std::size_t responder::Respond( const uint8_t* pQuery, std::size_t lenQuery, uint8_t* pReply, std::size_t lenReplyMax ) {
+
+  m_clock.Start();
+  const dns::parse_status status = m_query.parse( pQuery, pQuery + lenQuery );
+  m_edns = dns::edns_view();
+  m_lenLimit = lenReplyMax;
+  m_bTrimmed = false;
+
+  if ( dns::parse_status::short_header == status ) return 0;  // nothing to answer to
+  if ( m_query.header().qr() ) return 0; // never answer a response
+
+  m_metrics.queries[ m_transport ][
+    ( ( dns::parse_status::ok == status ) && ( 0 < m_query.header().qdcount() ) )
+      ? metrics::QtypeIndex( m_query.question().qtype ) : metrics::other ].add();
+
+  if ( dns::parse_status::ok != status ) {
+    return Reject( dns::rcode::FORMERR, false, pReply, lenReplyMax );
+  }
+  if ( dns::opcode::QUERY != m_query.header().opcode() ) {
+    return Reject( dns::rcode::NOTIMP, false, pReply, lenReplyMax );
+  }
+  if ( 1 != m_query.header().qdcount() ) {
+    return Reject( dns::rcode::FORMERR, false, pReply, lenReplyMax );
+  }
+
+  m_edns = m_query.edns();
+  if ( 1 < m_edns.count ) {
+    m_edns = dns::edns_view();
+    return Reject( dns::rcode::FORMERR, true, pReply, lenReplyMax );
+  }
+  if ( m_edns.present() && ( 0 != m_edns.version ) ) {
+    return Reject( dns::rcode::BADVERS, true, pReply, lenReplyMax );
+  }
+  if ( metrics::udp == m_transport ) {
+    const std::size_t lenPayload
+      = m_edns.present() ? std::max<std::size_t>( dns::max_udp_length, m_edns.udp_payload ) : std::size_t( dns::max_udp_length );
+    m_lenLimit = std::min( lenPayload, lenReplyMax );
+  }
+
+  m_flags = CacheFlags( m_edns );
+  m_clock.Lap( stage::parse );
+  bool bRefresh;
+  std::size_t lenReply = m_cache.Lookup( m_query, m_flags, pReply, m_lenLimit, bRefresh );
+  m_clock.Lap( stage::cache );
+  if ( 0 != lenReply ) {
+    m_metrics.cache_hits.add();
+    if ( bRefresh && ( nullptr != m_pForwarder ) ) { // popular and about to expire:  ask again, nobody waits on it
+      m_metrics.cache_prefetches.add();
+      m_pForwarder->Forward( m_query, m_flags, 0, forwarder::fReply_t(), m_cache );
+    }
+  }
+  else {
+    m_metrics.cache_misses.add();
+    lenReply = Answer( pReply, lenReplyMax );
+    m_clock.Lap( stage::encode );
+    if ( ( 0 != lenReply ) && ( forward != lenReply ) && !m_bTrimmed ) m_cache.Insert( m_query, m_flags, pReply, lenReply );
+    m_clock.Lap( stage::cache );
+  }
+  return lenReply;
+}
+
+void responder::Zone( const zone_image* pZone ) {
+  m_pZone = pZone;
+  m_cache.Clear();
+}
+
+void responder::Forward( forwarder::fReply_t&& fReply, std::size_t lenReplyMax ) {
+  const query_log::peer_t peer( query_log::Enabled() ? query_log::Peer( m_pClient ) : query_log::peer_t() ); // gone by the reply
+  m_pForwarder->Forward(
+    m_query, m_flags, std::min( m_lenLimit, lenReplyMax ),
+    [this, peer, fReply_ = std::move( fReply )]( const uint8_t* pReply, std::size_t lenReply ){
+      m_metrics.responses[ m_transport ][ pReply[ 3 ] & 0x0f ].add();
+      m_metrics.tx_bytes[ m_transport ].add( lenReply );
+      if ( query_log::Enabled() ) query_log::Write( query_log::response, Transport(), peer, pReply, lenReply );
+      fReply_( pReply, lenReply );
+    },
+    m_cache );
+}
+
+uint8_t responder::CacheFlags( const dns::edns_view& edns ) {
+  uint8_t flags( 0 );
+  if ( edns.present() ) {
+    flags |= answer_cache::edns;
+    if ( edns.dnssec_ok ) flags |= answer_cache::dnssec_ok;
+  }
+  return flags;
+}
+
+std::size_t responder::Answer( uint8_t* pReply, std::size_t lenReplyMax ) {
+
+  const dns::question_view& question( m_query.question() );
+
+  const bool bForward( ( nullptr != m_pForwarder ) && m_query.header().rd() );
+
+  if ( ( nullptr == m_pZone ) || m_pZone->empty() ) {
+    if ( bForward ) return forward;
+    return Reject( dns::rcode::REFUSED, true, pReply, lenReplyMax );
+  }
+
+  uint8_t name[ dns::max_name_length ];  // wire format, owner of synthesized records
+  question.name.copy( name );
+  const uint8_t* pName( name );
+
+  uint8_t key[ dns::max_name_length ];
+  image::lookup_t lookup;
+  m_pZone->Lookup( key, image::MakeKey( pName, key ), lookup );
+  if ( ( nullptr == lookup.pZone ) && bForward ) return forward;
+  if ( ( nullptr == lookup.pZone ) || ( question.qclass != m_pZone->rrset( lookup.pZone->ixSoa ).rrclass ) ) {
+    return Reject( dns::rcode::REFUSED, true, pReply, lenReplyMax ); // not authoritative, and no recursion
+  }
+
+  rrset_part<dns::section::answer> answer( *m_pZone );
+  rrset_part<dns::section::authority> authority( *m_pZone );
+  rrset_part<dns::section::additional> additional( *m_pZone );
+  uint8_t rcode( dns::rcode::NOERROR );
+  bool bAuthoritative( true );
+
+  for ( unsigned nChain = 0; nChain < max_chain; nChain++ ) {
+
+    // a delegation at or above the name, below the apex, makes it a referral
+    if ( nullptr != lookup.pCut ) {
+      const image::rrset_t& ns( *m_pZone->FindRRset( *lookup.pCut, dns::type::NS ) );
+      authority.add( ns, m_pZone->name( *lookup.pCut ) );
+      const uint8_t* p = m_pZone->rdata( ns );
+      for ( uint16_t ix = 0; ix < ns.nRR; ix++ ) { // glue
+        uint16_t len;
+        std::memcpy( &len, p, sizeof( len ) );
+        p += sizeof( len );
+        uint8_t keyGlue[ dns::max_name_length ];
+        image::lookup_t glue;
+        m_pZone->Lookup( keyGlue, image::MakeKey( p, keyGlue ), glue );
+        if ( nullptr != glue.pNode ) {
+          for ( uint16_t type: { dns::type::A, dns::type::AAAA } ) {
+            const image::rrset_t* pRRset = m_pZone->FindRRset( *glue.pNode, type );
+            if ( nullptr != pRRset ) additional.add( *pRRset, m_pZone->name( *glue.pNode ) );
+          }
+        }
+        p += len;
+      }
+      bAuthoritative = ( 0 != answer.n ); // only for the CNAMEs leading here
+      break;
+    }
+
+    const image::rrset_t& soa( m_pZone->rrset( lookup.pZone->ixSoa ) );
+    const uint8_t* pApex( m_pZone->name( m_pZone->node( lookup.pZone->ixApex ) ) );
+
+    // RFC 4592:  with no exact match, a wildcard at the closest encloser answers for the name
+    const image::node_t* pNode( lookup.pNode );
+    const uint8_t* pOwner( nullptr );
+    if ( nullptr != pNode ) pOwner = m_pZone->name( *pNode );
+    else {
+      if ( nullptr == lookup.pWildcard ) {
+        rcode = dns::rcode::NXDOMAIN; // RFC 6604:  for the last name in the chain
+        authority.add( soa, pApex, NegativeTtl( *m_pZone, soa ) );
+        break;
+      }
+      pNode = lookup.pWildcard;
+      pOwner = pName;
+    }
+
+    const unsigned nAnswer( answer.n );
+    if ( dns::type::ANY == question.qtype ) {
+      for ( uint32_t ix = pNode->ixRRset; ( ix < pNode->ixRRset + pNode->nRRsets ) && !answer.full(); ix++ ) {
+        answer.add( m_pZone->rrset( ix ), pOwner );
+      }
+    }
+    else {
+      const image::rrset_t* pRRset = m_pZone->FindRRset( *pNode, question.qtype );
+      if ( nullptr != pRRset ) answer.add( *pRRset, pOwner );
+      else {
+        const image::rrset_t* pCname = m_pZone->FindRRset( *pNode, dns::type::CNAME );
+        if ( nullptr != pCname ) {
+          answer.add( *pCname, pOwner );
+          pName = m_pZone->rdata( *pCname ) + sizeof( uint16_t );
+          m_pZone->Lookup( key, image::MakeKey( pName, key ), lookup );
+          if ( nullptr == lookup.pZone ) break; // elsewhere, the client follows it
+          continue;
+        }
+      }
+    }
+    if ( nAnswer == answer.n ) authority.add( soa, pApex, NegativeTtl( *m_pZone, soa ) ); // NODATA
+    break;
+  }
+
+  m_clock.Lap( stage::lookup );
+
+  const dns::opt_part opt( Opt( rcode ) );
+  const dns::header_fields header( m_query.header().id(), Flags( rcode ) | ( bAuthoritative ? dns::flag::AA : 0 ) );
+  std::size_t lenReply = Encode(
+    pReply, lenReplyMax, header, dns::question_part( question ), answer, authority, additional, opt );
+  if ( 0 != lenReply ) return lenReply;
+
+  m_bTrimmed = true;
+
+  // additional records are optional (RFC 2181 section 9), unless they are a referral's glue
+  if ( 0 != additional.n ) {
+    const bool bReferral( ( 0 == answer.n ) && !bAuthoritative );
+    const dns::header_fields trimmed( header.id, header.flags | ( bReferral ? dns::flag::TC : 0 ) );
+    lenReply = Encode( pReply, lenReplyMax, trimmed, dns::question_part( question ), answer, authority, opt );
+    if ( 0 != lenReply ) return lenReply;
+  }
+
+  // the question alone, truncated, so the client retries over tcp
+  const dns::header_fields truncated( m_query.header().id(), Flags( rcode ) | dns::flag::TC );
+  return dns::encode( pReply, std::min( m_lenLimit, lenReplyMax ), truncated, dns::question_part( question ), opt );
+}
+
+template<typename... Parts>
+std::size_t responder::Encode(
+  uint8_t* pReply, std::size_t lenReplyMax, const dns::header_fields& header, const Parts&... parts
+) {
+  std::size_t lenReply = dns::encode( pReply, lenReplyMax, header, parts... );
+  if ( 0 == lenReply ) { // compression may well bring it under
+    lenReply = dns::encode( m_vScratch.data(), m_vScratch.size(), header, parts... );
+    if ( ( 0 == lenReply ) || ( lenReplyMax < lenReply ) || ( m_lenLimit < lenReply ) ) return 0;
+    std::memcpy( pReply, m_vScratch.data(), lenReply );
+  }
+  return ( m_lenLimit >= lenReply ) ? lenReply : 0;
+}
+
+uint16_t responder::Flags( uint8_t rcode ) const {
+  return dns::flag::QR | ( m_query.header().flags() & ( 0x7800 | dns::flag::RD ) ) | ( rcode & 0x0f ); // keep opcode, RD
+}
+
+// the rest of an extended rcode goes in the OPT record
+dns::opt_part responder::Opt( uint8_t rcode ) const {
+  return dns::opt_part( m_edns.present(), m_nUdpPayload, rcode >> 4, m_edns.dnssec_ok );
+}
+
+std::size_t responder::Reject( uint8_t rcode, bool bQuestion, uint8_t* pReply, std::size_t lenReplyMax ) {
+
+  const dns::header_fields header( m_query.header().id(), Flags( rcode ) );
+
+  if ( bQuestion ) {
+    return dns::encode( pReply, lenReplyMax, header, dns::question_part( m_query.question() ), Opt( rcode ) );
+  }
+  else {
+    return dns::encode( pReply, lenReplyMax, header, Opt( rcode ) );
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ * File:   responder.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 10:10 AM
+ */
+
+#ifndef RESPONDER_H
+#define RESPONDER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "dns_parse.h"
+#include "dns_build.h"
+#include "metrics.h"
+#include "forwarder.h"
+#include "answer_cache.h"
+#include "query_log.h"
+
+class zone_image;
+
+// Shared by the udp and tcp paths:  decode a query in place and encode the
+// reply into a caller supplied buffer.  One instance per thread, no locking.
+// Answers come from a compiled zone image, shared read-only between threads.
+// Recursive queries for names outside it go to the forwarder when there is
+// one, otherwise (and without an image) they are refused.
+//
+// EDNS0 (RFC 6891):  a query with an OPT record gets one back, advertising
+// nUdpPayload.  Over udp a reply is held to the size the client advertised
+// (at least 512, at most the buffer), 512 without an OPT.  A reply over that
+// loses its additional records before it is cut down to the question with
+// TC set, so most large answers stay on udp.
+//
+// With the query log on, each query and each reply sent for it is written
+// there, before any rate limiting, against the client named with Client.
+
+class responder {
+public:
+
+  explicit responder(
+    const zone_image* pZone = nullptr, forwarder* pForwarder = nullptr,
+    metrics::worker_metrics& metrics_ = metrics::Discard(), metrics::transport transport = metrics::udp,
+    const answer_cache::options_t& optionsCache = answer_cache::options_t(),
+    uint16_t nUdpPayload = dns::edns_udp_length );
+  virtual ~responder();
+
+  static const std::size_t forward = ~std::size_t( 0 );
+
+  // returns the length of the reply written to pReply, 0 when nothing is to be sent,
+  //   forward when the answer has to come from upstream:  then call Forward,
+  //   before the next Process, while the query is still in its buffer
+  std::size_t Process( const uint8_t* pQuery, std::size_t lenQuery, uint8_t* pReply, std::size_t lenReplyMax );
+
+  // fReply gets the reply, up to lenReplyMax octets or the client's limit, once the upstream answers
+  void Forward( forwarder::fReply_t&& fReply, std::size_t lenReplyMax );
+
+  // for the query log:  the sender of the next queries, to be kept valid through their Process and Forward
+  void Client( const sockaddr* pClient ) { m_pClient = pClient; }
+
+  // a reloaded image, between queries;  cached answers go with the old one
+  void Zone( const zone_image* pZone );
+
+  // where a query's time goes:  parse and checks, the answer cache (lookup and
+  //   insert), the zone image walk, and encoding the reply
+  enum class stage { parse, cache, lookup, encode, count };
+
+#if defined( RESPONDER_STAGE_TIMES )
+  // built into the bench only:  nanoseconds in a stage, summed over every responder
+  static uint64_t StageNanoseconds( stage );
+#endif
+
+protected:
+private:
+
+  const zone_image* m_pZone;
+  forwarder* m_pForwarder;    // shared with the other responders in the thread
+  dns::message_view m_query;  // re-used for each query
+  uint8_t m_flags;            // cache key flags of m_query
+  dns::edns_view m_edns;      // of m_query
+  std::size_t m_lenLimit;     // of the reply to m_query
+  bool m_bTrimmed;            // the reply to m_query lost records to m_lenLimit, not to be cached
+  const uint16_t m_nUdpPayload; // advertised
+  metrics::worker_metrics& m_metrics; // of the thread
+  const metrics::transport m_transport;
+  answer_cache m_cache;
+  vByte_t m_vScratch;         // for a reply over the caller's buffer uncompressed
+  const sockaddr* m_pClient;  // of m_query, nullptr when not known
+
+  // laps between stages of Respond;  does nothing without RESPONDER_STAGE_TIMES
+  struct stage_clock {
+#if defined( RESPONDER_STAGE_TIMES )
+    std::chrono::steady_clock::time_point tLap;
+    void Start() { tLap = std::chrono::steady_clock::now(); }
+    void Lap( stage );
+#else
+    void Start() {}
+    void Lap( stage ) {}
+#endif
+  } m_clock;
+
+  static uint8_t CacheFlags( const dns::edns_view& );
+
+  query_log::transport_t Transport() const { return ( metrics::tcp == m_transport ) ? query_log::tcp : query_log::udp; }
+
+  // Process, less the accounting
+  std::size_t Respond( const uint8_t* pQuery, std::size_t lenQuery, uint8_t* pReply, std::size_t lenReplyMax );
+
+  // encode a fresh reply for a well formed query
+  std::size_t Answer( uint8_t* pReply, std::size_t lenReplyMax );
+
+  // into pReply when the parts fit it uncompressed, else through m_vScratch;
+  //   0 when the reply is over m_lenLimit
+  template<typename... Parts>
+  std::size_t Encode( uint8_t* pReply, std::size_t lenReplyMax, const dns::header_fields&, const Parts&... );
+
+  uint16_t Flags( uint8_t rcode ) const;
+  dns::opt_part Opt( uint8_t rcode ) const;
+
+  // header (and question when available) of the query echoed with an rcode
+  std::size_t Reject( uint8_t rcode, bool bQuestion, uint8_t* pReply, std::size_t lenReplyMax );
+
+};
+
+#endif /* RESPONDER_H */
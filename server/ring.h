@@ -0,0 +1,116 @@
+/*
+ * File:   ring.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 9:10 AM
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+// Bounded lock-free queue, after Dmitry Vyukov's array based mpmc queue:
+//   http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// Every cell carries a sequence number, so producers and consumers each claim a
+// slot with a single compare-and-swap and never touch each other's index.
+// With bSingleConsumer, the consumer side needs no compare-and-swap at all.
+// push() and pop() fail, rather than wait, when full or empty.
+
+template<typename T, bool bSingleConsumer>
+class bounded_ring {
+public:
+
+  explicit bounded_ring( std::size_t nCapacity ) // rounded up to a power of two
+    : m_mask( 0 ), m_head( 0 ), m_tail( 0 )
+  {
+    std::size_t n( 2 );
+    while ( n < nCapacity ) n <<= 1;
+    m_mask = n - 1;
+    m_cell.reset( new cell_t[ n ] );
+    for ( std::size_t ix = 0; ix < n; ix++ ) m_cell[ ix ].seq.store( ix, std::memory_order_relaxed );
+  }
+
+  bounded_ring( const bounded_ring& ) = delete;
+  bounded_ring& operator=( const bounded_ring& ) = delete;
+
+  bool push( T&& value ) {
+    cell_t* pCell;
+    std::size_t pos = m_tail.load( std::memory_order_relaxed );
+    while ( true ) {
+      pCell = &m_cell[ pos & m_mask ];
+      const std::size_t seq = pCell->seq.load( std::memory_order_acquire );
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos );
+      if ( 0 == diff ) {
+        if ( m_tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) break;
+      }
+      else {
+        if ( 0 > diff ) return false; // full
+        pos = m_tail.load( std::memory_order_relaxed );
+      }
+    }
+    pCell->value = std::move( value );
+    pCell->seq.store( pos + 1, std::memory_order_release );
+    return true;
+  }
+
+  bool pop( T& value ) {
+    cell_t* pCell;
+    std::size_t pos = m_head.load( std::memory_order_relaxed );
+    while ( true ) {
+      pCell = &m_cell[ pos & m_mask ];
+      const std::size_t seq = pCell->seq.load( std::memory_order_acquire );
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos + 1 );
+      if ( 0 == diff ) {
+        if ( bSingleConsumer ) {
+          m_head.store( pos + 1, std::memory_order_relaxed );
+          break;
+        }
+        if ( m_head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) break;
+      }
+      else {
+        if ( 0 > diff ) return false; // empty
+        pos = m_head.load( std::memory_order_relaxed );
+      }
+    }
+    value = std::move( pCell->value );
+    pCell->seq.store( pos + m_mask + 1, std::memory_order_release );
+    return true;
+  }
+
+  // approximate when other threads are active
+  std::size_t size() const {
+    const std::size_t tail = m_tail.load( std::memory_order_relaxed );
+    const std::size_t head = m_head.load( std::memory_order_relaxed );
+    return ( tail > head ) ? tail - head : 0;
+  }
+
+  std::size_t capacity() const { return m_mask + 1; }
+
+private:
+
+  enum { cache_line = 64 };
+
+  struct cell_t {
+    std::atomic<std::size_t> seq;
+    T value;
+  };
+
+  std::unique_ptr<cell_t[]> m_cell;
+  std::size_t m_mask;
+
+  // padded rather than aligned, so no over-aligned allocation is needed
+  char m_pad0[ cache_line ];
+  std::atomic<std::size_t> m_head; // consumers
+  char m_pad1[ cache_line - sizeof( std::atomic<std::size_t> ) ];
+  std::atomic<std::size_t> m_tail; // producers
+  char m_pad2[ cache_line - sizeof( std::atomic<std::size_t> ) ];
+};
+
+template<typename T> using mpsc_ring = bounded_ring<T, true>;
+template<typename T> using mpmc_ring = bounded_ring<T, false>;
+
+#endif /* RING_H */
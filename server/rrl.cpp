@@ -0,0 +1,131 @@
+/*
+ * File:   rrl.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 5:10 PM
+ */
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include <netinet/in.h>
+
+#include "dns.h"
+#include "name_kernels.h"
+#include "rrl.h"
+
+namespace {
+  enum : uint64_t { answer = 0, nxdomain = 1, error = 2 }; // what a bucket counts
+}
+
+rrl::rrl( const options_t& options )
+: m_options( options )
+{
+  std::size_t nBuckets( 1 );
+  while ( nBuckets * ways < options.nEntries ) nBuckets <<= 1;
+  m_vBucket.resize( nBuckets );
+  std::memset( m_vBucket.data(), 0, nBuckets * sizeof( bucket_t ) );
+  m_mask = nBuckets - 1;
+}
+
+uint32_t rrl::Now() {
+  return 1 + std::chrono::duration_cast<std::chrono::seconds>( // never 0
+    std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+uint64_t rrl::Key( const sockaddr* pAddr, const uint8_t* pReply, std::size_t lenReply ) {
+
+  // the client's network
+  uint64_t prefix( 0 );
+  if ( AF_INET == pAddr->sa_family ) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>( &reinterpret_cast<const sockaddr_in*>( pAddr )->sin_addr );
+    prefix = ( uint64_t( p[ 0 ] ) << 16 ) | ( uint64_t( p[ 1 ] ) << 8 ) | p[ 2 ];  // /24
+  }
+  else if ( AF_INET6 == pAddr->sa_family ) {
+    const uint8_t* p = reinterpret_cast<const sockaddr_in6*>( pAddr )->sin6_addr.s6_addr;
+    prefix = uint64_t( 1 ) << 63;  // apart from any IPv4 prefix
+    for ( unsigned ix = 0; ix < 7; ix++ ) prefix |= uint64_t( p[ ix ] ) << ( 8 * ( 6 - ix ) ); // /56
+  }
+
+  // what was answered
+  const uint8_t rcode = pReply[ 3 ] & 0x0f;
+  uint64_t hash( dns::hash_seed );
+  uint64_t kind( error );
+  if ( dns::rcode::NXDOMAIN == rcode ) kind = nxdomain;
+  else if ( ( dns::rcode::NOERROR == rcode ) && ( 1 == dns::get16( pReply + 4 ) ) ) {
+    uint8_t name[ dns::max_name_length ];
+    const std::size_t lenName
+      = dns::canonical( pReply + dns::header_length, lenReply - dns::header_length, name, hash );
+    if ( ( 0 != lenName ) && ( dns::header_length + lenName + 2 <= lenReply ) ) {
+      kind = answer | ( uint64_t( dns::get16( pReply + dns::header_length + lenName ) ) << 8 );
+    }
+    else hash = dns::hash_seed;
+  }
+
+  return dns::mix( dns::mix( hash, kind ), prefix );
+}
+
+rrl::entry_t& rrl::Find( uint64_t key, uint32_t tNow ) {
+
+  bucket_t& bucket( m_vBucket[ key & m_mask ] );
+  const uint32_t tag = std::max<uint32_t>( 1, key >> 32 );
+
+  entry_t* pVictim( &bucket.entry[ 0 ] );
+  for ( entry_t& entry: bucket.entry ) {
+    if ( tag == entry.tag ) return entry;
+    if ( entry.tLast < pVictim->tLast ) pVictim = &entry;  // unused ones have 0
+  }
+
+  // the least recently used, which may still be limited:  under a flood of
+  //   more keys than entries, the oldest give way
+  pVictim->tag = tag;
+  pVictim->tLast = tNow;
+  pVictim->balance = m_options.nPerSecond;
+  pVictim->nLimited = 0;
+  return *pVictim;
+}
+
+rrl::action_t rrl::Check( const sockaddr* pAddr, uint8_t* pReply, std::size_t& lenReply, uint32_t tNow ) {
+
+  if ( !enabled() || ( dns::header_length > lenReply ) ) return pass;
+
+  entry_t& entry( Find( Key( pAddr, pReply, lenReply ), tNow ) );
+
+  const int32_t rate = m_options.nPerSecond;
+  const int32_t window = m_options.nWindow;
+  const uint32_t elapsed = tNow - entry.tLast;
+  if ( elapsed > m_options.nWindow ) entry.balance = rate;  // idle long enough, a fresh start
+  else if ( 0 != elapsed ) entry.balance = std::min( rate, entry.balance + rate * int32_t( elapsed ) );
+  entry.tLast = tNow;
+
+  entry.balance = std::max( -rate * window, entry.balance - 1 );
+  if ( 0 <= entry.balance ) return pass;
+
+  entry.nLimited++;
+  if ( ( 0 != m_options.nSlip ) && ( 0 == ( entry.nLimited % m_options.nSlip ) ) ) {
+    lenReply = Truncate( pReply, lenReply );
+    return slip;
+  }
+  return drop;
+}
+
+// header and question only, TC set:  the client comes back over tcp
+std::size_t rrl::Truncate( uint8_t* pReply, std::size_t lenReply ) {
+
+  std::size_t len( dns::header_length );
+  if ( 1 == dns::get16( pReply + 4 ) ) {
+    const uint8_t* p = pReply + dns::header_length;
+    const uint8_t* pEnd = pReply + lenReply;
+    while ( ( p < pEnd ) && ( 0 != *p ) && ( 0 == ( *p & 0xc0 ) ) ) p += 1 + *p;
+    if ( ( p + 5 <= pEnd ) && ( 0 == *p ) ) len = p + 5 - pReply; // root label, qtype, qclass
+  }
+
+  if ( dns::header_length == len ) dns::put16( pReply + 4, 0 );
+  dns::put16( pReply + 2, dns::get16( pReply + 2 ) | dns::flag::TC );
+  dns::put16( pReply + 6, 0 );
+  dns::put16( pReply + 8, 0 );
+  dns::put16( pReply + 10, 0 );
+  return len;
+}
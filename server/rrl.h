@@ -0,0 +1,82 @@
+/*
+ * File:   rrl.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 5:10 PM
+ */
+
+#ifndef RRL_H
+#define RRL_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/socket.h>
+
+// Response rate limiting for udp, after BIND's RRL:  a token bucket per
+// (client prefix, response name, response type), so a reflection flood
+// aimed at one victim with one question is cut down without touching other
+// clients, or other questions from the same network.
+//
+// Prefixes are /24 for IPv4 and /56 for IPv6.  NXDOMAIN answers are counted
+// together whatever the name, as are errors, so random names don't each get
+// a fresh bucket.  Over the limit, every slip-th response goes out truncated
+// (header and question, TC set) so a real client retries over tcp, the rest
+// are dropped;  slip 0 drops them all.
+//
+// The table is fixed size, one per worker thread like the answer cache, so
+// no locking:  buckets of four entries on a cache line, an entry found by a
+// 32 bit tag of its key hash;  a new key takes an entry idle for longer than
+// the window, or else the least recently used of the four.
+
+class rrl {
+public:
+
+  struct options_t {
+    unsigned nPerSecond;  // responses per second per bucket, 0 for no limiting
+    unsigned nSlip;       // every nth limited response truncated, 0 to drop all
+    unsigned nWindow;     // seconds of credit and debt, and idle before reuse
+    unsigned nEntries;    // rounded up to a power of two, at least four
+    options_t(): nPerSecond( 0 ), nSlip( 2 ), nWindow( 15 ), nEntries( 64 * 1024 ) {}
+  };
+
+  enum action_t { pass, slip, drop };
+
+  explicit rrl( const options_t& = options_t() );
+
+  bool enabled() const { return 0 != m_options.nPerSecond; }
+
+  // for a finished response of lenReply octets to the client at pAddr:
+  //   pass leaves it alone, slip has rewritten it in place to lenReply octets,
+  //   drop means send nothing
+  action_t Check( const sockaddr* pAddr, uint8_t* pReply, std::size_t& lenReply, uint32_t tNow );
+
+  static uint32_t Now(); // seconds, steady
+
+private:
+
+  struct entry_t {
+    uint32_t tag;     // 0 for unused
+    uint32_t tLast;   // Now() of the last response counted
+    int32_t balance;  // tokens, negative while limited
+    uint32_t nLimited;
+  };
+
+  enum { ways = 4 };
+
+  struct alignas( 64 ) bucket_t {
+    entry_t entry[ ways ];
+  };
+
+  const options_t m_options;
+  std::vector<bucket_t> m_vBucket;
+  std::size_t m_mask;
+
+  static uint64_t Key( const sockaddr* pAddr, const uint8_t* pReply, std::size_t lenReply );
+  entry_t& Find( uint64_t key, uint32_t tNow );
+  static std::size_t Truncate( uint8_t* pReply, std::size_t lenReply );
+};
+
+#endif /* RRL_H */
@@ -0,0 +1,487 @@
+/*
+ * File:   server_udp.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 4:30 PM
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+#include <boost/asio/placeholders.hpp>
+
+#include "logger.h"
+#include "allocations.h"
+#include "server_udp.h"
+
+namespace asio = boost::asio;
+namespace ip = boost::asio::ip;
+
+server_udp::batch_t::batch_t( unsigned nSize_, std::size_t lenTx )
+  : nSize( nSize_ ),
+    vRxHdr( nSize_ ), vTxHdr( nSize_ ),
+    vRxIov( nSize_ ), vTxIov( nSize_ ),
+    vAddr( nSize_ ),
+    vRx( nSize_ * rx_length ), vTx( nSize_ * lenTx )
+{
+  for ( unsigned ix = 0; ix < nSize; ix++ ) {
+    vRxIov[ ix ].iov_base = &vRx[ ix * rx_length ];
+    vRxIov[ ix ].iov_len = rx_length;
+    vTxIov[ ix ].iov_base = &vTx[ ix * lenTx ];
+    vTxIov[ ix ].iov_len = 0;
+    std::memset( &vRxHdr[ ix ], 0, sizeof( mmsghdr ) );
+    std::memset( &vTxHdr[ ix ], 0, sizeof( mmsghdr ) );
+    std::memset( &vAddr[ ix ], 0, sizeof( sockaddr_storage ) );
+  }
+}
+
+server_udp::server_udp(
+  asio::io_context& io_context, short port, bool bReusePort, unsigned nBatch,
+  const zone_image* pZone, forwarder* pForwarder, const rrl::options_t& optionsRrl, metrics::worker_metrics& metrics_,
+  const answer_cache::options_t& optionsCache, uint16_t nUdpPayload, bool bUring )
+  : m_lenTx( std::max<std::size_t>( dns::max_udp_length, std::min<std::size_t>( dns::max_edns_udp_length, nUdpPayload ) ) ),
+    m_socket( io_context ),
+    m_responder( pZone, pForwarder, metrics_, metrics::udp, optionsCache, static_cast<uint16_t>( m_lenTx ) ),
+    m_rrl( optionsRrl ),
+    m_ixSlotFree( slot_none ), m_ixForwardFree( slot_none ),
+    m_descriptorRing( io_context ),
+    m_bRingArmed( false ), m_bFixedSend( true ), m_tNowRing( 0 ),
+    m_metrics( metrics_ )
+{
+  m_socket.open( ip::udp::v4() );
+  if ( bReusePort ) m_socket.set_option( reuse_port( true ) );
+  m_socket.bind( ip::udp::endpoint( ip::udp::v4(), port ) );
+  if ( nullptr != pForwarder ) Slots( m_rSlotForward, m_ixForwardFree, forward_slots );
+  std::string sError;
+  if ( bUring && OpenRing( sError ) ) {
+    start_ring_wait();
+  }
+  else {
+    if ( bUring ) {
+      LOG_WARN( "server udp io_uring unavailable, {}:  using asio", sError );
+      m_pRing.reset();
+    }
+    if ( 1 < nBatch ) {
+      m_pBatch.reset( new batch_t( nBatch, m_lenTx ) );
+      m_socket.non_blocking( true );
+      start_wait();
+    }
+    else {
+      Slots( m_rSlot, m_ixSlotFree, tx_slots );
+      start_receive();
+    }
+  }
+}
+
+server_udp::~server_udp() {
+  if ( m_descriptorRing.is_open() ) m_descriptorRing.release(); // m_pRing closes it
+}
+
+void server_udp::Slots( std::unique_ptr<slot_t[]>& rSlot, unsigned& ixFree, unsigned nSlots ) {
+  rSlot.reset( new slot_t[ nSlots ] );
+  ixFree = slot_none;
+  for ( unsigned ix = 0; ix < nSlots; ix++ ) {
+    rSlot[ ix ].vReply.resize( m_lenTx );
+    rSlot[ ix ].ixNext = ixFree;
+    ixFree = ix;
+  }
+}
+
+// ==== one datagram per completion
+
+void server_udp::send_complete( unsigned ixSlot, const boost::system::error_code& ec ) {
+  if ( ec && ( asio::error::operation_aborted != ec ) ) m_metrics.dropped.add();
+  m_rSlot[ ixSlot ].ixNext = m_ixSlotFree;
+  m_ixSlotFree = ixSlot;
+}
+
+void server_udp::handle_receive( const boost::system::error_code& ec, std::size_t bytes_transferred ) {
+  if ( !ec ) {
+
+    allocations::scope scope( m_metrics.udp_heap_allocations );
+
+    if ( slot_none == m_ixSlotFree ) m_metrics.dropped.add(); // every reply still going out, the socket is backed up
+    else {
+
+      // decoded in place, straight out of m_bufReceive, encoded in place into the slot
+      const unsigned ixSlot( m_ixSlotFree );
+      slot_t& slot( m_rSlot[ ixSlot ] );
+      m_responder.Client( m_endpointRemote.data() );
+      const std::size_t lenReply
+        = m_responder.Process( m_bufReceive.data(), bytes_transferred, slot.vReply.data(), slot.vReply.size() );
+
+      LOG_DEBUG( "server udp received {} bytes, replying with {}", bytes_transferred, lenReply );
+
+      std::size_t lenSend( lenReply );
+      if ( responder::forward == lenReply ) Forward( m_endpointRemote );
+      else if ( ( 0 != lenReply ) && Limit( m_endpointRemote.data(), slot.vReply.data(), lenSend, rrl::Now() ) ) {
+        m_ixSlotFree = slot.ixNext;
+        slot.endpoint = m_endpointRemote;
+        m_socket.async_send_to(
+          asio::buffer( slot.vReply.data(), lenSend ),
+          slot.endpoint,
+          make_custom_alloc_handler( slot.memory,
+            [this, ixSlot]( const boost::system::error_code& ec, std::size_t /* bytes_transferred */ ){
+              send_complete( ixSlot, ec );
+            } )
+        );
+      }
+    }
+
+    start_receive();  // start over again
+  }
+}
+
+// one datagram per answer, upstream replies trickle in one at a time;  through
+//   the reactor, so a full send buffer waits for room rather than dropping
+void server_udp::Forward( const endpoint_t& endpoint ) {
+  m_responder.Forward(
+    [this, endpoint]( const uint8_t* pReply, std::size_t lenReply ){
+      if ( slot_none == m_ixForwardFree ) { // every answer still going out, the socket is backed up
+        m_metrics.dropped.add();
+        return;
+      }
+      const unsigned ixSlot( m_ixForwardFree );
+      slot_t& slot( m_rSlotForward[ ixSlot ] );
+      std::memcpy( slot.vReply.data(), pReply, lenReply ); // the reply is read only, rate limiting may truncate it
+      if ( !Limit( endpoint.data(), slot.vReply.data(), lenReply, rrl::Now() ) ) return;
+      m_ixForwardFree = slot.ixNext;
+      slot.endpoint = endpoint;
+      m_socket.async_send_to(
+        asio::buffer( slot.vReply.data(), lenReply ),
+        slot.endpoint,
+        make_custom_alloc_handler( slot.memory,
+          [this, ixSlot]( const boost::system::error_code& ec, std::size_t /* bytes_transferred */ ){
+            forward_complete( ixSlot, ec );
+          } )
+      );
+    },
+    m_lenTx );
+}
+
+void server_udp::forward_complete( unsigned ixSlot, const boost::system::error_code& ec ) {
+  if ( ec && ( asio::error::operation_aborted != ec ) ) m_metrics.dropped.add();
+  m_rSlotForward[ ixSlot ].ixNext = m_ixForwardFree;
+  m_ixForwardFree = ixSlot;
+}
+
+bool server_udp::Limit( const sockaddr* pAddr, uint8_t* pReply, std::size_t& lenReply, uint32_t tNow ) {
+  if ( !m_rrl.enabled() ) return true;
+  switch ( m_rrl.Check( pAddr, pReply, lenReply, tNow ) ) {
+    case rrl::pass:
+      return true;
+    case rrl::slip:
+      m_metrics.rrl_slipped.add();
+      return true;
+    case rrl::drop:
+    default:
+      m_metrics.rrl_dropped.add();
+      return false;
+  }
+}
+
+void server_udp::start_receive() {
+  m_socket.async_receive_from(
+    asio::buffer( m_bufReceive ),
+    m_endpointRemote,
+    make_custom_alloc_handler( m_memoryReceive,
+      boost::bind(
+        &server_udp::handle_receive, this,
+        asio::placeholders::error,
+        asio::placeholders::bytes_transferred
+      ) )
+  );
+}
+
+// ==== batched with recvmmsg/sendmmsg
+
+void server_udp::start_wait() {
+  m_socket.async_wait(
+    socket_t::wait_read,
+    make_custom_alloc_handler( m_memoryReceive,
+      boost::bind(
+        &server_udp::handle_ready, this,
+        asio::placeholders::error
+      ) )
+  );
+}
+
+void server_udp::handle_ready( const boost::system::error_code& ec ) {
+
+  if ( ec ) {
+    if ( asio::error::operation_aborted != ec ) {
+      LOG_WARN( "server udp wait error: {}", ec.message() );
+      start_wait();
+    }
+    return;
+  }
+
+  allocations::scope scope( m_metrics.udp_heap_allocations );
+
+  batch_t& batch( *m_pBatch );
+  const int fd = m_socket.native_handle();
+
+  for ( unsigned nDrain = 0; nDrain < max_drain; nDrain++ ) {
+
+    for ( unsigned ix = 0; ix < batch.nSize; ix++ ) { // recvmmsg overwrites namelen
+      msghdr& hdr( batch.vRxHdr[ ix ].msg_hdr );
+      hdr.msg_name = &batch.vAddr[ ix ];
+      hdr.msg_namelen = sizeof( sockaddr_storage );
+      hdr.msg_iov = &batch.vRxIov[ ix ];
+      hdr.msg_iovlen = 1;
+    }
+
+    const int nReceived = recvmmsg( fd, batch.vRxHdr.data(), batch.nSize, MSG_DONTWAIT, nullptr );
+    if ( 0 >= nReceived ) {
+      if ( ( 0 > nReceived ) && ( EAGAIN != errno ) && ( EWOULDBLOCK != errno ) ) {
+        LOG_WARN( "server udp recvmmsg error: {}", std::strerror( errno ) );
+      }
+      break;
+    }
+
+    const uint32_t tNow = m_rrl.enabled() ? rrl::Now() : 0;
+    unsigned nReplies( 0 );
+    for ( int ix = 0; ix < nReceived; ix++ ) {
+      const mmsghdr& rx( batch.vRxHdr[ ix ] );
+      uint8_t* pReply = &batch.vTx[ nReplies * m_lenTx ];
+      m_responder.Client( static_cast<const sockaddr*>( rx.msg_hdr.msg_name ) );
+      std::size_t lenReply
+        = m_responder.Process( &batch.vRx[ ix * rx_length ], rx.msg_len, pReply, m_lenTx );
+      if ( responder::forward == lenReply ) {
+        endpoint_t endpoint;
+        std::memcpy( endpoint.data(), rx.msg_hdr.msg_name, rx.msg_hdr.msg_namelen );
+        endpoint.resize( rx.msg_hdr.msg_namelen );
+        Forward( endpoint );
+      }
+      else if ( ( 0 != lenReply ) && Limit( static_cast<const sockaddr*>( rx.msg_hdr.msg_name ), pReply, lenReply, tNow ) ) {
+        batch.vTxIov[ nReplies ].iov_base = pReply;
+        batch.vTxIov[ nReplies ].iov_len = lenReply;
+        msghdr& tx( batch.vTxHdr[ nReplies ].msg_hdr );
+        tx.msg_name = rx.msg_hdr.msg_name;
+        tx.msg_namelen = rx.msg_hdr.msg_namelen;
+        tx.msg_iov = &batch.vTxIov[ nReplies ];
+        tx.msg_iovlen = 1;
+        nReplies++;
+      }
+    }
+
+    SendBatch( nReplies );
+
+    if ( static_cast<unsigned>( nReceived ) < batch.nSize ) break; // drained
+  }
+
+  start_wait();
+}
+
+// UDP, so when the socket buffer is full the remaining replies are dropped
+//   rather than parked:  the client will retry
+void server_udp::SendBatch( unsigned nReplies ) {
+  const int fd = m_socket.native_handle();
+  unsigned ixFirst( 0 );
+  while ( ixFirst < nReplies ) {
+    const int nSent = sendmmsg( fd, &m_pBatch->vTxHdr[ ixFirst ], nReplies - ixFirst, MSG_DONTWAIT );
+    if ( 0 > nSent ) {
+      if ( EINTR == errno ) continue;
+      if ( ( EAGAIN != errno ) && ( EWOULDBLOCK != errno ) ) {
+        // one bad destination fails the call, so skip past it
+        ixFirst++;
+        m_metrics.dropped.add();
+        continue;
+      }
+      m_metrics.dropped.add( nReplies - ixFirst );
+      break;
+    }
+    ixFirst += nSent;
+  }
+}
+
+// ==== io_uring
+
+bool server_udp::OpenRing( std::string& sError ) {
+
+  m_pRing.reset( new uring );
+  if ( !m_pRing->Open( uring_entries, sError ) ) return false;
+
+  // a slot for each receive buffer, so a full round of datagrams can be answered
+  Slots( m_rSlot, m_ixSlotFree, uring_buffers );
+  std::vector<iovec> vIov( uring_buffers );
+  for ( unsigned ix = 0; ix < uring_buffers; ix++ ) {
+    vIov[ ix ].iov_base = m_rSlot[ ix ].vReply.data();
+    vIov[ ix ].iov_len = m_rSlot[ ix ].vReply.size();
+  }
+  std::string sErrorFixed;
+  if ( !m_pRing->RegisterBuffers( vIov.data(), uring_buffers, sErrorFixed ) ) {
+    LOG_INFO( "server udp {}, without zero copy sends", sErrorFixed );
+    m_bFixedSend = false;
+  }
+
+  // each buffer:  io_uring_recvmsg_out, the source address, then the datagram
+  std::memset( &m_hdrRing, 0, sizeof( m_hdrRing ) );
+  m_hdrRing.msg_namelen = sizeof( sockaddr_in6 );
+  const std::size_t lenBuffer = sizeof( io_uring_recvmsg_out ) + m_hdrRing.msg_namelen + rx_length;
+  if ( !m_pRing->ProvideBuffers( 0, uring_buffers, lenBuffer, sError ) ) return false;
+
+  ArmRing();
+  if ( 0 > m_pRing->Submit() ) {
+    sError = std::string( "io_uring_enter: " ) + std::strerror( errno );
+    return false;
+  }
+
+  m_descriptorRing.assign( m_pRing->fd() );
+  return true;
+}
+
+// multishot (kernel 6.0+):  one submission, a completion per datagram until
+//   the provided buffers run out
+void server_udp::ArmRing() {
+  io_uring_sqe* pSqe = m_pRing->Sqe();
+  if ( nullptr == pSqe ) return; // tried again after the next Submit
+  pSqe->opcode = IORING_OP_RECVMSG;
+  pSqe->fd = m_socket.native_handle();
+  pSqe->addr = reinterpret_cast<uint64_t>( &m_hdrRing );
+  pSqe->len = 1;
+  pSqe->ioprio = IORING_RECV_MULTISHOT;
+  pSqe->flags = IOSQE_BUFFER_SELECT;
+  pSqe->buf_group = 0;
+  pSqe->user_data = op_receive << 32;
+  m_bRingArmed = true;
+}
+
+void server_udp::start_ring_wait() {
+  m_descriptorRing.async_wait(
+    asio::posix::stream_descriptor::wait_read,
+    make_custom_alloc_handler( m_memoryReceive,
+      boost::bind(
+        &server_udp::handle_ring, this,
+        asio::placeholders::error
+      ) )
+  );
+}
+
+// reap everything completed, hand the buffers back, then one io_uring_enter
+//   for the replies;  that may run more completions, so go around again
+void server_udp::handle_ring( const boost::system::error_code& ec ) {
+
+  if ( ec ) {
+    if ( asio::error::operation_aborted != ec ) {
+      LOG_WARN( "server udp ring wait error: {}", ec.message() );
+      start_ring_wait();
+    }
+    return;
+  }
+
+  allocations::scope scope( m_metrics.udp_heap_allocations );
+
+  m_tNowRing = m_rrl.enabled() ? rrl::Now() : 0;
+  for ( unsigned nDrain = 0; nDrain < max_drain; nDrain++ ) {
+    const unsigned nReaped = m_pRing->Complete( [this]( const io_uring_cqe& cqe ){ RingCompletion( cqe ); } );
+    m_pRing->PublishBuffers();
+    if ( !m_bRingArmed ) ArmRing();
+    m_pRing->Submit();
+    if ( 0 == nReaped ) break;
+  }
+
+  start_ring_wait();
+}
+
+void server_udp::RingCompletion( const io_uring_cqe& cqe ) {
+  switch ( cqe.user_data >> 32 ) {
+    case op_receive:
+      RingReceive( cqe );
+      break;
+    case op_send: {
+        // a zero copy send completes twice, the slot is free with the second (IORING_CQE_F_NOTIF)
+        const unsigned ixSlot = static_cast<unsigned>( cqe.user_data );
+        if ( 0 > cqe.res ) {
+          if ( ( -EINVAL == cqe.res ) && m_bFixedSend ) { // before 6.0, no IORING_OP_SEND_ZC
+            LOG_INFO( "server udp io_uring zero copy sends unavailable" );
+            m_bFixedSend = false;
+          }
+          m_metrics.dropped.add();
+        }
+        if ( 0 == ( cqe.flags & IORING_CQE_F_MORE ) ) {
+          m_rSlot[ ixSlot ].ixNext = m_ixSlotFree;
+          m_ixSlotFree = ixSlot;
+        }
+      }
+      break;
+  }
+}
+
+void server_udp::RingReceive( const io_uring_cqe& cqe ) {
+
+  if ( 0 == ( cqe.flags & IORING_CQE_F_MORE ) ) m_bRingArmed = false; // re-armed once the buffers are back
+
+  if ( 0 > cqe.res ) {
+    // ENOBUFS:  every buffer is in use, datagrams wait in the socket until re-armed
+    if ( ( -ENOBUFS != cqe.res ) && ( -ECANCELED != cqe.res ) ) {
+      LOG_WARN( "server udp io_uring receive error: {}", std::strerror( -cqe.res ) );
+    }
+    return;
+  }
+  if ( 0 == ( cqe.flags & IORING_CQE_F_BUFFER ) ) return;
+
+  const uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+  uint8_t* pBuffer = m_pRing->Buffer( bid );
+  const io_uring_recvmsg_out* pOut = reinterpret_cast<const io_uring_recvmsg_out*>( pBuffer );
+  const sockaddr* pAddr = reinterpret_cast<const sockaddr*>( pBuffer + sizeof( io_uring_recvmsg_out ) );
+  const uint8_t* pQuery = pBuffer + sizeof( io_uring_recvmsg_out ) + m_hdrRing.msg_namelen;
+
+  const bool bWhole( ( 0 == ( pOut->flags & MSG_TRUNC ) ) && ( m_hdrRing.msg_namelen >= pOut->namelen ) );
+  if ( !bWhole || ( slot_none == m_ixSlotFree ) ) m_metrics.dropped.add(); // over rx_length, or the socket is backed up
+  else {
+    // decoded in place in the provided buffer, encoded in place into the slot
+    const unsigned ixSlot( m_ixSlotFree );
+    slot_t& slot( m_rSlot[ ixSlot ] );
+    m_responder.Client( pAddr );
+    std::size_t lenReply
+      = m_responder.Process( pQuery, pOut->payloadlen, slot.vReply.data(), slot.vReply.size() );
+    if ( responder::forward == lenReply ) {
+      endpoint_t endpoint;
+      std::memcpy( endpoint.data(), pAddr, pOut->namelen );
+      endpoint.resize( pOut->namelen );
+      Forward( endpoint );
+    }
+    else if ( ( 0 != lenReply ) && Limit( pAddr, slot.vReply.data(), lenReply, m_tNowRing ) ) {
+      m_ixSlotFree = slot.ixNext;
+      std::memcpy( slot.endpoint.data(), pAddr, pOut->namelen );
+      slot.endpoint.resize( pOut->namelen );
+      RingSend( ixSlot, lenReply );
+    }
+  }
+
+  m_pRing->Provide( bid );
+}
+
+// prepared only, submitted with the rest of the round's
+void server_udp::RingSend( unsigned ixSlot, std::size_t lenReply ) {
+  io_uring_sqe* pSqe = m_pRing->Sqe();
+  if ( nullptr == pSqe ) {
+    m_pRing->Submit();
+    pSqe = m_pRing->Sqe();
+  }
+  if ( nullptr == pSqe ) {
+    m_metrics.dropped.add();
+    m_rSlot[ ixSlot ].ixNext = m_ixSlotFree;
+    m_ixSlotFree = ixSlot;
+    return;
+  }
+  slot_t& slot( m_rSlot[ ixSlot ] );
+  pSqe->opcode = IORING_OP_SEND;
+  pSqe->fd = m_socket.native_handle();
+  pSqe->addr = reinterpret_cast<uint64_t>( slot.vReply.data() );
+  pSqe->len = static_cast<uint32_t>( lenReply );
+  pSqe->addr2 = reinterpret_cast<uint64_t>( slot.endpoint.data() );  // destination, kernel 6.0+
+  pSqe->addr_len = static_cast<uint16_t>( slot.endpoint.size() );
+  if ( m_bFixedSend && ( zero_copy_length <= lenReply ) ) { // from the registered slot, no copy
+    pSqe->opcode = IORING_OP_SEND_ZC;
+    pSqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+    pSqe->buf_index = static_cast<uint16_t>( ixSlot );
+  }
+  pSqe->user_data = ( op_send << 32 ) | ixSlot;
+}
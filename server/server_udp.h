@@ -0,0 +1,167 @@
+/*
+ * File:   server_udp.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 17, 2026, 4:30 PM
+ */
+
+#ifndef SERVER_UDP_H
+#define SERVER_UDP_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include "common.h"
+#include "handler_memory.h"
+#include "rrl.h"
+#include "uring.h"
+#include "responder.h"
+
+// https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/overview/networking/protocols.html
+// https://www.boost.org/doc/libs/1_68_0/doc/html/boost_asio/tutorial/tutdaytime7.html
+
+// Data may be read from or written to an unconnected UDP socket using the
+//   receive_from(), async_receive_from(), send_to() or async_send_to() member functions.
+// For a connected UDP socket, use the
+//   receive(), async_receive(), send() or async_send() member functions.
+
+// SO_REUSEPORT:  several sockets bound to the same port, the kernel hashes
+//   flows across them, so each worker thread can own its own socket
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+
+// With nBatch > 1, readiness is awaited with async_wait and the socket is then
+// drained with recvmmsg, up to nBatch datagrams per call, replies going out in
+// one sendmmsg.  Headers, iovecs, addresses and buffers are allocated once.
+// nBatch <= 1 keeps the one datagram per async_receive_from path, replies
+// encoded in place into a fixed set of slots, each sent with async_send_to
+// and back on the free list when that completes.
+//
+// With bUring, io_uring instead (uring.h), falling back to the above when the
+// kernel won't have it:  one multishot recvmsg draws datagrams into provided
+// buffers, replies go out from the slots, and all the sends prepared on one
+// readiness event are submitted with one io_uring_enter.  The slots are
+// registered as fixed buffers, for zero copy sends of the larger replies.
+//
+// Either way, the completion handlers live in memory set aside for them
+// (handler_memory.h), so answering from the zone image or the cache makes no
+// heap allocation at all:  udp_heap_allocations counts any that happen.
+//
+// Replies are built in buffers of nUdpPayload octets, the EDNS0 size advertised;
+// the responder holds each one to what its client can take.
+
+class server_udp {
+public:
+  server_udp(
+    boost::asio::io_context& io_context, short port, bool bReusePort = false, unsigned nBatch = 1,
+    const zone_image* pZone = nullptr, forwarder* pForwarder = nullptr,
+    const rrl::options_t& = rrl::options_t(),
+    metrics::worker_metrics& metrics_ = metrics::Discard(),
+    const answer_cache::options_t& = answer_cache::options_t(),
+    uint16_t nUdpPayload = dns::edns_udp_length, bool bUring = false );
+  virtual ~server_udp();
+
+  void Zone( const zone_image* pZone ) { m_responder.Zone( pZone ); }
+protected:
+private:
+
+  enum {
+    rx_length = dns::max_edns_udp_length, // largest query accepted
+    max_drain = 4, // full batches per readiness event, then yield to other handlers
+    tx_slots = 64, // replies in flight on the one datagram path
+    forward_slots = 64, // upstream answers in flight, on every path
+    uring_buffers = 256, // provided receive buffers, and so reply slots
+    uring_entries = 512,
+    zero_copy_length = 2048 // smaller replies are cheaper copied than pinned and notified
+  };
+
+  typedef boost::asio::ip::udp::socket socket_t;
+  typedef boost::asio::ip::udp::endpoint endpoint_t;
+
+  const std::size_t m_lenTx;  // largest reply sent
+  socket_t m_socket;
+  std::array<std::uint8_t, rx_length> m_bufReceive;
+  endpoint_t m_endpointRemote; // are multiple endpoints required?
+
+  responder m_responder;
+  rrl m_rrl;
+
+  handler_memory m_memoryReceive; // async_receive_from, or async_wait when batched
+
+  // one datagram path
+
+  struct slot_t {
+    vByte_t vReply;
+    endpoint_t endpoint;
+    handler_memory memory;  // its async_send_to
+    unsigned ixNext;        // free list
+  };
+
+  enum : unsigned { slot_none = ~0u };
+  std::unique_ptr<slot_t[]> m_rSlot;
+  unsigned m_ixSlotFree;
+
+  // upstream answers, sent with async_send_to whichever path took the query
+  std::unique_ptr<slot_t[]> m_rSlotForward;
+  unsigned m_ixForwardFree;
+
+  void Slots( std::unique_ptr<slot_t[]>& rSlot, unsigned& ixFree, unsigned nSlots );
+
+  void send_complete( unsigned ixSlot, const boost::system::error_code& ec );
+  void forward_complete( unsigned ixSlot, const boost::system::error_code& ec );
+  void Forward( const endpoint_t& ); // the query just processed, answered when upstream replies
+  bool Limit( const sockaddr*, uint8_t* pReply, std::size_t& lenReply, uint32_t tNow ); // false to send nothing
+  void handle_receive( const boost::system::error_code& ec, std::size_t bytes_transferred );
+  void start_receive();
+
+  // batched path
+
+  struct batch_t {
+    const unsigned nSize;
+    std::vector<mmsghdr> vRxHdr;
+    std::vector<mmsghdr> vTxHdr;
+    std::vector<iovec> vRxIov;
+    std::vector<iovec> vTxIov;
+    std::vector<sockaddr_storage> vAddr;
+    vByte_t vRx;  // nSize * rx_length
+    vByte_t vTx;  // nSize * lenTx
+    batch_t( unsigned nSize_, std::size_t lenTx );
+  };
+
+  std::unique_ptr<batch_t> m_pBatch;
+
+  // io_uring path
+
+  enum : uint64_t { op_receive = 1, op_send = 2 }; // in user_data, above the slot
+
+  std::unique_ptr<uring> m_pRing;
+  boost::asio::posix::stream_descriptor m_descriptorRing; // m_pRing's fd, released, not closed
+  msghdr m_hdrRing;      // room for the source address ahead of each datagram
+  bool m_bRingArmed;     // the multishot receive is running
+  bool m_bFixedSend;     // slots registered, large replies go out with IORING_OP_SEND_ZC
+  uint32_t m_tNowRing;   // rate limiting clock, once per readiness event
+
+  bool OpenRing( std::string& sError );
+  void ArmRing();
+  void start_ring_wait();
+  void handle_ring( const boost::system::error_code& ec );
+  void RingCompletion( const io_uring_cqe& );
+  void RingReceive( const io_uring_cqe& );
+  void RingSend( unsigned ixSlot, std::size_t lenReply );
+
+  metrics::worker_metrics& m_metrics;
+
+  void start_wait();
+  void handle_ready( const boost::system::error_code& ec );
+  void SendBatch( unsigned nReplies );
+
+};
+
+#endif /* SERVER_UDP_H */
@@ -6,7 +6,7 @@
  * Created on October 22, 2018, 8:50 PM
  */
 
-#include <iostream>
+#include <utility>
 #include <iomanip>
 #include <cstring>
 
@@ -14,109 +14,110 @@
 
 #include "common.h"
 //#include "hexdump.h"
+#include "logger.h"
 #include "session.h"
 
-void session::start() {
-  std::cout << "start begin: " << std::endl;
-  try {
-    do_read();
+void session::start( boost::asio::ip::tcp::socket&& socket ) {
+  LOG_DEBUG( "session start" );
+  m_socket = std::move( socket );
+  if ( query_log::Enabled() ) {
+    boost::system::error_code ec;
+    m_endpointRemote = m_socket.remote_endpoint( ec );
   }
-  catch(...) {
-    std::cout << "do_read issues" << std::endl;
+  m_bReading = true;
+  m_nRunning = 2;
+  m_nTxHighWater.store( 0, std::memory_order_relaxed );
+  boost::asio::co_spawn( m_socket.get_executor(), do_read(), boost::asio::detached );
+  boost::asio::co_spawn( m_socket.get_executor(), do_write(), boost::asio::detached );
+}
+
+boost::asio::awaitable<void> session::do_read() {
+  boost::system::error_code ec;
+  for ( ;; ) {
+    if ( m_vRx.size() < max_length ) m_vRx.resize( max_length );
+    const std::size_t lenRead = co_await m_socket.async_read_some(
+      boost::asio::buffer( m_vRx.data() + m_ixRxEnd, m_vRx.size() - m_ixRxEnd ),
+      boost::asio::redirect_error( boost::asio::use_awaitable, ec ) );
+    if ( ec ) {
+      if ( ( boost::asio::error::eof != ec ) && ( boost::asio::error::operation_aborted != ec ) ) {
+        LOG_WARN( "session read error {}, {}", ec.value(), ec.message() );
+      }
+      break;
+    }
+    LOG_DEBUG( "session read length {}", lenRead );
+    m_ixRxEnd += lenRead;
+    Frame();
+
+    // do_write resumes reading once replies drain
+    while ( ( max_pending <= m_transmitting.load( std::memory_order_acquire ) ) && m_socket.is_open() ) {
+      m_timerRead.expires_at( boost::asio::steady_timer::time_point::max() );
+      co_await m_timerRead.async_wait( boost::asio::redirect_error( boost::asio::use_awaitable, ec ) );
+    }
   }
-  std::cout << "start end: " << std::endl;
+
+  // no further read, the session closes once pending replies are written
+  m_bReading = false;
+  m_timerWrite.cancel();
+  Finished();
 }
 
+// Segments may carry part of a message, or several messages.  Complete
+// messages are handed over in place; only a trailing partial message is
+// moved, once per read, to the front of the buffer.  Each message is answered
+// as soon as its reply is ready, independent of the others in flight.
+void session::Frame() {
 
-void session::do_read() {
-  //std::cout << "do_read begin: " << std::endl;
-  // going to need to perform serialization as bytes come in (multiple packets joined together)?
-  auto self(shared_from_this());
-  m_vRx.resize( max_length );
-  m_socket.async_read_some(boost::asio::buffer(m_vRx),
-      [this, self](boost::system::error_code ec, const std::size_t lenRead)
-      {
-        //std::cout << "async_read begin: " << std::endl;
-        if (!ec) {
-          std::cout << ">>> total read length: " << lenRead << std::endl;
-
-          // inbound data arrives
-          // if reassembly data available;
-          //    append to reassembly buffer, 
-          //    clear inbound buffer
-          //    move adjusted reassembly buffer to inbound buffer
-          // loop on input buffer:
-          //   if less then header size:
-          //     move remaining octets to reassembly buffer
-          //     exit loop for more
-          //   if less than header.length:
-          //     move remaining octets to reassembly buffer
-          //     exit loop for more
-          //   if >= header.length: 
-          //     process packet
-          //     move beginning to end
-          //     loop for more
-          
-          std::size_t length = lenRead;
-          
-          if ( 0 != m_vReassembly.size() ) {
-            m_vReassembly.insert( m_vReassembly.end(), m_vRx.begin(), m_vRx.begin() + lenRead );
-            m_vRx.clear();
-            m_vRx = std::move( m_vReassembly );
-            length = m_vRx.size();
-          }
-          
-          vByte_iter_t iterBegin = m_vRx.begin();
-          vByte_iter_t iterEnd = iterBegin + length;
-          
-//          ofp141::ofp_header* pOfpHeader;
-          bool bReassemble( false );
-          
-          bool bLooping( true );
-          
-          while ( bLooping ) {
-            
-            auto nOctetsRemaining = iterEnd - iterBegin;
-
-//            if ( nOctetsRemaining < sizeof( ofp141::ofp_header ) ) bReassemble = true;
-//            else {
-//              pOfpHeader = new( &(*iterBegin) ) ofp141::ofp_header;
-//              if ( nOctetsRemaining < pOfpHeader->length ) bReassemble = true;
-//            }
-
-            if ( bReassemble ) {
-              // wait for more octets
-              m_vReassembly = std::move( m_vRx );
-              bLooping = false;
-            }
-            else {
-              // normal packet processing
-              uint8_t* pBegin = &(*iterBegin);
-//              ProcessPacket( pBegin, pBegin + pOfpHeader->length );
-//              iterBegin += pOfpHeader->length;
-              bLooping = iterBegin != iterEnd;
-           }
-          }
-          
-          std::cout << "<<< end." << std::endl;
-
-        } // end if ( ec )
-        else {
-          if ( 2 == ec.value() ) {
-            assert( 0 );  // 'End of file', so need to re-open, or abort
-          }
-          else {
-            std::cout << "read error: " << ec.value() << "," << ec.message() << std::endl;
-          }
-            // do we do another read or let it close implicitly or close explicitly?
-        } // end else ( ec )
-        //std::cout << "async_read end: " << std::endl;
-        do_read();
-      }); // end lambda
-  //std::cout << "do_read end: " << std::endl;
+  while ( prefix_length <= ( m_ixRxEnd - m_ixRxBegin ) ) {
+    uint8_t* pPrefix = m_vRx.data() + m_ixRxBegin;
+    const std::size_t lenMessage = dns::get16( pPrefix );
+    if ( ( m_ixRxEnd - m_ixRxBegin ) < ( prefix_length + lenMessage ) ) break;
+    ProcessPacket( pPrefix + prefix_length, pPrefix + prefix_length + lenMessage );
+    m_ixRxBegin += prefix_length + lenMessage;
+  }
+  
+  if ( m_ixRxBegin == m_ixRxEnd ) {
+    m_ixRxBegin = m_ixRxEnd = 0;
+  }
+  else {
+    // partial message:  make sure the rest of it will fit
+    std::size_t lenNeeded( max_message );
+    if ( prefix_length <= ( m_ixRxEnd - m_ixRxBegin ) ) {
+      lenNeeded = prefix_length + dns::get16( m_vRx.data() + m_ixRxBegin );
+    }
+    if ( ( m_vRx.size() - m_ixRxBegin ) < lenNeeded ) {
+      const std::size_t nRemaining = m_ixRxEnd - m_ixRxBegin;
+      std::memmove( m_vRx.data(), m_vRx.data() + m_ixRxBegin, nRemaining );
+      m_ixRxBegin = 0;
+      m_ixRxEnd = nRemaining;
+      if ( m_vRx.size() < lenNeeded ) m_vRx.resize( lenNeeded );
+    }
+  }
 }
 
+// pBegin..pEnd is one dns message, without the tcp length prefix
 void session::ProcessPacket( uint8_t* pBegin, const uint8_t* pEnd ) {
+  m_responder.Client( m_endpointRemote.data() );  // shared with the thread's other sessions
+  const std::size_t lenReply = m_responder.Process( pBegin, pEnd - pBegin, m_vReply.data() + prefix_length, max_reply );
+  if ( responder::forward == lenReply ) {
+    m_nForwarding++;  // the session stays out of the pool until this comes back
+    m_responder.Forward(
+      [this]( const uint8_t* pReply, std::size_t lenReply ){ // later, from the upstream's completion
+        vByte_t v( GetAvailableBuffer() );
+        v.resize( prefix_length );
+        dns::put16( v.data(), static_cast<uint16_t>( lenReply ) );
+        v.insert( v.end(), pReply, pReply + lenReply );
+        QueueTxToWrite( std::move( v ) );
+        m_nForwarding--;
+        if ( ( 0 == m_nForwarding ) && !m_bReading ) m_timerWrite.cancel(); // do_write may be done
+      },
+      max_reply );
+  }
+  else if ( 0 != lenReply ) {
+    dns::put16( m_vReply.data(), static_cast<uint16_t>( lenReply ) );
+    vByte_t v( GetAvailableBuffer() );
+    v.assign( m_vReply.begin(), m_vReply.begin() + prefix_length + lenReply );
+    QueueTxToWrite( std::move( v ) );
+  }
 }
 
 
@@ -147,74 +148,122 @@ void session::ProcessPacket( uint8_t* pBegin, const uint8_t* pEnd ) {
 //      });
 //}
 
-void session::do_write() {
-  auto self(shared_from_this());
-  //std::cout << "do_write start: " << std::endl;
-  boost::asio::async_write(
-    m_socket, boost::asio::buffer( m_vTxInWrite ),
-      [this, self](boost::system::error_code ec, std::size_t len )
-      {
-        UnloadTxInWrite();
-//        std::cout << "do_write atomic: " << 
-        if ( 2 <= m_transmitting.fetch_sub( 1, std::memory_order_release ) ) {
-          //std::cout << "do_write with atomic at " << m_transmitting.load( std::memory_order_acquire ) << std::endl;
-          LoadTxInWrite();
-          do_write();
-        }
-        //std::cout << "do_write complete:" << ec << "," << len << std::endl;
-        //if (!ec) {
-        //  do_read();
-        //}
-      });
+// everything gathered by LoadTxInWrite goes out in one writev, until
+//   reading has stopped and every reply owed has been written
+boost::asio::awaitable<void> session::do_write() {
+  boost::system::error_code ec;
+  while ( m_bReading || ( 0 != m_nForwarding ) || ( 0 != m_transmitting.load( std::memory_order_acquire ) ) ) {
+    if ( 0 == m_transmitting.load( std::memory_order_acquire ) ) {
+      m_timerWrite.expires_at( boost::asio::steady_timer::time_point::max() );
+      co_await m_timerWrite.async_wait( boost::asio::redirect_error( boost::asio::use_awaitable, ec ) );
+      continue;
+    }
+    LoadTxInWrite();
+    co_await boost::asio::async_write(
+      m_socket, m_vTxGather, boost::asio::redirect_error( boost::asio::use_awaitable, ec ) );
+    const uint32_t nWritten = UnloadTxInWrite();
+    const uint32_t nTransmitting = m_transmitting.fetch_sub( nWritten, std::memory_order_acq_rel ) - nWritten;
+    if ( ec && m_socket.is_open() ) {
+      // the peer is gone:  closing ends do_read, later replies fail here and are discarded
+      LOG_WARN( "session write error {}, {}", ec.value(), ec.message() );
+      boost::system::error_code ecClose;
+      m_socket.close( ecClose );
+    }
+    if ( resume_pending >= nTransmitting ) m_timerRead.cancel();
+  }
+  Finished();
+}
+
+void session::Finished() {
+  if ( 0 != --m_nRunning ) return;
+  LOG_DEBUG( "session finished" );
+  boost::system::error_code ec;
+  m_socket.close( ec );
+  m_ixRxBegin = m_ixRxEnd = 0;
+  m_pool.release( this ); // last, it may free the session
 }
 
 void session::GetAvailableBuffer( vByte_t& v ) {
-  std::unique_lock<std::mutex> lock( m_mutex );
-  if ( m_qBuffersAvailable.empty() ) {
-    m_qBuffersAvailable.push( vByte_t() );
+  if ( !m_qBuffersAvailable.pop( v ) ) {
+    v = vByte_t();
   }
-  v = std::move( m_qBuffersAvailable.front() );
-  m_qBuffersAvailable.pop();
 }
 
 vByte_t session::GetAvailableBuffer() {
-  std::unique_lock<std::mutex> lock( m_mutex );
-  if ( m_qBuffersAvailable.empty() ) {
-    m_qBuffersAvailable.push( vByte_t() );
-  }
-  vByte_t v = std::move( m_qBuffersAvailable.front() );
-  m_qBuffersAvailable.pop();
+  vByte_t v;
+  m_qBuffersAvailable.pop( v );
   return v;
 }
 
+void session::ReleaseBuffer( vByte_t&& v ) {
+  v.clear();
+  m_qBuffersAvailable.push( std::move( v ) ); // when full, v simply frees its memory
+}
+
 void session::QueueTxToWrite( vByte_t v ) {
-  std::unique_lock<std::mutex> lock( m_mutex );
-  //std::cout << "QTTW: " << m_transmitting.load( std::memory_order_acquire ) << std::endl;
-  if ( 0 == m_transmitting.fetch_add( 1, std::memory_order_acquire ) ) {
-    //std::cout << "QTTW1: " << std::endl;
-    m_vTxInWrite = std::move( v );
-    do_write();
-  }
-  else {
-    //std::cout << "QTTW2: " << std::endl;
-    m_qTxBuffersToBeWritten.push( std::move( v ) );
-    //m_qTxBuffersToBeProcessed.push( std::move( v ) );
-    //m_qTxBuffersToBeWritten.back() = std::move( v );
+  if ( !m_qTxBuffersToBeWritten.push( std::move( v ) ) ) {
+    // reading pauses long before this, so only a flood of asynchronous
+    //   completions gets here:  drop rather than block the producer
+    m_metrics.tcp_replies_dropped.add();
+    return;
   }
+  //std::cout << "QTTW: " << m_transmitting.load( std::memory_order_acquire ) << std::endl;
+  const uint32_t nPrior = m_transmitting.fetch_add( 1, std::memory_order_acq_rel );
+  uint32_t nHigh = m_nTxHighWater.load( std::memory_order_relaxed );
+  while ( ( nPrior + 1 > nHigh ) 
+    && !m_nTxHighWater.compare_exchange_weak( nHigh, nPrior + 1, std::memory_order_relaxed ) ) {}
+  if ( 0 == nPrior ) m_timerWrite.cancel(); // do_write is waiting
 }
 
+// take whatever is queued right now, up to max_gather_buffers, stopping
+//   once max_gather_bytes has been reached (the ring can't be peeked)
 void session::LoadTxInWrite() {
-  std::unique_lock<std::mutex> lock( m_mutex );
   //std::cout << "LoadTxInWrite: " << std::endl;
   //assert( 0 < m_transmitting.load( std::memory_order_acquire ) );
-  m_vTxInWrite = std::move( m_qTxBuffersToBeWritten.front() );
-  m_qTxBuffersToBeWritten.pop();
+  std::size_t nBytes( 0 );
+  vByte_t v;
+  while ( max_gather_buffers > m_vTxInWrite.size() ) {
+    if ( !m_qTxBuffersToBeWritten.pop( v ) ) break;
+    nBytes += v.size();
+    m_vTxInWrite.emplace_back( std::move( v ) );
+    m_vTxGather.emplace_back( boost::asio::buffer( m_vTxInWrite.back() ) );
+    if ( max_gather_bytes <= nBytes ) break;
+  }
 }
 
-void session::UnloadTxInWrite() {
-  std::unique_lock<std::mutex> lock( m_mutex );
+uint32_t session::UnloadTxInWrite() {
   //std::cout << "UnloadTxInWrite: " << std::endl;
+  const uint32_t nWritten = m_vTxInWrite.size();
+  for ( vByte_t& v: m_vTxInWrite ) {
+    ReleaseBuffer( std::move( v ) );
+  }
   m_vTxInWrite.clear();
-  m_qBuffersAvailable.push( std::move( m_vTxInWrite ) );
+  m_vTxGather.clear();
+  return nWritten;
+}
+
+void session_pool::start( boost::asio::ip::tcp::socket&& socket ) {
+  std::unique_ptr<session> pSession;
+  if ( m_vIdle.empty() ) {
+    pSession = std::make_unique<session>( m_io_context, m_responder, m_metrics, *this );
+  }
+  else {
+    pSession = std::move( m_vIdle.back() );
+    m_vIdle.pop_back();
+  }
+  session* p = pSession.get();
+  p->m_ixPool = m_vActive.size();
+  m_vActive.emplace_back( std::move( pSession ) );
+  p->start( std::move( socket ) );
+}
 
+void session_pool::release( session* p ) {
+  const std::size_t ix = p->m_ixPool;
+  std::unique_ptr<session> pSession( std::move( m_vActive[ ix ] ) );
+  if ( ix != m_vActive.size() - 1 ) { // the last one takes its place
+    m_vActive[ ix ] = std::move( m_vActive.back() );
+    m_vActive[ ix ]->m_ixPool = ix;
+  }
+  m_vActive.pop_back();
+  if ( max_idle > m_vIdle.size() ) m_vIdle.emplace_back( std::move( pSession ) );
 }
@@ -1,4 +1,4 @@
-/* 
+/*
  * File:   session.h
  * Author: Raymond Burkholder
  *         raymond@burkholder.net
@@ -9,82 +9,165 @@
 #ifndef SESSION_H
 #define SESSION_H
 
-#include <queue>
-#include <mutex>
+#include <utility>  // boost 1.74 awaitable.hpp uses std::exchange without it
 #include <atomic>
+#include <memory>
+#include <vector>
 
 #include <boost/asio.hpp>
 
+#include "ring.h"
 #include "common.h"
+#include "logger.h"
+#include "responder.h"
 //#include "bridge.h"
 
-class session
-  : public std::enable_shared_from_this<session>
-{
+class session_pool;
+
+// One tcp connection, as two coroutines in the acceptor's thread:  Read frames
+// the queries and answers them, Write gathers the queued replies into one
+// writev at a time.  Each is straight-line code, waking the other with a timer
+// cancel.  The session goes back to its pool once both have finished, with its
+// buffers, so a new connection usually allocates nothing but its coroutines.
+
+class session {
 public:
-  session(boost::asio::ip::tcp::socket socket)
-    : m_socket(std::move(socket)), m_transmitting( 0 )
-  { 
-      std::cout << "session construct" << std::endl;
+  session( boost::asio::io_context& io_context, responder& responder_, metrics::worker_metrics& metrics_, session_pool& pool )
+    : m_socket( io_context ), m_responder( responder_ ), m_metrics( metrics_ ), m_pool( pool ),
+      m_timerWrite( io_context ), m_timerRead( io_context ),
+      m_ixRxBegin( 0 ), m_ixRxEnd( 0 ), m_vReply( prefix_length + max_reply ),
+      m_bReading( false ), m_nForwarding( 0 ), m_nRunning( 0 ),
+      m_transmitting( 0 ), m_nTxHighWater( 0 ),
+      m_qBuffersAvailable( free_list_size ),
+      m_qTxBuffersToBeWritten( tx_ring_size )
+  {
+      m_vTxInWrite.reserve( max_gather_buffers );
+      m_vTxGather.reserve( max_gather_buffers );
+      LOG_DEBUG( "session construct" );
   }
-    
+
     virtual ~session() {
-      std::cout << "session destruct" << std::endl;
+      LOG_DEBUG( "session destruct" );
     }
 
-  void start();
+  void start( boost::asio::ip::tcp::socket&& socket );
+
+  // metrics
+  uint32_t tx_queue_depth() const { return m_transmitting.load( std::memory_order_relaxed ); }
+  uint32_t tx_queue_high_water() const { return m_nTxHighWater.load( std::memory_order_relaxed ); }
 
 private:
 
+  friend class session_pool;
+
   enum { max_length = 17000 };  // not sure where I got 17k from.
 
-// need to use a function object instead so that the functions are embedded.
-// can be stack based function object or a heap based function object
-// supplied by the primary data structure being built
-// then can embed the related dependencies for building the various fields.  
-  struct build {
-    typedef std::function<size_t(void)> fSize_t;
-    typedef std::function<void(vByte_t&)> fAppend_t;
+  // RFC 7766:  each message is preceded by a two octet length
+  enum {
+    prefix_length = 2,
+    max_message = dns::max_message_length + prefix_length,
+    max_reply = dns::max_message_length,
+    max_pending = 64,   // replies queued before reading pauses
+    resume_pending = 16 // replies queued when reading resumes
   };
-  
-  std::vector<build> m_vBuild; // used for building up a packet from composite structures.
 
-  void do_read();
-  
-  //void do_write(std::size_t length);
+  // replies are encoded with the part templates in dns_build.h, via the responder
 
-  // TODO:  need a write queue, need to update the xid value in the header
-  //    so, create a method or class for handling queued messages and transactions
-  //void do_write( vChar_t& v );
-  void do_write();
+  boost::asio::awaitable<void> do_read();
+  boost::asio::awaitable<void> do_write();
+  void Frame();  // dispatch each complete message in m_vRx
+  void Finished(); // by each coroutine, the last one returns the session to the pool
 
   boost::asio::ip::tcp::socket m_socket;
-  
+  boost::asio::ip::tcp::endpoint m_endpointRemote; // for the query log
+  responder& m_responder;  // owned by the thread running this session
+  metrics::worker_metrics& m_metrics; // of that thread
+  session_pool& m_pool;
+  std::size_t m_ixPool;    // in the pool's m_vActive
+
+  // never expire, a cancel is the signal
+  boost::asio::steady_timer m_timerWrite; // do_write waiting on a reply
+  boost::asio::steady_timer m_timerRead;  // do_read paused on a full write queue
+
+  // m_vRx[ m_ixRxBegin, m_ixRxEnd ) holds octets not yet framed into a message
   vByte_t m_vRx;
-  vByte_t m_vReassembly;
-  typedef vByte_t::iterator vByte_iter_t;
-  
-  typedef std::queue<vByte_t> qBuffers_t; 
-  
-  std::mutex m_mutex;
+  std::size_t m_ixRxBegin;
+  std::size_t m_ixRxEnd;
+
+  // each reply is encoded here, then copied out at its length into a buffer
+  //   from m_qBuffersAvailable, which keeps its capacity from one reply to the next
+  vByte_t m_vReply;
+
+  bool m_bReading;          // do_read still running
+  unsigned m_nForwarding;   // queries waiting on the upstream
+  unsigned m_nRunning;      // coroutines
+
+  // Replies are queued from this thread only (a query just read, or an upstream
+  //   completion), and consumed by do_write:  an mpsc ring for outbound buffers,
+  //   an mpmc ring as the free list of recycled buffers.
+  //   m_transmitting counts buffers queued plus those in the write in progress.
+  enum {
+    tx_ring_size = 1024,  // well above max_pending
+    free_list_size = 256
+  };
+  typedef mpsc_ring<vByte_t> qBuffers_t;
+  typedef mpmc_ring<vByte_t> qAvailable_t;
+
   std::atomic<uint32_t> m_transmitting;
-  
-  qBuffers_t m_qBuffersAvailable;
+  std::atomic<uint32_t> m_nTxHighWater;  // deepest m_transmitting seen
+
+  qAvailable_t m_qBuffersAvailable;
   qBuffers_t m_qTxBuffersToBeWritten;
-  vByte_t m_vTxInWrite;
-  
+
+  // gathered from m_qTxBuffersToBeWritten for the write in progress
+  enum {
+    max_gather_buffers = 64,   // well under IOV_MAX
+    max_gather_bytes = 64 * 1024
+  };
+  typedef std::vector<vByte_t> vBuffers_t;
+  vBuffers_t m_vTxInWrite;
+  std::vector<boost::asio::const_buffer> m_vTxGather; // views of m_vTxInWrite
+
 //  Bridge m_bridge;
-  
+
   void ProcessPacket( uint8_t* pBegin, const uint8_t* pEnd );
-  
+
   void GetAvailableBuffer( vByte_t& v );
   vByte_t GetAvailableBuffer();
   void QueueTxToWrite( vByte_t  );
+  void ReleaseBuffer( vByte_t&& );
   void LoadTxInWrite();
-  void UnloadTxInWrite();
-  
+  uint32_t UnloadTxInWrite(); // returns the number of buffers written
+
 };
 
+// Sessions of one acceptor, in its thread.  A closed session is kept for the
+// next connection, up to max_idle of them, rather than freed.
+
+class session_pool {
+public:
+
+  session_pool( boost::asio::io_context& io_context, responder& responder_, metrics::worker_metrics& metrics_ )
+    : m_io_context( io_context ), m_responder( responder_ ), m_metrics( metrics_ ) {}
+
+  void start( boost::asio::ip::tcp::socket&& socket ); // on an idle session, else a new one
+  void release( session* ); // both its coroutines have finished
+
+  typedef std::vector<std::unique_ptr<session> > vSession_t;
+  const vSession_t& active() const { return m_vActive; }
+  std::size_t idle() const { return m_vIdle.size(); }
+
+private:
+
+  enum { max_idle = 64 };
+
+  boost::asio::io_context& m_io_context;
+  responder& m_responder;
+  metrics::worker_metrics& m_metrics;
+
+  vSession_t m_vActive;
+  vSession_t m_vIdle;
+};
 
-#endif /* TCP_SESSION_H */
+#endif /* SESSION_H */
 
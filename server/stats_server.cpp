@@ -0,0 +1,105 @@
+/*
+ * File:   stats_server.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 10:05 AM
+ */
+
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <boost/asio/write.hpp>
+
+#include "logger.h"
+#include "stats_server.h"
+
+namespace asio = boost::asio;
+namespace ip = boost::asio::ip;
+
+namespace {
+
+  // one scrape:  read whatever the request is, reply, close
+  struct connection: std::enable_shared_from_this<connection> {
+    ip::tcp::socket socket;
+    std::array<char, 1024> bufRequest;
+    std::string sResponse;
+    explicit connection( ip::tcp::socket&& socket_ ): socket( std::move( socket_ ) ) {}
+    void start() {
+      auto self( shared_from_this() );
+      socket.async_read_some( asio::buffer( bufRequest ), [this, self]( const boost::system::error_code& ec, std::size_t ){
+        if ( ec ) return;
+        asio::async_write( socket, asio::buffer( sResponse ), [this, self]( const boost::system::error_code&, std::size_t ){
+          boost::system::error_code ecShutdown;
+          socket.shutdown( ip::tcp::socket::shutdown_both, ecShutdown );
+        } );
+      } );
+    }
+  };
+
+}
+
+stats_server::stats_server(
+  asio::io_context& io_context, unsigned short port, const std::string& sFile, unsigned secondsFile,
+  const metrics::vWorker_t& vWorker, fAppend_t&& fAppend )
+: m_vWorker( vWorker ), m_fAppend( std::move( fAppend ) ),
+  m_sFile( sFile ), m_secondsFile( std::max( 1u, secondsFile ) ), m_timer( io_context )
+{
+  if ( 0 != port ) {
+    m_pAcceptor.reset( new ip::tcp::acceptor( io_context, ip::tcp::endpoint( ip::address_v4::loopback(), port ) ) );
+    StartAccept();
+  }
+  if ( !m_sFile.empty() ) StartTimer();
+}
+
+std::string stats_server::Render() const {
+  std::string sOut;
+  sOut.reserve( 16 * 1024 );
+  metrics::Render( m_vWorker, sOut );
+  if ( m_fAppend ) m_fAppend( sOut );
+  return sOut;
+}
+
+void stats_server::StartAccept() {
+  m_pAcceptor->async_accept( [this]( const boost::system::error_code& ec, ip::tcp::socket socket ){
+    if ( asio::error::operation_aborted == ec ) return;
+    if ( !ec ) {
+      auto pConnection = std::make_shared<connection>( std::move( socket ) );
+      const std::string sBody( Render() );
+      pConnection->sResponse
+        = "HTTP/1.0 200 OK\r\n"
+          "Content-Type: text/plain; version=0.0.4\r\n"
+          "Content-Length: " + std::to_string( sBody.size() ) + "\r\n"
+          "Connection: close\r\n\r\n" + sBody;
+      pConnection->start();
+    }
+    StartAccept();
+  } );
+}
+
+void stats_server::StartTimer() {
+  m_timer.expires_after( std::chrono::seconds( m_secondsFile ) );
+  m_timer.async_wait( [this]( const boost::system::error_code& ec ){
+    if ( ec ) return;
+    WriteFile();
+    StartTimer();
+  } );
+}
+
+void stats_server::WriteFile() const {
+  const std::string sTemp( m_sFile + ".tmp" );
+  {
+    std::ofstream file( sTemp, std::ios::trunc );
+    file << Render();
+    if ( !file ) {
+      LOG_WARN( "stats:  can not write {}", sTemp );
+      return;
+    }
+  }
+  if ( 0 != std::rename( sTemp.c_str(), m_sFile.c_str() ) ) {
+    LOG_WARN( "stats:  can not rename {} to {}", sTemp, m_sFile );
+  }
+}
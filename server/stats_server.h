@@ -0,0 +1,55 @@
+/*
+ * File:   stats_server.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 20, 2026, 10:05 AM
+ */
+
+#ifndef STATS_SERVER_H
+#define STATS_SERVER_H
+
+#include <string>
+#include <memory>
+#include <functional>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "metrics.h"
+
+// The metrics, merged, in the Prometheus text format:  served over http on
+// 127.0.0.1:port (any request, one reply, then close), and/or rewritten to a
+// file every few seconds (via a temporary and a rename, so readers never see
+// it half written).  Runs in one io_context;  fAppend adds whatever only that
+// thread may look at.
+
+class stats_server {
+public:
+
+  typedef std::function<void( std::string& )> fAppend_t;
+
+  stats_server(
+    boost::asio::io_context&, unsigned short port, const std::string& sFile, unsigned secondsFile,
+    const metrics::vWorker_t&, fAppend_t&& fAppend );
+
+  std::string Render() const;
+
+private:
+
+  const metrics::vWorker_t m_vWorker;
+  fAppend_t m_fAppend;
+
+  std::unique_ptr<boost::asio::ip::tcp::acceptor> m_pAcceptor;
+
+  const std::string m_sFile;
+  const unsigned m_secondsFile;
+  boost::asio::steady_timer m_timer;
+
+  void StartAccept();
+  void StartTimer();
+  void WriteFile() const;
+};
+
+#endif /* STATS_SERVER_H */
@@ -0,0 +1,181 @@
+/*
+ * File:   uring.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 23, 2026, 9:20 AM
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+
+namespace {
+
+int io_uring_setup( unsigned entries, io_uring_params* p ) {
+  return static_cast<int>( syscall( __NR_io_uring_setup, entries, p ) );
+}
+
+int io_uring_enter( int fd, unsigned to_submit, unsigned min_complete, unsigned flags ) {
+  return static_cast<int>( syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0 ) );
+}
+
+int io_uring_register( int fd, unsigned opcode, const void* arg, unsigned nr_args ) {
+  return static_cast<int>( syscall( __NR_io_uring_register, fd, opcode, arg, nr_args ) );
+}
+
+template<typename T>
+T* At( void* pBase, uint32_t offset ) {
+  return reinterpret_cast<T*>( static_cast<uint8_t*>( pBase ) + offset );
+}
+
+} // namespace anonymous
+
+uring::uring()
+  : m_fd( -1 ),
+    m_pRingMap( MAP_FAILED ), m_lenRingMap( 0 ), m_pSqe( nullptr ), m_lenSqe( 0 ),
+    m_sq{}, m_cq{},
+    m_pBufRing( nullptr ), m_lenBufRing( 0 ), m_pBuffers( nullptr ), m_lenBuffer( 0 ),
+    m_maskBuf( 0 ), m_nBufTail( 0 ), m_bgid( 0 ), m_bBufRing( false ), m_bBuffers( false )
+{}
+
+uring::~uring() {
+  if ( 0 <= m_fd ) {
+    if ( m_bBufRing ) {
+      io_uring_buf_reg reg;
+      std::memset( &reg, 0, sizeof( reg ) );
+      reg.bgid = m_bgid;
+      io_uring_register( m_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1 );
+    }
+    if ( m_bBuffers ) io_uring_register( m_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0 );
+    close( m_fd );  // cancels whatever is still outstanding
+  }
+  if ( nullptr != m_pSqe ) munmap( m_pSqe, m_lenSqe );
+  if ( MAP_FAILED != m_pRingMap ) munmap( m_pRingMap, m_lenRingMap );
+  if ( nullptr != m_pBufRing ) munmap( m_pBufRing, m_lenBufRing );
+  delete[] m_pBuffers;
+}
+
+bool uring::Open( unsigned nEntries, std::string& sError ) {
+
+  // one thread submits and reaps:  no interrupts for completions it will get to anyway;
+  //   not IORING_SETUP_SINGLE_ISSUER, that thread need not be the one constructing
+  io_uring_params params;
+  std::memset( &params, 0, sizeof( params ) );
+  params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+  params.cq_entries = 4 * nEntries;  // multishot receives post without a submission each
+  m_fd = io_uring_setup( nEntries, &params );
+  if ( ( 0 > m_fd ) && ( EINVAL == errno ) ) { // before 5.19
+    std::memset( &params, 0, sizeof( params ) );
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = 4 * nEntries;
+    m_fd = io_uring_setup( nEntries, &params );
+  }
+  if ( 0 > m_fd ) {
+    sError = std::string( "io_uring_setup: " ) + std::strerror( errno );
+    return false;
+  }
+  if ( 0 == ( params.features & IORING_FEAT_SINGLE_MMAP ) ) {
+    sError = "io_uring without IORING_FEAT_SINGLE_MMAP";
+    return false;
+  }
+
+  m_lenRingMap = std::max<std::size_t>(
+    params.sq_off.array + params.sq_entries * sizeof( uint32_t ),
+    params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe ) );
+  m_pRingMap = mmap( nullptr, m_lenRingMap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+  if ( MAP_FAILED == m_pRingMap ) {
+    sError = std::string( "io_uring ring mmap: " ) + std::strerror( errno );
+    return false;
+  }
+
+  m_lenSqe = params.sq_entries * sizeof( io_uring_sqe );
+  void* pSqe = mmap( nullptr, m_lenSqe, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES );
+  if ( MAP_FAILED == pSqe ) {
+    sError = std::string( "io_uring sqe mmap: " ) + std::strerror( errno );
+    return false;
+  }
+  m_pSqe = static_cast<io_uring_sqe*>( pSqe );
+
+  m_sq.pHead = At<std::atomic<uint32_t> >( m_pRingMap, params.sq_off.head );
+  m_sq.pTail = At<std::atomic<uint32_t> >( m_pRingMap, params.sq_off.tail );
+  m_sq.pArray = At<uint32_t>( m_pRingMap, params.sq_off.array );
+  m_sq.mask = *At<uint32_t>( m_pRingMap, params.sq_off.ring_mask );
+  m_sq.entries = *At<uint32_t>( m_pRingMap, params.sq_off.ring_entries );
+  m_sq.tail = m_sq.submitted = m_sq.pTail->load( std::memory_order_relaxed );
+  for ( uint32_t ix = 0; ix < m_sq.entries; ix++ ) m_sq.pArray[ ix ] = ix; // sqe n in slot n, always
+
+  m_cq.pHead = At<std::atomic<uint32_t> >( m_pRingMap, params.cq_off.head );
+  m_cq.pTail = At<std::atomic<uint32_t> >( m_pRingMap, params.cq_off.tail );
+  m_cq.pCqe = At<io_uring_cqe>( m_pRingMap, params.cq_off.cqes );
+  m_cq.mask = *At<uint32_t>( m_pRingMap, params.cq_off.ring_mask );
+
+  return true;
+}
+
+io_uring_sqe* uring::Sqe() {
+  if ( m_sq.entries == ( m_sq.tail - m_sq.pHead->load( std::memory_order_acquire ) ) ) return nullptr;
+  io_uring_sqe* pSqe = &m_pSqe[ m_sq.tail & m_sq.mask ];
+  std::memset( pSqe, 0, sizeof( io_uring_sqe ) );
+  m_sq.tail++;
+  return pSqe;
+}
+
+int uring::Submit() {
+  const unsigned nPending( m_sq.tail - m_sq.submitted );
+  if ( 0 == nPending ) return 0;
+  m_sq.pTail->store( m_sq.tail, std::memory_order_release );
+  int nSubmitted;
+  do {
+    nSubmitted = io_uring_enter( m_fd, nPending, 0, 0 );
+  } while ( ( 0 > nSubmitted ) && ( EINTR == errno ) );
+  if ( 0 < nSubmitted ) m_sq.submitted += nSubmitted;
+  return nSubmitted;
+}
+
+bool uring::RegisterBuffers( const iovec* pIov, unsigned nIov, std::string& sError ) {
+  if ( 0 > io_uring_register( m_fd, IORING_REGISTER_BUFFERS, pIov, nIov ) ) {
+    sError = std::string( "io_uring register buffers: " ) + std::strerror( errno );
+    return false;
+  }
+  m_bBuffers = true;
+  return true;
+}
+
+bool uring::ProvideBuffers( uint16_t bgid, unsigned nBuffers, std::size_t lenBuffer, std::string& sError ) {
+
+  m_lenBufRing = nBuffers * sizeof( io_uring_buf ); // page aligned by mmap, as the kernel wants
+  void* pRing = mmap( nullptr, m_lenBufRing, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0 );
+  if ( MAP_FAILED == pRing ) {
+    sError = std::string( "io_uring buffer ring mmap: " ) + std::strerror( errno );
+    return false;
+  }
+  m_pBufRing = static_cast<io_uring_buf_ring*>( pRing );
+  m_pBufRing->tail = 0;
+
+  io_uring_buf_reg reg;
+  std::memset( &reg, 0, sizeof( reg ) );
+  reg.ring_addr = reinterpret_cast<uint64_t>( m_pBufRing );
+  reg.ring_entries = nBuffers;
+  reg.bgid = bgid;
+  if ( 0 > io_uring_register( m_fd, IORING_REGISTER_PBUF_RING, &reg, 1 ) ) {
+    sError = std::string( "io_uring register buffer ring: " ) + std::strerror( errno );
+    return false;
+  }
+  m_bBufRing = true;
+  m_bgid = bgid;
+
+  m_lenBuffer = lenBuffer;
+  m_maskBuf = nBuffers - 1;
+  m_pBuffers = new uint8_t[ nBuffers * lenBuffer ];
+  for ( unsigned ix = 0; ix < nBuffers; ix++ ) Provide( static_cast<uint16_t>( ix ) );
+  PublishBuffers();
+
+  return true;
+}
@@ -0,0 +1,125 @@
+/*
+ * File:   uring.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 23, 2026, 9:20 AM
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+// Just enough io_uring for the udp path, straight on the system calls (no
+// liburing in the build).  One thread owns an instance:  it prepares entries
+// with Sqe, hands them all to the kernel with one Submit, and reaps with
+// Complete.  The ring's descriptor polls readable with completions waiting,
+// so it can sit in an io_context like any other descriptor.
+//
+// A provided buffer ring (kernel 5.19+) feeds multishot receives:  the kernel
+// picks a buffer per datagram, and names it in the completion's flags;  the
+// buffer goes back with Provide once its datagram has been answered.
+
+class uring {
+public:
+
+  uring();
+  ~uring();
+
+  uring( const uring& ) = delete;
+  uring& operator=( const uring& ) = delete;
+
+  // ring setup and mapping;  false with sError filled in on failure
+  bool Open( unsigned nEntries, std::string& sError );
+
+  int fd() const { return m_fd; }
+
+  // the next submission entry, zeroed;  nullptr with the ring full (Submit first)
+  io_uring_sqe* Sqe();
+
+  // everything prepared since the last call, in one io_uring_enter;  the number accepted
+  int Submit();
+
+  // f( const io_uring_cqe& ) for each completion ready;  the number reaped
+  template<typename F>
+  unsigned Complete( F&& f ) {
+    uint32_t head = m_cq.pHead->load( std::memory_order_relaxed );
+    const uint32_t tail = m_cq.pTail->load( std::memory_order_acquire );
+    const unsigned nReaped( tail - head );
+    while ( head != tail ) {
+      f( m_cq.pCqe[ head & m_cq.mask ] );
+      head++;
+    }
+    m_cq.pHead->store( head, std::memory_order_release );
+    return nReaped;
+  }
+
+  // fixed buffers, by index, for IORING_RECVSEND_FIXED_BUF
+  bool RegisterBuffers( const iovec* pIov, unsigned nIov, std::string& sError );
+
+  // nBuffers (a power of two) of lenBuffer each, as buffer group bgid
+  bool ProvideBuffers( uint16_t bgid, unsigned nBuffers, std::size_t lenBuffer, std::string& sError );
+
+  uint8_t* Buffer( uint16_t bid ) { return m_pBuffers + std::size_t( bid ) * m_lenBuffer; }
+
+  // bid back to the kernel, visible with the next PublishBuffers
+  void Provide( uint16_t bid ) {
+    // not m_pBufRing->bufs:  in C++ the header's flexible array lands past an empty struct
+    io_uring_buf& buf( reinterpret_cast<io_uring_buf*>( m_pBufRing )[ m_nBufTail & m_maskBuf ] );
+    buf.addr = reinterpret_cast<uint64_t>( Buffer( bid ) );
+    buf.len = static_cast<uint32_t>( m_lenBuffer );
+    buf.bid = bid;
+    m_nBufTail++;
+  }
+  void PublishBuffers() {
+    reinterpret_cast<std::atomic<uint16_t>*>( &m_pBufRing->tail )->store( m_nBufTail, std::memory_order_release );
+  }
+
+private:
+
+  int m_fd;
+
+  void* m_pRingMap;      // sq and cq rings share one mapping (IORING_FEAT_SINGLE_MMAP)
+  std::size_t m_lenRingMap;
+  io_uring_sqe* m_pSqe;
+  std::size_t m_lenSqe;
+
+  struct sq_t {
+    std::atomic<uint32_t>* pHead;
+    std::atomic<uint32_t>* pTail;
+    uint32_t* pArray;
+    uint32_t mask;
+    uint32_t entries;
+    uint32_t tail;       // local, published by Submit
+    uint32_t submitted;  // up to here handed to the kernel
+  } m_sq;
+
+  struct cq_t {
+    std::atomic<uint32_t>* pHead;
+    std::atomic<uint32_t>* pTail;
+    io_uring_cqe* pCqe;
+    uint32_t mask;
+  } m_cq;
+
+  // provided buffers
+  io_uring_buf_ring* m_pBufRing;
+  std::size_t m_lenBufRing;
+  uint8_t* m_pBuffers;
+  std::size_t m_lenBuffer;
+  uint32_t m_maskBuf;
+  uint16_t m_nBufTail;
+  uint16_t m_bgid;
+  bool m_bBufRing;     // registered
+  bool m_bBuffers;     // fixed buffers registered
+
+};
+
+#endif /* URING_H */
+
@@ -0,0 +1,305 @@
+/*
+ * File:   zone_image.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 1:15 PM
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "name_kernels.h"
+#include "zone_image.h"
+
+namespace image {
+
+std::size_t MakeKey( const uint8_t* pWire, uint8_t* pKey ) {
+  const uint8_t* labels[ dns::max_labels ];
+  unsigned nLabels( 0 );
+  for ( const uint8_t* p = pWire; 0 != *p; p += 1 + *p ) labels[ nLabels++ ] = p;
+  uint8_t* pDst( pKey );
+  while ( 0 < nLabels ) {
+    const uint8_t* pLabel = labels[ --nLabels ];
+    std::memcpy( pDst, pLabel, 1 + *pLabel );
+    pDst += 1 + *pLabel;
+  }
+  dns::lower( pKey, pDst - pKey, pKey ); // length octets are below 'A', so left alone
+  return pDst - pKey;
+}
+
+} // namespace image
+
+namespace {
+
+  // length of the uncompressed wire name at p, within len octets;  0 when it
+  //   runs past them, is compressed, or is too long to be a name
+  std::size_t NameLength( const uint8_t* p, std::size_t len ) {
+    std::size_t ix( 0 );
+    while ( ix < len ) {
+      const uint8_t lenLabel = p[ ix ];
+      if ( dns::max_label_length < lenLabel ) return 0;
+      ix += 1 + lenLabel;
+      if ( dns::max_name_length < ix ) return 0;
+      if ( 0 == lenLabel ) return ix;
+    }
+    return 0;
+  }
+
+} // namespace anonymous
+
+zone_image::zone_image()
+  : m_pMap( nullptr ), m_lenMap( 0 ),
+    m_pHeader( nullptr ), m_pZones( nullptr ), m_pNodes( nullptr ), m_pRRsets( nullptr ),
+    m_pNames( nullptr ), m_pRData( nullptr )
+{
+}
+
+zone_image::~zone_image() {
+  Close();
+}
+
+void zone_image::Close() {
+  if ( nullptr != m_pMap ) {
+    munmap( m_pMap, m_lenMap );
+    m_pMap = nullptr;
+    m_lenMap = 0;
+  }
+  m_pHeader = nullptr;
+}
+
+void zone_image::Prefault() const {
+  const volatile uint8_t* p = static_cast<const uint8_t*>( m_pMap );
+  const std::size_t lenPage = sysconf( _SC_PAGESIZE );
+  uint8_t sum( 0 );
+  for ( std::size_t ix = 0; ix < m_lenMap; ix += lenPage ) sum += p[ ix ];
+  (void)sum;
+}
+
+bool zone_image::Open( const std::string& sPath, std::string& sError ) {
+
+  Close();
+
+  int fd = open( sPath.c_str(), O_RDONLY | O_CLOEXEC );
+  if ( 0 > fd ) {
+    sError = "can not open " + sPath + ": " + std::strerror( errno );
+    return false;
+  }
+  struct stat st;
+  if ( 0 != fstat( fd, &st ) ) {
+    sError = "can not stat " + sPath + ": " + std::strerror( errno );
+    close( fd );
+    return false;
+  }
+  const std::size_t len = st.st_size;
+  if ( sizeof( image::header_t ) > len ) {
+    sError = sPath + " is too short to be a zone image";
+    close( fd );
+    return false;
+  }
+  // read-only and shared:  pages come in on demand and are shared with any
+  //   other process mapping the same image
+  void* pMap = mmap( nullptr, len, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if ( MAP_FAILED == pMap ) {
+    sError = "can not map " + sPath + ": " + std::strerror( errno );
+    return false;
+  }
+  m_pMap = pMap;
+  m_lenMap = len;
+
+  const uint8_t* pBase = static_cast<const uint8_t*>( pMap );
+  const image::header_t* pHeader = reinterpret_cast<const image::header_t*>( pBase );
+
+  if ( 0 != std::memcmp( pHeader->magic, image::magic, sizeof( image::magic ) ) ) sError = "bad magic";
+  else if ( image::byte_order != pHeader->byte_order ) sError = "compiled with a different byte order";
+  else if ( image::version != pHeader->version ) sError = "unsupported version";
+  else if ( len != pHeader->size ) sError = "size does not match the header";
+  else {
+    auto inside = [len]( uint64_t offset, uint64_t length ){ return ( offset <= len ) && ( length <= len - offset ); };
+    if ( !inside( pHeader->offZones, uint64_t( pHeader->nZones ) * sizeof( image::zone_t ) )
+      || !inside( pHeader->offNodes, uint64_t( pHeader->nNodes ) * sizeof( image::node_t ) )
+      || !inside( pHeader->offRRsets, uint64_t( pHeader->nRRsets ) * sizeof( image::rrset_t ) )
+      || !inside( pHeader->offNames, pHeader->lenNames )
+      || !inside( pHeader->offRData, pHeader->lenRData )
+      || ( 0 == pHeader->nNodes )
+    ) {
+      sError = "section outside of the image";
+    }
+  }
+
+  if ( !sError.empty() ) {
+    sError = sPath + ": " + sError;
+    Close();
+    return false;
+  }
+
+  m_pHeader = pHeader;
+  m_pZones = reinterpret_cast<const image::zone_t*>( pBase + pHeader->offZones );
+  m_pNodes = reinterpret_cast<const image::node_t*>( pBase + pHeader->offNodes );
+  m_pRRsets = reinterpret_cast<const image::rrset_t*>( pBase + pHeader->offRRsets );
+  m_pNames = pBase + pHeader->offNames;
+  m_pRData = pBase + pHeader->offRData;
+
+  if ( !Validate( sError ) ) {
+    sError = sPath + ": " + sError;
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+bool zone_image::Validate( std::string& sError ) const {
+
+  const image::header_t& header( *m_pHeader );
+
+  for ( uint32_t ix = 0; ix < header.nZones; ix++ ) {
+    const image::zone_t& zone( m_pZones[ ix ] );
+    if ( ( header.nNodes <= zone.ixApex ) || ( header.nRRsets <= zone.ixSoa ) ) {
+      sError = "zone " + std::to_string( ix ) + " refers outside of the image";
+      return false;
+    }
+    // NegativeTtl reads the minimum field of the first record
+    const image::rrset_t& soa( m_pRRsets[ zone.ixSoa ] );
+    if ( ( dns::type::SOA != soa.type ) || ( 0 == soa.nRR ) ) {
+      sError = "zone " + std::to_string( ix ) + " has no SOA";
+      return false;
+    }
+  }
+
+  for ( uint32_t ix = 0; ix < header.nNodes; ix++ ) {
+    const image::node_t& node( m_pNodes[ ix ] );
+    const bool bApex = 0 != ( node.flags & image::node_flag::apex );
+    if ( ( uint64_t( node.ixChild ) + node.nChildren > header.nNodes )
+      || ( uint64_t( node.ixRRset ) + node.nRRsets > header.nRRsets )
+      || ( ( image::no_zone != node.ixZone ) && ( header.nZones <= node.ixZone ) )
+      || ( bApex && ( image::no_zone == node.ixZone ) )
+      || ( header.lenNames <= node.offLabel )
+      || ( dns::max_label_length < m_pNames[ node.offLabel ] )
+      || ( header.lenNames - node.offLabel < 1u + m_pNames[ node.offLabel ] )
+      || ( header.lenNames <= node.offName )
+      || ( 0 == NameLength( m_pNames + node.offName, header.lenNames - node.offName ) )
+    ) {
+      sError = "node " + std::to_string( ix ) + " refers outside of the image";
+      return false;
+    }
+  }
+
+  for ( uint32_t ix = 0; ix < header.nRRsets; ix++ ) {
+    const image::rrset_t& rrset( m_pRRsets[ ix ] );
+    if ( ( header.lenRData < rrset.offRData ) || ( header.lenRData - rrset.offRData < rrset.lenRData ) ) {
+      sError = "rrset " + std::to_string( ix ) + " rdata outside of the image";
+      return false;
+    }
+    // each record a native length then its rdata, filling lenRData exactly;
+    //   the names rrset_part writes through the compressor must be whole
+    const uint8_t* p = m_pRData + rrset.offRData;
+    std::size_t lenLeft( rrset.lenRData );
+    for ( uint16_t ixRR = 0; ixRR < rrset.nRR; ixRR++ ) {
+      uint16_t len;
+      bool bValid = sizeof( len ) <= lenLeft;
+      if ( bValid ) {
+        std::memcpy( &len, p, sizeof( len ) );
+        p += sizeof( len );
+        lenLeft -= sizeof( len );
+        bValid = len <= lenLeft;
+      }
+      if ( bValid ) {
+        switch ( rrset.type ) {
+          case dns::type::NS:
+          case dns::type::CNAME:
+          case dns::type::PTR:
+            bValid = len == NameLength( p, len );
+            break;
+          case dns::type::MX:
+            bValid = ( 2 < len ) && ( len - 2u == NameLength( p + 2, len - 2 ) );
+            break;
+          case dns::type::SOA:
+            bValid = 20 < len; // two names, then five 32 bit fields
+            break;
+          default:
+            break;
+        }
+      }
+      if ( !bValid ) {
+        sError = "rrset " + std::to_string( ix ) + " record " + std::to_string( ixRR ) + " is malformed";
+        return false;
+      }
+      p += len;
+      lenLeft -= len;
+    }
+    if ( 0 != lenLeft ) {
+      sError = "rrset " + std::to_string( ix ) + " rdata length does not match its records";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const image::node_t* zone_image::FindChild( const image::node_t& parent, const uint8_t* pLabel ) const {
+  const uint32_t prefix = image::LabelPrefix( pLabel );
+  uint32_t ixLow( parent.ixChild );
+  uint32_t ixHigh( parent.ixChild + parent.nChildren );
+  while ( ixLow < ixHigh ) {
+    const uint32_t ixMid = ixLow + ( ixHigh - ixLow ) / 2;
+    const image::node_t& node( m_pNodes[ ixMid ] );
+    int result;
+    if ( node.prefix != prefix ) result = ( node.prefix < prefix ) ? -1 : 1;
+    else {
+      // same length and first three octets, the rest only when there is more
+      result = ( 3 < *pLabel ) ? std::memcmp( m_pNames + node.offLabel + 4, pLabel + 4, *pLabel - 3 ) : 0;
+    }
+    if ( 0 == result ) return &node;
+    if ( 0 > result ) ixLow = ixMid + 1;
+    else ixHigh = ixMid;
+  }
+  return nullptr;
+}
+
+void zone_image::Lookup( const uint8_t* pKey, std::size_t lenKey, image::lookup_t& result ) const {
+
+  static const uint8_t wildcard[] = { 1, '*' };
+
+  result = image::lookup_t{ nullptr, nullptr, nullptr, nullptr, nullptr };
+  if ( nullptr == m_pHeader ) return;
+
+  const image::node_t* pNode = m_pNodes; // the root
+  std::size_t ix( 0 );
+  while ( true ) {
+    if ( 0 != ( pNode->flags & image::node_flag::apex ) ) {
+      result.pZone = &m_pZones[ pNode->ixZone ];
+      result.pCut = nullptr; // a cut above belongs to the parent zone
+    }
+    else {
+      if ( ( 0 != ( pNode->flags & image::node_flag::delegation ) ) && ( nullptr == result.pCut ) ) result.pCut = pNode;
+    }
+    if ( lenKey == ix ) {
+      result.pNode = pNode;
+      break;
+    }
+    const image::node_t* pChild = FindChild( *pNode, pKey + ix );
+    if ( nullptr == pChild ) break;
+    pNode = pChild;
+    ix += 1 + pKey[ ix ];
+  }
+
+  result.pEncloser = pNode;
+  if ( ( nullptr == result.pNode ) && ( 0 != ( pNode->flags & image::node_flag::wildcard ) ) ) {
+    result.pWildcard = FindChild( *pNode, wildcard );
+  }
+}
+
+const image::rrset_t* zone_image::FindRRset( const image::node_t& node, uint16_t type ) const {
+  for ( uint32_t ix = node.ixRRset; ix < node.ixRRset + node.nRRsets; ix++ ) {
+    if ( type == m_pRRsets[ ix ].type ) return &m_pRRsets[ ix ];
+  }
+  return nullptr;
+}
@@ -0,0 +1,238 @@
+/*
+ * File:   zone_image.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 1:15 PM
+ */
+
+#ifndef ZONE_IMAGE_H
+#define ZONE_IMAGE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "dns.h"
+#include "dns_build.h"
+#include "dns_parse.h"
+
+// A compiled zone image:  written by zonec from RFC 1035 master files, mapped
+// read-only by the server and answered from directly, no parsing at startup.
+//
+// Everything is addressed by offsets from the start of the image, so it is
+// relocatable and can be shared between processes.  Integers are in the byte
+// order of the machine which compiled it (checked on open).
+//
+// Nodes form a label trie from the root down:  one node per name, written
+// breadth first, so the children of a node are contiguous and sorted on their
+// label (length prefixed, lower cased).  A node's first four label octets are
+// kept in the node itself, so a descent mostly compares integers within a few
+// cache lines and only touches the names section on a tie.  One descent
+// gives the exact match, the closest encloser, the delegation cut and the
+// zone (see lookup_t).  Empty non-terminals, and the names above each apex,
+// get a node with no rrsets.
+
+namespace image {
+
+  enum : uint32_t {
+    version = 2,
+    byte_order = 0x01020304,
+    no_zone = 0xffffffff
+  };
+
+  // "cppdnsz" and a nul
+  const char magic[ 8 ] = { 'c', 'p', 'p', 'd', 'n', 's', 'z', 0 };
+
+  struct header_t {
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t size;          // of the whole image, checked against the file
+    uint32_t nZones;   uint32_t offZones;
+    uint32_t nNodes;   uint32_t offNodes;  // node 0 is the root
+    uint32_t nRRsets;  uint32_t offRRsets;
+    uint32_t lenNames; uint32_t offNames;  // labels and wire format names
+    uint32_t lenRData; uint32_t offRData;
+  };
+
+  struct zone_t {
+    uint32_t ixApex;        // node
+    uint32_t ixSoa;         // rrset
+  };
+
+  namespace node_flag {
+    enum : uint16_t {
+      apex = 1,
+      delegation = 2,       // NS below an apex
+      wildcard = 4          // has a '*' child
+    };
+  }
+
+  struct node_t {
+    uint32_t prefix;        // label octets 0..3 (length first), big endian, zero padded
+    uint32_t offLabel;      // length prefixed, lower cased
+    uint32_t ixChild;       // first of nChildren, contiguous and sorted on label
+    uint32_t nChildren;
+    uint32_t ixRRset;       // first of nRRsets, sorted by type
+    uint16_t nRRsets;
+    uint16_t flags;
+    uint32_t ixZone;        // of the deepest apex at or above, no_zone above them all
+    uint32_t offName;       // wire format, as first written in the master file
+  };
+
+  struct rrset_t {
+    uint16_t type;
+    uint16_t rrclass;
+    uint32_t ttl;
+    uint32_t offRData;      // nRR times: uint16_t length (native order), then the rdata
+    uint32_t lenRData;
+    uint16_t nRR;
+    uint16_t reserved;
+  };
+
+  // label octets 0..3 as kept in node_t::prefix
+  inline uint32_t LabelPrefix( const uint8_t* pLabel ) {
+    uint8_t r[ 4 ] = { pLabel[ 0 ], 0, 0, 0 };
+    for ( unsigned ix = 1; ( ix < 4 ) && ( ix <= pLabel[ 0 ] ); ix++ ) r[ ix ] = pLabel[ ix ];
+    return dns::get32( r );
+  }
+
+  // the result of one descent
+  struct lookup_t {
+    const zone_t* pZone;      // deepest apex on the path, nullptr when not ours
+    const node_t* pNode;      // exact match, nullptr when the name does not exist
+    const node_t* pEncloser;  // closest encloser:  deepest existing node on the path
+    const node_t* pCut;       // highest delegation below pZone's apex on the path, nullptr when none
+    const node_t* pWildcard;  // '*' child of the closest encloser, when there is no exact match
+  };
+
+  // reversed, lower cased labels of an uncompressed wire name:
+  //   www.example.com -> \3com\7example\3www
+  //   returns the key length, the root's key is empty
+  std::size_t MakeKey( const uint8_t* pWire, uint8_t* pKey );
+
+} // namespace image
+
+class zone_image {
+public:
+
+  zone_image();
+  virtual ~zone_image();
+
+  // map and validate, false with sError filled in on failure
+  bool Open( const std::string& sPath, std::string& sError );
+  void Close();
+
+  bool empty() const { return nullptr == m_pHeader; }
+
+  // read a byte of every page, so they are mapped before queries reach them
+  void Prefault() const;
+
+  // one descent of the trie for the key (from MakeKey)
+  void Lookup( const uint8_t* pKey, std::size_t lenKey, image::lookup_t& ) const;
+  // rrset of the node with the given type, nullptr when none
+  const image::rrset_t* FindRRset( const image::node_t&, uint16_t type ) const;
+
+  const image::node_t& node( uint32_t ix ) const { return m_pNodes[ ix ]; }
+  const image::rrset_t& rrset( uint32_t ix ) const { return m_pRRsets[ ix ]; }
+  const image::zone_t& zone( uint32_t ix ) const { return m_pZones[ ix ]; }
+  const uint8_t* name( const image::node_t& node ) const { return m_pNames + node.offName; }
+  const uint8_t* rdata( const image::rrset_t& rrset ) const { return m_pRData + rrset.offRData; }
+
+  std::size_t size() const { return m_lenMap; }
+
+protected:
+private:
+
+  void* m_pMap;
+  std::size_t m_lenMap;
+
+  const image::header_t* m_pHeader;
+  const image::zone_t* m_pZones;
+  const image::node_t* m_pNodes;
+  const image::rrset_t* m_pRRsets;
+  const uint8_t* m_pNames;
+  const uint8_t* m_pRData;
+
+  const image::node_t* FindChild( const image::node_t&, const uint8_t* pLabel ) const;
+
+  // every index and offset inside the sections against their bounds, so
+  //   Lookup and rrset_part can follow them unchecked;  false with sError
+  bool Validate( std::string& sError ) const;
+
+};
+
+// rrsets from the image as one dns_build part (a CNAME chain and its target,
+//   or the NS and glue of a referral), owner names compress against whatever
+//   has already been written (usually the question)
+template<int Section>
+struct rrset_part {
+  enum { section = Section, capacity = 16 };
+  struct entry_t {
+    const image::rrset_t* pRRset;
+    const uint8_t* pOwner;  // uncompressed wire format
+    uint32_t ttl;
+  };
+  const zone_image& zone;
+  unsigned n;
+  entry_t entry[ capacity ];
+  explicit rrset_part( const zone_image& zone_ ): zone( zone_ ), n( 0 ) {}
+  bool add( const image::rrset_t& rrset, const uint8_t* pOwner ) { return add( rrset, pOwner, rrset.ttl ); }
+  bool add( const image::rrset_t& rrset, const uint8_t* pOwner, uint32_t ttl ) {
+    if ( capacity == n ) return false;
+    entry[ n++ ] = entry_t{ &rrset, pOwner, ttl };
+    return true;
+  }
+  bool full() const { return capacity == n; }
+  uint16_t count() const {
+    uint16_t nRR( 0 );
+    for ( unsigned ix = 0; ix < n; ix++ ) nRR += entry[ ix ].pRRset->nRR;
+    return nRR;
+  }
+  std::size_t max_size() const {
+    std::size_t size( 0 );
+    for ( unsigned ix = 0; ix < n; ix++ ) {
+      const image::rrset_t& rrset( *entry[ ix ].pRRset );
+      size += rrset.nRR * ( dns::name_length( entry[ ix ].pOwner ) + 10 ) + rrset.lenRData;
+    }
+    return size;
+  }
+  void write( dns::writer& w ) const {
+    for ( unsigned ix = 0; ix < n; ix++ ) write( w, entry[ ix ] );
+  }
+private:
+  void write( dns::writer& w, const entry_t& e ) const {
+    const image::rrset_t& rrset( *e.pRRset );
+    const uint8_t* p = zone.rdata( rrset );
+    for ( uint16_t ix = 0; ix < rrset.nRR; ix++ ) {
+      uint16_t len;
+      std::memcpy( &len, p, sizeof( len ) );
+      p += sizeof( len );
+      w.name( e.pOwner );
+      w.u16( rrset.type );
+      w.u16( rrset.rrclass );
+      w.u32( e.ttl );
+      uint8_t* pRdLength = w.position();
+      w.u16( 0 );
+      switch ( rrset.type ) { // names in rdata which may be compressed (RFC 3597 section 4)
+        case dns::type::NS:
+        case dns::type::CNAME:
+        case dns::type::PTR:
+          w.name( p );
+          break;
+        case dns::type::MX:
+          w.bytes( p, 2 );
+          w.name( p + 2 );
+          break;
+        default:
+          w.bytes( p, len );
+          break;
+      }
+      dns::put16( pRdLength, static_cast<uint16_t>( w.position() - pRdLength - 2 ) );
+      p += len;
+    }
+  }
+};
+
+#endif /* ZONE_IMAGE_H */
@@ -0,0 +1,113 @@
+/*
+ * File:   zone_store.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 21, 2026, 9:30 AM
+ */
+
+#include <boost/asio/post.hpp>
+
+#include "logger.h"
+#include "zone_store.h"
+
+namespace asio = boost::asio;
+
+zone_store::zone_store()
+: m_pCurrent( nullptr ), m_epoch( 0 ), m_bStop( false ), m_bReloading( false )
+{}
+
+zone_store::~zone_store() {
+  Stop();
+}
+
+bool zone_store::Open( const std::string& sPath, std::string& sError ) {
+  std::unique_ptr<zone_image> pImage( new zone_image );
+  if ( !pImage->Open( sPath, sError ) ) return false;
+  m_sPath = sPath;
+  m_pImage = std::move( pImage );
+  m_pCurrent.store( m_pImage.get(), std::memory_order_release );
+  return true;
+}
+
+void zone_store::AddReader( asio::io_context& io_context, fSwitch_t&& fSwitch ) {
+  std::lock_guard<std::mutex> lock( m_mutex );
+  m_vReader.emplace_back( new reader_t( io_context, std::move( fSwitch ) ) );
+  m_vReader.back()->epoch = m_epoch.load( std::memory_order_acquire );
+}
+
+bool zone_store::Reload() {
+  if ( m_sPath.empty() ) return false;
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( m_bStop ) return false;
+  }
+  if ( m_bReloading.exchange( true ) ) return false;
+  if ( m_thread.joinable() ) m_thread.join(); // the previous one, finished
+  m_thread = std::thread( [this](){ Run(); } );
+  return true;
+}
+
+void zone_store::Stop() {
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_bStop = true;
+  }
+  m_cvReader.notify_all();
+  if ( m_thread.joinable() ) m_thread.join();
+}
+
+void zone_store::Run() {
+
+  std::unique_ptr<zone_image> pNew( new zone_image );
+  std::string sError;
+  if ( !pNew->Open( m_sPath, sError ) ) {
+    LOG_ERROR( "zone reload: {}, keeping the image in use", sError );
+    m_bReloading = false;
+    return;
+  }
+  pNew->Prefault();
+
+  // publish:  from here on every new reader view is of the new image
+  std::unique_ptr<zone_image> pOld( std::move( m_pImage ) );
+  m_pImage = std::move( pNew );
+  const zone_image* pCurrent = m_pImage.get();
+  m_pCurrent.store( pCurrent, std::memory_order_release );
+  const uint64_t epoch = 1 + m_epoch.fetch_add( 1, std::memory_order_acq_rel );
+
+  std::unique_lock<std::mutex> lock( m_mutex );
+
+  for ( std::unique_ptr<reader_t>& pReader_: m_vReader ) {
+    reader_t* pReader( pReader_.get() );
+    asio::post( pReader->io_context, [this, pReader, pCurrent, epoch](){
+      pReader->fSwitch( pCurrent );  // between handlers:  nothing of the old image is held
+      {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        pReader->epoch = epoch;
+      }
+      m_cvReader.notify_all();
+    } );
+  }
+
+  // the grace period
+  m_cvReader.wait( lock, [this, epoch](){
+    if ( m_bStop ) return true;
+    for ( const std::unique_ptr<reader_t>& pReader: m_vReader ) {
+      if ( epoch > pReader->epoch ) return false;
+    }
+    return true;
+  } );
+
+  if ( m_bStop ) {
+    m_vRetired.push_back( std::move( pOld ) ); // a reader may never get to it, keep it until the end
+    LOG_WARN( "zone reload: stopped before every worker switched" );
+  }
+  else {
+    lock.unlock();
+    const std::size_t lenOld = pOld ? pOld->size() : 0;
+    pOld.reset();
+    LOG_INFO( "zone image {} reloaded, {} bytes (was {}), epoch {}.", m_sPath, pCurrent->size(), lenOld, epoch );
+  }
+
+  m_bReloading = false;
+}
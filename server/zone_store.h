@@ -0,0 +1,94 @@
+/*
+ * File:   zone_store.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 21, 2026, 9:30 AM
+ */
+
+#ifndef ZONE_STORE_H
+#define ZONE_STORE_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include <boost/asio/io_context.hpp>
+
+#include "zone_image.h"
+
+// The zone image in use, replaced while the workers keep answering, read-copy-
+// update style.
+//
+// Reload() opens and validates the new image on a thread of its own, touching
+// every page so the workers don't fault on it later, then publishes it with an
+// atomic pointer swap and moves the epoch on.  Each reader (a worker thread)
+// is told through its io_context:  between two handlers it holds no pointer
+// into the image, so that is its quiescent state;  it takes the new pointer,
+// drops whatever it cached from the old one, and records the epoch it has
+// reached.  Once every reader has reached the new epoch, nothing can refer to
+// the old image and it is unmapped.  Readers pay nothing per query:  they use
+// a plain pointer of their own, swapped only in that handler.
+//
+// So the old image lives as long as the slowest worker takes to finish the
+// handler it is in, and the two are mapped together only that long.
+
+class zone_store {
+public:
+
+  typedef std::function<void( const zone_image* )> fSwitch_t; // in the reader's thread
+
+  zone_store();
+  virtual ~zone_store();
+
+  // the first image, before any reader starts;  false with sError filled in
+  bool Open( const std::string& sPath, std::string& sError );
+
+  const zone_image* current() const { return m_pCurrent.load( std::memory_order_acquire ); }
+  uint64_t epoch() const { return m_epoch.load( std::memory_order_acquire ); }
+
+  // fSwitch is run in io_context's thread at each reload
+  void AddReader( boost::asio::io_context&, fSwitch_t&& fSwitch );
+
+  // the same path again, in the background;  false when one is under way
+  bool Reload();
+
+  // no more reloads, and one under way gives up waiting for readers:
+  //   call before the readers' io_contexts stop
+  void Stop();
+
+private:
+
+  struct reader_t {
+    boost::asio::io_context& io_context;
+    fSwitch_t fSwitch;
+    uint64_t epoch;  // reached, under m_mutex
+    reader_t( boost::asio::io_context& io_context_, fSwitch_t&& fSwitch_ )
+    : io_context( io_context_ ), fSwitch( std::move( fSwitch_ ) ), epoch( 0 ) {}
+  };
+
+  std::string m_sPath;
+
+  std::atomic<const zone_image*> m_pCurrent;
+  std::atomic<uint64_t> m_epoch;
+  std::unique_ptr<zone_image> m_pImage; // owns m_pCurrent
+
+  std::vector<std::unique_ptr<reader_t> > m_vReader;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cvReader;
+  std::vector<std::unique_ptr<zone_image> > m_vRetired; // abandoned by a Stop, freed at the end
+  bool m_bStop;
+
+  std::thread m_thread;
+  std::atomic<bool> m_bReloading;
+
+  void Run();
+};
+
+#endif /* ZONE_STORE_H */
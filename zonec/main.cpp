@@ -0,0 +1,66 @@
+/*
+ * File:   main.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 4:20 PM
+ */
+
+// zonec:  compile RFC 1035 master files into one image for 'server -z'
+
+#include <string>
+#include <iostream>
+
+#include <getopt.h>
+
+#include "zone_compiler.h"
+
+int main( int argc, char* argv[] ) {
+
+  const char* szUsage = "Usage: zonec -o <image> <master file>[:<origin>] ...";
+
+  std::string sImage;
+  int opt;
+  while ( -1 != ( opt = getopt( argc, argv, "o:" ) ) ) {
+    switch ( opt ) {
+      case 'o':
+        sImage = optarg;
+        break;
+      default:
+        std::cerr << szUsage << std::endl;
+        return 1;
+    }
+  }
+  if ( sImage.empty() || ( optind == argc ) ) {
+    std::cerr << szUsage << std::endl;
+    return 1;
+  }
+
+  zone_compiler compiler;
+  std::string sError;
+
+  for ( int ix = optind; ix < argc; ix++ ) {
+    std::string sFile( argv[ ix ] );
+    std::string sOrigin;
+    const std::size_t ixColon = sFile.rfind( ':' );
+    if ( std::string::npos != ixColon ) {
+      sOrigin = sFile.substr( ixColon + 1 );
+      sFile.erase( ixColon );
+    }
+    if ( !compiler.AddMasterFile( sFile, sOrigin, sError ) ) {
+      std::cerr << sError << std::endl;
+      return 1;
+    }
+  }
+
+  if ( !compiler.WriteImage( sImage, sError ) ) {
+    std::cerr << sError << std::endl;
+    return 1;
+  }
+
+  std::cout
+    << sImage << ": " << compiler.zones() << " zone(s), "
+    << compiler.records() << " record(s)." << std::endl;
+
+  return 0;
+}
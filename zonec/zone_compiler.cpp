@@ -0,0 +1,721 @@
+/*
+ * File:   zone_compiler.cpp
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 2:40 PM
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+
+#include <arpa/inet.h>
+
+#include "dns.h"
+#include "zone_image.h"
+#include "zone_compiler.h"
+
+namespace {
+
+  const uint32_t default_ttl = 3600;
+
+  struct type_name_t {
+    const char* sz;
+    uint16_t type;
+  };
+
+  const type_name_t rTypeName[] = {
+    { "A", dns::type::A }, { "NS", dns::type::NS }, { "CNAME", dns::type::CNAME },
+    { "SOA", dns::type::SOA }, { "PTR", dns::type::PTR }, { "MX", dns::type::MX },
+    { "TXT", dns::type::TXT }, { "AAAA", dns::type::AAAA }, { "SRV", dns::type::SRV }
+  };
+
+  std::string Upper( const std::string& s ) {
+    std::string result( s );
+    for ( char& ch: result ) ch = std::toupper( static_cast<unsigned char>( ch ) );
+    return result;
+  }
+
+  bool Number( const std::string& s, uint32_t& value ) {
+    if ( s.empty() || ( 10 < s.size() ) ) return false;
+    uint64_t n( 0 );
+    for ( char ch: s ) {
+      if ( ( '0' > ch ) || ( '9' < ch ) ) return false;
+      n = n * 10 + ( ch - '0' );
+    }
+    if ( 0xffffffff < n ) return false;
+    value = static_cast<uint32_t>( n );
+    return true;
+  }
+
+  bool Number16( const std::string& s, uint16_t& value ) {
+    uint32_t n;
+    if ( !Number( s, n ) || ( 0xffff < n ) ) return false;
+    value = static_cast<uint16_t>( n );
+    return true;
+  }
+
+  // 3600, or with BIND style units:  1h30m, 1w
+  bool Ttl( const std::string& s, uint32_t& value ) {
+    if ( Number( s, value ) ) return true;
+    uint64_t total( 0 );
+    uint64_t n( 0 );
+    bool bDigits( false );
+    for ( char ch: s ) {
+      if ( ( '0' <= ch ) && ( '9' >= ch ) ) {
+        n = n * 10 + ( ch - '0' );
+        bDigits = true;
+        if ( 0xffffffff < n ) return false;
+        continue;
+      }
+      if ( !bDigits ) return false;
+      switch ( std::tolower( static_cast<unsigned char>( ch ) ) ) {
+        case 's': total += n; break;
+        case 'm': total += n * 60; break;
+        case 'h': total += n * 3600; break;
+        case 'd': total += n * 86400; break;
+        case 'w': total += n * 604800; break;
+        default: return false;
+      }
+      n = 0;
+      bDigits = false;
+    }
+    total += n;
+    if ( s.empty() || ( 0xffffffff < total ) ) return false;
+    value = static_cast<uint32_t>( total );
+    return true;
+  }
+
+  bool Type( const std::string& s, uint16_t& type ) {
+    const std::string sUpper( Upper( s ) );
+    for ( const type_name_t& entry: rTypeName ) {
+      if ( sUpper == entry.sz ) {
+        type = entry.type;
+        return true;
+      }
+    }
+    return ( 0 == sUpper.compare( 0, 4, "TYPE" ) ) && Number16( sUpper.substr( 4 ), type );
+  }
+
+  bool Class( const std::string& s, uint16_t& rrclass ) {
+    const std::string sUpper( Upper( s ) );
+    if ( "IN" == sUpper ) { rrclass = dns::cls::IN; return true; }
+    if ( "CH" == sUpper ) { rrclass = dns::cls::CH; return true; }
+    return ( 0 == sUpper.compare( 0, 5, "CLASS" ) ) && Number16( sUpper.substr( 5 ), rrclass );
+  }
+
+  // one octet of presentation text at ix, following \X and \DDD escapes
+  bool Octet( const std::string& s, std::size_t& ix, uint8_t& octet ) {
+    if ( '\\' != s[ ix ] ) {
+      octet = s[ ix++ ];
+      return true;
+    }
+    ix++;
+    if ( s.size() == ix ) return false;
+    if ( std::isdigit( static_cast<unsigned char>( s[ ix ] ) ) ) {
+      if ( ( s.size() < ix + 3 )
+        || !std::isdigit( static_cast<unsigned char>( s[ ix + 1 ] ) )
+        || !std::isdigit( static_cast<unsigned char>( s[ ix + 2 ] ) )
+      ) return false;
+      const unsigned value = ( s[ ix ] - '0' ) * 100 + ( s[ ix + 1 ] - '0' ) * 10 + ( s[ ix + 2 ] - '0' );
+      if ( 255 < value ) return false;
+      octet = static_cast<uint8_t>( value );
+      ix += 3;
+      return true;
+    }
+    octet = s[ ix++ ];
+    return true;
+  }
+
+  // presentation name to uncompressed wire format, relative to origin
+  bool Name( const std::string& s, const std::string& origin, std::string& wire ) {
+    wire.clear();
+    if ( "@" == s ) {
+      wire = origin;
+      return !wire.empty();
+    }
+    if ( "." == s ) {
+      wire.push_back( 0 );
+      return true;
+    }
+    std::string label;
+    std::size_t ix( 0 );
+    bool bAbsolute( false );
+    while ( ix < s.size() ) {
+      if ( '.' == s[ ix ] ) {
+        if ( label.empty() || ( dns::max_label_length < label.size() ) ) return false;
+        wire.push_back( static_cast<char>( label.size() ) );
+        wire += label;
+        label.clear();
+        ix++;
+        if ( s.size() == ix ) bAbsolute = true;
+        continue;
+      }
+      uint8_t octet;
+      if ( !Octet( s, ix, octet ) ) return false;
+      label.push_back( static_cast<char>( octet ) );
+    }
+    if ( !label.empty() ) {
+      if ( dns::max_label_length < label.size() ) return false;
+      wire.push_back( static_cast<char>( label.size() ) );
+      wire += label;
+    }
+    if ( bAbsolute ) wire.push_back( 0 );
+    else {
+      if ( origin.empty() ) return false;
+      wire += origin;
+    }
+    return dns::max_name_length >= wire.size();
+  }
+
+  // <character-string>, quoted or not
+  bool Text( const std::string& s, std::string& rdata ) {
+    std::size_t ix( 0 );
+    std::size_t end( s.size() );
+    if ( ( 2 <= s.size() ) && ( '"' == s.front() ) && ( '"' == s.back() ) ) {
+      ix = 1;
+      end--;
+    }
+    std::string text;
+    while ( ix < end ) {
+      uint8_t octet;
+      if ( !Octet( s, ix, octet ) ) return false;
+      text.push_back( static_cast<char>( octet ) );
+    }
+    if ( 255 < text.size() ) return false;
+    rdata.push_back( static_cast<char>( text.size() ) );
+    rdata += text;
+    return true;
+  }
+
+  void Append16( std::string& s, uint16_t value ) {
+    uint8_t r[ 2 ];
+    dns::put16( r, value );
+    s.append( reinterpret_cast<const char*>( r ), 2 );
+  }
+
+  void Append32( std::string& s, uint32_t value ) {
+    uint8_t r[ 4 ];
+    dns::put32( r, value );
+    s.append( reinterpret_cast<const char*>( r ), 4 );
+  }
+
+  // native order, for the image itself
+  template<typename T>
+  void AppendNative( std::string& s, const T& value ) {
+    s.append( reinterpret_cast<const char*>( &value ), sizeof( T ) );
+  }
+
+  std::string Directory( const std::string& sPath ) {
+    const std::size_t ix = sPath.rfind( '/' );
+    return ( std::string::npos == ix ) ? std::string() : sPath.substr( 0, ix + 1 );
+  }
+
+} // namespace anonymous
+
+struct zone_compiler::state_t {
+  std::string sPath;
+  unsigned nLine;
+  std::string origin;   // wire format
+  std::string owner;    // last owner, for records with a blank owner
+  uint32_t ttlDefault;  // $TTL
+  uint32_t ttlLast;
+  bool bTtl;            // $TTL seen, otherwise the last explicit ttl carries forward
+  uint16_t rrclass;
+  std::string apex;     // key, from the SOA
+  std::vector<std::string> vKey; // of every owner in this file, checked in Finish
+  state_t(): nLine( 0 ), ttlDefault( default_ttl ), ttlLast( default_ttl ), bTtl( false ), rrclass( dns::cls::IN ) {}
+};
+
+zone_compiler::zone_compiler(): m_nRecords( 0 ) {
+}
+
+zone_compiler::~zone_compiler() {
+}
+
+std::string zone_compiler::Parent( const std::string& key ) {
+  std::size_t ix( 0 );
+  std::size_t ixLast( 0 );
+  while ( ix < key.size() ) {
+    ixLast = ix;
+    ix += 1 + static_cast<uint8_t>( key[ ix ] );
+  }
+  return key.substr( 0, ixLast );
+}
+
+zone_compiler::wire_t zone_compiler::Wire( const std::string& key ) {
+  std::string wire( 1, '\0' );
+  for ( std::size_t ix = 0; ix < key.size(); ix += 1 + static_cast<uint8_t>( key[ ix ] ) ) {
+    wire.insert( 0, key, ix, 1 + static_cast<uint8_t>( key[ ix ] ) );
+  }
+  return wire;
+}
+
+std::string zone_compiler::Key( const wire_t& name ) {
+  uint8_t key[ dns::max_name_length ];
+  const std::size_t len = image::MakeKey( reinterpret_cast<const uint8_t*>( name.data() ), key );
+  return std::string( reinterpret_cast<const char*>( key ), len );
+}
+
+bool zone_compiler::AddMasterFile( const std::string& sPath, const std::string& sOrigin, std::string& sError ) {
+  state_t state;
+  if ( !sOrigin.empty() ) {
+    std::string sAbsolute( sOrigin );
+    if ( '.' != sAbsolute.back() ) sAbsolute += '.';
+    if ( !Name( sAbsolute, std::string(), state.origin ) ) {
+      sError = "bad origin " + sOrigin;
+      return false;
+    }
+  }
+  return ParseFile( sPath, state, sError ) && Finish( state, sError );
+}
+
+bool zone_compiler::ParseFile( const std::string& sPath, state_t& state, std::string& sError ) {
+
+  std::ifstream file( sPath );
+  if ( !file ) {
+    sError = "can not open " + sPath + ": " + std::strerror( errno );
+    return false;
+  }
+
+  const std::string sPathOuter( state.sPath );
+  const unsigned nLineOuter( state.nLine );
+  state.sPath = sPath;
+  state.nLine = 0;
+
+  std::vector<std::string> vToken;
+  bool bOwner( false );
+  unsigned nParen( 0 );
+  std::string sLine;
+  bool bOk( true );
+
+  while ( bOk && std::getline( file, sLine ) ) {
+    state.nLine++;
+    if ( 0 == nParen ) {
+      vToken.clear();
+      bOwner = !sLine.empty() && !std::isspace( static_cast<unsigned char>( sLine[ 0 ] ) );
+    }
+    std::size_t ix( 0 );
+    while ( ix < sLine.size() ) {
+      const char ch = sLine[ ix ];
+      if ( std::isspace( static_cast<unsigned char>( ch ) ) ) { ix++; continue; }
+      if ( ';' == ch ) break;
+      if ( '(' == ch ) { nParen++; ix++; continue; }
+      if ( ')' == ch ) {
+        if ( 0 == nParen ) { sError = "unbalanced )"; bOk = false; break; }
+        nParen--; ix++; continue;
+      }
+      const std::size_t ixBegin( ix );
+      if ( '"' == ch ) {
+        ix++;
+        while ( ( ix < sLine.size() ) && ( '"' != sLine[ ix ] ) ) ix += ( '\\' == sLine[ ix ] ) ? 2 : 1;
+        if ( ix >= sLine.size() ) { sError = "unterminated string"; bOk = false; break; }
+        ix++;
+      }
+      else {
+        while ( ( ix < sLine.size() )
+          && !std::isspace( static_cast<unsigned char>( sLine[ ix ] ) )
+          && ( nullptr == std::strchr( ";()\"", sLine[ ix ] ) )
+        ) ix += ( '\\' == sLine[ ix ] ) ? 2 : 1;
+        ix = std::min( ix, sLine.size() );
+      }
+      vToken.emplace_back( sLine, ixBegin, ix - ixBegin );
+    }
+    if ( !bOk || ( 0 != nParen ) || vToken.empty() ) continue;
+
+    const std::string& sFirst( vToken[ 0 ] );
+    if ( bOwner && ( '$' == sFirst[ 0 ] ) ) {
+      const std::string sDirective( Upper( sFirst ) );
+      if ( "$ORIGIN" == sDirective && ( 2 == vToken.size() ) ) {
+        std::string origin;
+        if ( Name( vToken[ 1 ], state.origin, origin ) ) state.origin = origin;
+        else { sError = "bad $ORIGIN"; bOk = false; }
+      }
+      else if ( "$TTL" == sDirective && ( 2 == vToken.size() ) ) {
+        if ( Ttl( vToken[ 1 ], state.ttlDefault ) ) state.bTtl = true;
+        else { sError = "bad $TTL"; bOk = false; }
+      }
+      else if ( "$INCLUDE" == sDirective && ( 2 <= vToken.size() ) && ( 3 >= vToken.size() ) ) {
+        const std::string origin( state.origin );
+        std::string originInclude( origin );
+        if ( 3 == vToken.size() && !Name( vToken[ 2 ], origin, originInclude ) ) {
+          sError = "bad $INCLUDE origin"; bOk = false;
+        }
+        else {
+          state.origin = originInclude;
+          const std::string& sInclude( vToken[ 1 ] );
+          bOk = ParseFile( ( '/' == sInclude[ 0 ] ) ? sInclude : Directory( sPath ) + sInclude, state, sError );
+          state.origin = origin; // RFC 1035 section 5.1:  the origin reverts after an $INCLUDE
+          if ( !bOk ) return false; // already located in the included file
+        }
+      }
+      else {
+        sError = "unknown or malformed directive " + sFirst;
+        bOk = false;
+      }
+      continue;
+    }
+
+    bOk = ParseRecord( vToken, bOwner, state, sError );
+  }
+
+  if ( bOk && ( 0 != nParen ) ) {
+    sError = "unbalanced (";
+    bOk = false;
+  }
+  if ( !bOk ) {
+    sError = sPath + ":" + std::to_string( state.nLine ) + ": " + sError;
+  }
+
+  state.sPath = sPathOuter;
+  state.nLine = nLineOuter;
+  return bOk;
+}
+
+bool zone_compiler::ParseRecord( const std::vector<std::string>& vToken, bool bOwner, state_t& state, std::string& sError ) {
+
+  std::size_t ix( 0 );
+
+  if ( bOwner ) {
+    if ( !Name( vToken[ ix++ ], state.origin, state.owner ) ) {
+      sError = "bad owner " + vToken[ 0 ];
+      return false;
+    }
+  }
+  else {
+    if ( state.owner.empty() ) {
+      sError = "no previous owner";
+      return false;
+    }
+  }
+
+  // [ttl] [class] type, or [class] [ttl] type
+  uint32_t ttl( state.bTtl ? state.ttlDefault : state.ttlLast );
+  uint16_t rrclass( state.rrclass );
+  uint16_t type( 0 );
+  bool bTtl( false ), bClass( false );
+  while ( true ) {
+    if ( vToken.size() == ix ) {
+      sError = "missing type";
+      return false;
+    }
+    const std::string& sToken( vToken[ ix++ ] );
+    if ( !bTtl && std::isdigit( static_cast<unsigned char>( sToken[ 0 ] ) ) && Ttl( sToken, ttl ) ) {
+      bTtl = true;
+      continue;
+    }
+    if ( !bClass && Class( sToken, rrclass ) ) {
+      bClass = true;
+      continue;
+    }
+    if ( Type( sToken, type ) ) break;
+    sError = "unknown type " + sToken;
+    return false;
+  }
+  if ( bTtl ) state.ttlLast = ttl;
+  if ( !state.vKey.empty() && ( rrclass != state.rrclass ) ) {
+    sError = "class differs from the rest of the zone";
+    return false;
+  }
+  state.rrclass = rrclass;
+
+  // rdata
+  const std::size_t nArgs = vToken.size() - ix;
+  const std::string* pArg = vToken.data() + ix;
+  std::string rdata;
+  bool bOk( true );
+
+  if ( ( 0 < nArgs ) && ( "\\#" == pArg[ 0 ] ) ) { // RFC 3597 section 5
+    uint16_t len;
+    std::string hex;
+    for ( std::size_t ixArg = 2; ixArg < nArgs; ixArg++ ) hex += pArg[ ixArg ];
+    bOk = ( 2 <= nArgs ) && Number16( pArg[ 1 ], len ) && ( hex.size() == 2u * len );
+    for ( std::size_t ixHex = 0; bOk && ( ixHex < hex.size() ); ixHex += 2 ) {
+      char* pEnd;
+      const std::string sOctet( hex, ixHex, 2 );
+      const long octet = std::strtol( sOctet.c_str(), &pEnd, 16 );
+      bOk = ( '\0' == *pEnd ) && std::isxdigit( static_cast<unsigned char>( sOctet[ 0 ] ) );
+      rdata.push_back( static_cast<char>( octet ) );
+    }
+  }
+  else {
+    std::string name;
+    uint16_t u16[ 3 ];
+    uint32_t u32[ 5 ];
+    switch ( type ) {
+      case dns::type::A: {
+        struct in_addr addr;
+        bOk = ( 1 == nArgs ) && ( 1 == inet_pton( AF_INET, pArg[ 0 ].c_str(), &addr ) );
+        rdata.assign( reinterpret_cast<const char*>( &addr ), sizeof( addr ) );
+        break;
+      }
+      case dns::type::AAAA: {
+        struct in6_addr addr;
+        bOk = ( 1 == nArgs ) && ( 1 == inet_pton( AF_INET6, pArg[ 0 ].c_str(), &addr ) );
+        rdata.assign( reinterpret_cast<const char*>( &addr ), sizeof( addr ) );
+        break;
+      }
+      case dns::type::NS:
+      case dns::type::CNAME:
+      case dns::type::PTR:
+        bOk = ( 1 == nArgs ) && Name( pArg[ 0 ], state.origin, rdata );
+        break;
+      case dns::type::MX:
+        bOk = ( 2 == nArgs ) && Number16( pArg[ 0 ], u16[ 0 ] ) && Name( pArg[ 1 ], state.origin, name );
+        if ( bOk ) {
+          Append16( rdata, u16[ 0 ] );
+          rdata += name;
+        }
+        break;
+      case dns::type::TXT:
+        bOk = ( 0 < nArgs );
+        for ( std::size_t ixArg = 0; bOk && ( ixArg < nArgs ); ixArg++ ) bOk = Text( pArg[ ixArg ], rdata );
+        break;
+      case dns::type::SRV:
+        bOk = ( 4 == nArgs )
+          && Number16( pArg[ 0 ], u16[ 0 ] ) && Number16( pArg[ 1 ], u16[ 1 ] ) && Number16( pArg[ 2 ], u16[ 2 ] )
+          && Name( pArg[ 3 ], state.origin, name );
+        if ( bOk ) {
+          for ( uint16_t value: u16 ) Append16( rdata, value );
+          rdata += name;
+        }
+        break;
+      case dns::type::SOA:
+        bOk = ( 7 == nArgs )
+          && Name( pArg[ 0 ], state.origin, name ) && Name( pArg[ 1 ], state.origin, rdata )
+          && Number( pArg[ 2 ], u32[ 0 ] )
+          && Ttl( pArg[ 3 ], u32[ 1 ] ) && Ttl( pArg[ 4 ], u32[ 2 ] ) && Ttl( pArg[ 5 ], u32[ 3 ] ) && Ttl( pArg[ 6 ], u32[ 4 ] );
+        if ( bOk ) {
+          rdata.insert( 0, name );
+          for ( uint32_t value: u32 ) Append32( rdata, value );
+        }
+        break;
+      default:
+        sError = "unknown rdata format, use \\# for type " + std::to_string( type );
+        return false;
+    }
+  }
+  if ( !bOk || ( 0xffff < rdata.size() ) ) {
+    sError = "bad rdata";
+    return false;
+  }
+
+  const std::string key( Key( state.owner ) );
+  if ( dns::type::SOA == type ) {
+    if ( !state.apex.empty() ) {
+      sError = "second SOA";
+      return false;
+    }
+    mapNode_t::const_iterator iter = m_mapNode.find( key );
+    if ( ( m_mapNode.end() != iter ) && ( 0 != iter->second.mapRRset.count( dns::type::SOA ) ) ) {
+      sError = "zone already compiled from another file";
+      return false;
+    }
+    state.apex = key;
+  }
+
+  node_t& node( m_mapNode[ key ] );
+  if ( node.name.empty() ) node.name = state.owner;
+  auto result = node.mapRRset.emplace( type, rrset_t() );
+  rrset_t& rrset( result.first->second );
+  if ( result.second ) {
+    rrset.rrclass = rrclass;
+    rrset.ttl = ttl;
+  }
+  else {
+    rrset.ttl = std::min( rrset.ttl, ttl ); // RFC 2181 section 5.2:  one ttl per rrset
+  }
+  if ( rrset.vRData.end() == std::find( rrset.vRData.begin(), rrset.vRData.end(), rdata ) ) { // no duplicates
+    if ( 0xffff == rrset.vRData.size() ) {
+      sError = "rrset too large";
+      return false;
+    }
+    rrset.vRData.emplace_back( std::move( rdata ) );
+    m_nRecords++;
+  }
+  state.vKey.push_back( key );
+  return true;
+}
+
+bool zone_compiler::Finish( state_t& state, std::string& sError ) {
+
+  if ( state.apex.empty() ) {
+    sError = state.sPath + ": no SOA";
+    return false;
+  }
+
+  for ( const std::string& key: state.vKey ) {
+    if ( 0 != key.compare( 0, state.apex.size(), state.apex ) ) {
+      sError = state.sPath + ": record outside of the zone";
+      return false;
+    }
+    const node_t& node( m_mapNode[ key ] );
+    if ( ( 0 != node.mapRRset.count( dns::type::CNAME ) ) && ( 1 != node.mapRRset.size() ) ) {
+      sError = state.sPath + ": CNAME and other data at the same name";
+      return false;
+    }
+    // empty non-terminals:  each ancestor up to the apex gets a node
+    std::size_t len( state.apex.size() );
+    std::string name( m_mapNode[ state.apex ].name );
+    while ( len < key.size() ) {
+      const uint8_t lenLabel = key[ len ];
+      name.insert( 0, key, len, 1 + lenLabel );
+      len += 1 + lenLabel;
+      node_t& ancestor( m_mapNode[ key.substr( 0, len ) ] );
+      if ( ancestor.name.empty() ) ancestor.name = name;
+    }
+  }
+
+  m_vZone.push_back( state.apex );
+  return true;
+}
+
+bool zone_compiler::WriteImage( const std::string& sPath, std::string& sError ) {
+
+  if ( m_vZone.empty() ) {
+    sError = "no zones to write";
+    return false;
+  }
+  std::sort( m_vZone.begin(), m_vZone.end() );
+
+  // the trie:  every name and each of its ancestors up to the root
+  typedef std::map<std::string, std::vector<std::string> > mapChildren_t; // parent key -> child keys
+  mapChildren_t mapChildren;
+  mapChildren[ std::string() ];
+  for ( const mapNode_t::value_type& vt: m_mapNode ) {
+    std::string key( vt.first );
+    bool bNew( mapChildren.end() == mapChildren.find( key ) );
+    while ( bNew && !key.empty() ) {
+      mapChildren[ key ];
+      const std::string parent( Parent( key ) );
+      bNew = mapChildren.end() == mapChildren.find( parent );
+      mapChildren[ parent ].push_back( key );
+      key = parent;
+    }
+  }
+  for ( mapChildren_t::value_type& vt: mapChildren ) {
+    std::sort( vt.second.begin(), vt.second.end(),
+      [&vt]( const std::string& lhs, const std::string& rhs ){ // on the label alone, the rest is the parent's
+        return 0 > lhs.compare( vt.first.size(), std::string::npos, rhs, vt.first.size(), std::string::npos );
+      } );
+  }
+
+  // breadth first, so siblings are contiguous
+  std::vector<std::string> vOrder( 1, std::string() );
+  std::map<std::string, uint32_t> mapIndex;
+  for ( std::size_t ix = 0; ix < vOrder.size(); ix++ ) {
+    mapIndex[ vOrder[ ix ] ] = ix;
+    const std::vector<std::string>& vChild( mapChildren[ vOrder[ ix ] ] );
+    vOrder.insert( vOrder.end(), vChild.begin(), vChild.end() );
+  }
+
+  std::string zones, nodes, rrsets, names, rdata;
+  uint32_t nRRsets( 0 );
+  std::vector<uint32_t> vZoneOfNode( vOrder.size(), image::no_zone );
+  std::vector<image::zone_t> vZone( m_vZone.size() );
+  uint32_t ixChild( 1 );
+
+  for ( uint32_t ixNode = 0; ixNode < vOrder.size(); ixNode++ ) {
+    const std::string& key( vOrder[ ixNode ] );
+    const std::string label( key, Parent( key ).size() ); // empty for the root
+    const mapNode_t::const_iterator iterNode = m_mapNode.find( key );
+
+    image::node_t entry;
+    std::memset( &entry, 0, sizeof( entry ) );
+
+    const uint8_t root( 0 );
+    entry.prefix = image::LabelPrefix( label.empty() ? &root : reinterpret_cast<const uint8_t*>( label.data() ) );
+    entry.offLabel = names.size();
+    names += label.empty() ? std::string( 1, '\0' ) : label;
+    entry.offName = names.size();
+    names += ( m_mapNode.end() == iterNode ) ? Wire( key ) : iterNode->second.name;
+
+    const std::vector<std::string>& vChild( mapChildren[ key ] );
+    entry.ixChild = ixChild;
+    entry.nChildren = vChild.size();
+    ixChild += vChild.size();
+
+    if ( !key.empty() ) vZoneOfNode[ ixNode ] = vZoneOfNode[ mapIndex[ Parent( key ) ] ];
+    const std::vector<std::string>::const_iterator iterZone = std::find( m_vZone.begin(), m_vZone.end(), key );
+    if ( m_vZone.end() != iterZone ) {
+      entry.flags |= image::node_flag::apex;
+      vZoneOfNode[ ixNode ] = iterZone - m_vZone.begin();
+      vZone[ vZoneOfNode[ ixNode ] ].ixApex = ixNode;
+    }
+    entry.ixZone = vZoneOfNode[ ixNode ];
+    for ( const std::string& child: vChild ) {
+      if ( ( key.size() + 2 == child.size() ) && ( 1 == child[ key.size() ] ) && ( '*' == child.back() ) ) {
+        entry.flags |= image::node_flag::wildcard;
+      }
+    }
+
+    entry.ixRRset = nRRsets;
+    if ( m_mapNode.end() != iterNode ) {
+      const node_t& node( iterNode->second );
+      entry.nRRsets = node.mapRRset.size();
+      if ( ( 0 == ( entry.flags & image::node_flag::apex ) ) && ( 0 != node.mapRRset.count( dns::type::NS ) ) ) {
+        entry.flags |= image::node_flag::delegation;
+      }
+      for ( const auto& vtRRset: node.mapRRset ) {
+        if ( dns::type::SOA == vtRRset.first ) vZone[ entry.ixZone ].ixSoa = nRRsets;
+        image::rrset_t rrset;
+        std::memset( &rrset, 0, sizeof( rrset ) );
+        rrset.type = vtRRset.first;
+        rrset.rrclass = vtRRset.second.rrclass;
+        rrset.ttl = vtRRset.second.ttl;
+        rrset.offRData = rdata.size();
+        rrset.nRR = vtRRset.second.vRData.size();
+        for ( const wire_t& rr: vtRRset.second.vRData ) {
+          AppendNative( rdata, static_cast<uint16_t>( rr.size() ) );
+          rdata += rr;
+        }
+        rrset.lenRData = rdata.size() - rrset.offRData;
+        AppendNative( rrsets, rrset );
+        nRRsets++;
+      }
+    }
+    AppendNative( nodes, entry );
+  }
+
+  for ( const image::zone_t& zone: vZone ) AppendNative( zones, zone );
+
+  image::header_t header;
+  std::memset( &header, 0, sizeof( header ) );
+  std::memcpy( header.magic, image::magic, sizeof( header.magic ) );
+  header.version = image::version;
+  header.byte_order = image::byte_order;
+  uint32_t offset( sizeof( header ) );
+  header.nZones = m_vZone.size();       header.offZones = offset;  offset += zones.size();
+  header.nNodes = vOrder.size();        header.offNodes = offset;  offset += nodes.size();
+  header.nRRsets = nRRsets;             header.offRRsets = offset; offset += rrsets.size();
+  header.lenNames = names.size();       header.offNames = offset;  offset += names.size();
+  header.lenRData = rdata.size();       header.offRData = offset;  offset += rdata.size();
+  header.size = offset;
+
+  // written aside and renamed into place, so a server mapping the old image
+  //   never sees a partial one
+  const std::string sTemp( sPath + ".tmp" );
+  {
+    std::ofstream file( sTemp, std::ios::binary | std::ios::trunc );
+    if ( file ) {
+      file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+      file << zones << nodes << rrsets << names << rdata;
+    }
+    if ( !file ) {
+      sError = "can not write " + sTemp + ": " + std::strerror( errno );
+      std::remove( sTemp.c_str() );
+      return false;
+    }
+  }
+  if ( 0 != std::rename( sTemp.c_str(), sPath.c_str() ) ) {
+    sError = "can not rename " + sTemp + " to " + sPath + ": " + std::strerror( errno );
+    std::remove( sTemp.c_str() );
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,74 @@
+/*
+ * File:   zone_compiler.h
+ * Author: Raymond Burkholder
+ *         raymond@burkholder.net
+ *
+ * Created on October 18, 2026, 2:40 PM
+ */
+
+#ifndef ZONE_COMPILER_H
+#define ZONE_COMPILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Reads RFC 1035 master files and writes the image described in zone_image.h.
+// Offline only (zonec), so it is written for clarity rather than speed.
+//
+// Supported:  $ORIGIN, $TTL, $INCLUDE, parentheses, comments, quoted strings,
+// \X and \DDD escapes, blank and @ owners, relative names, TTL units (1h30m),
+// and A, AAAA, NS, CNAME, PTR, MX, TXT, SOA, SRV plus RFC 3597 generic
+// TYPEnnn \# rdata.  Each master file is one zone, its apex being the owner of
+// its SOA.
+
+class zone_compiler {
+public:
+
+  zone_compiler();
+  virtual ~zone_compiler();
+
+  // sOrigin (presentation format) may be empty when the file sets $ORIGIN
+  bool AddMasterFile( const std::string& sPath, const std::string& sOrigin, std::string& sError );
+
+  bool WriteImage( const std::string& sPath, std::string& sError );
+
+  std::size_t zones() const { return m_vZone.size(); }
+  std::size_t records() const { return m_nRecords; }
+
+protected:
+private:
+
+  typedef std::string wire_t; // uncompressed wire format name, or rdata octets
+
+  struct rrset_t {
+    uint16_t rrclass;
+    uint32_t ttl;
+    std::vector<wire_t> vRData;
+  };
+
+  struct node_t {
+    wire_t name;   // as first seen
+    std::map<uint16_t, rrset_t> mapRRset; // by type
+  };
+
+  typedef std::map<std::string, node_t> mapNode_t; // by image key
+  mapNode_t m_mapNode;
+
+  std::vector<std::string> m_vZone; // apex keys
+
+  std::size_t m_nRecords;
+
+  struct state_t; // per master file, while parsing
+
+  bool ParseFile( const std::string& sPath, state_t&, std::string& sError );
+  bool ParseRecord( const std::vector<std::string>& vToken, bool bOwner, state_t&, std::string& sError );
+  bool Finish( state_t&, std::string& sError );
+
+  static std::string Key( const wire_t& name );
+  static std::string Parent( const std::string& key );  // key less its last label
+  static wire_t Wire( const std::string& key );
+};
+
+#endif /* ZONE_COMPILER_H */